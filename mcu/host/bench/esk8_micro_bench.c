@@ -0,0 +1,541 @@
+#include <esk8_err.h>
+#include <esk8_uart.h>
+#include <esk8_ps2.h>
+#include <esk8_ps2_priv.h>
+#include <esk8_ble_apps.h>
+#include <esk8_ble_apps_util.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * Micro benchmarks for the per byte and per
+ * frame hot paths of lib/uart, lib/ps2 and lib/ble.
+ * Each bench is calibrated to run for about
+ * BENCH_TARGET_NS, then timed BENCH_REPS times,
+ * and the fastest run is kept.
+ *
+ *   $ esk8_micro_bench [-f filter] [-j out.json] [-c base.json [-s]] [-t pct]
+ *
+ * With `-c`, exits with 1 if any bench is more than
+ * `pct` percent, and BENCH_NOISE_NS, slower than the
+ * baseline, or allocates more per op than it did.
+ * Baselines only hold on the machine they were
+ * recorded on. With `-s`, a missing baseline skips
+ * the run instead of failing it.
+ **/
+
+#define BENCH_TARGET_NS     20000000ull
+#define BENCH_CALIB_NS      2000000ull
+#define BENCH_REPS          25
+#define BENCH_TOLERANCE     25.0
+#define BENCH_NOISE_NS      1.0     /* Code alignment alone moves the tiny ones this much */
+#define BENCH_MAX           32
+
+
+/* Keeps the compiler from dropping results nobody reads */
+#define bench_keep(x)       __asm__ volatile ("" : : "g"(x) : "memory")
+
+
+/**
+ * Heap accounting, the same way as esk8_uart_bench.
+ **/
+static unsigned long bench_allocs = 0;
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t n, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void  __real_free(void* ptr);
+
+void* __wrap_malloc(size_t size)            { bench_allocs++; return __real_malloc(size);      }
+void* __wrap_calloc(size_t n, size_t size)  { bench_allocs++; return __real_calloc(n, size);   }
+void* __wrap_realloc(void* ptr, size_t size){ bench_allocs++; return __real_realloc(ptr, size); }
+void  __wrap_free(void* ptr)                { if (ptr) bench_allocs++; __real_free(ptr);       }
+
+
+static uint64_t
+bench_now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+
+/**
+ * Inputs shared by the benches, built once.
+ **/
+#define BENCH_NOISE_LEN     1024
+#define BENCH_ATTR_NUM      16
+#define BENCH_CONN_NUM      4
+
+static uint8_t  bench_reply[ESK8_MSG_SIZE(2) + 2];
+static size_t   bench_reply_len;
+static uint8_t  bench_big[ESK8_MSG_MAX_SIZE];
+static uint8_t  bench_noise[BENCH_NOISE_LEN];
+
+static uint16_t            bench_attr_hndl[BENCH_ATTR_NUM];
+static esk8_ble_conn_ctx_t bench_conn_ctx[BENCH_CONN_NUM];
+static esk8_ble_app_t      bench_app = {
+    .app_name        = "bench",
+    .attr_num        = BENCH_ATTR_NUM,
+    ._attr_hndl_list = bench_attr_hndl,
+    ._conn_ctx_list  = bench_conn_ctx,
+};
+
+/* Normally owned by esk8_ble_apps.c, which needs the whole BLE stack */
+esk8_ble_apps_t esk8_ble_apps = {
+    .conn_num_max = BENCH_CONN_NUM,
+};
+
+static void
+bench_setup()
+{
+    /* A 2 byte BMS reply, with some line noise in front */
+    uint8_t pld[2] = { 0x34, 0x12 };
+    esk8_uart_msg_t rsp = {
+        .pld_length  = sizeof(pld),
+        .src_address = ESK8_ADDR_BMS,
+        .dst_address = ESK8_ADDR_APP,
+        .cmd_command = ESK8_MSG_CMD_READ_RSP,
+        .cmd_argment = ESK8_REG_BMS_VOLTAGE,
+        .payload     = pld
+    };
+
+    bench_reply[0] = 0x00;
+    bench_reply[1] = 0xA5;
+    bench_reply_len = 2 + esk8_uart_msg_encode(&rsp, bench_reply + 2, sizeof(bench_reply) - 2);
+
+    for (int i = 0; i < sizeof(bench_big); i++)
+        bench_big[i] = i * 7;
+
+    /* No 0x5A in the noise, the header sits at its very end */
+    for (int i = 0; i < BENCH_NOISE_LEN; i++)
+        bench_noise[i] = (i * 13) % 0x50;
+
+    bench_noise[BENCH_NOISE_LEN - 2] = 0x5A;
+    bench_noise[BENCH_NOISE_LEN - 1] = 0xA5;
+
+    for (int i = 0; i < BENCH_ATTR_NUM; i++)
+        bench_attr_hndl[i] = 40 + i;
+
+    for (int i = 0; i < BENCH_CONN_NUM; i++)
+        bench_conn_ctx[i].conn_id = i;
+}
+
+
+/**
+ * Benches. Each runs `n` ops.
+ **/
+static void
+bench_chk_calc_16(uint64_t n)
+{
+    uint8_t chk[2];
+    for (uint64_t i = 0; i < n; i++)
+    {
+        esk8_uart_buff_chk_calc(bench_big, 16, chk);
+        bench_keep(chk[0]);
+    }
+}
+
+static void
+bench_chk_calc_max(uint64_t n)
+{
+    uint8_t chk[2];
+    for (uint64_t i = 0; i < n; i++)
+    {
+        esk8_uart_buff_chk_calc(bench_big, sizeof(bench_big), chk);
+        bench_keep(chk[0]);
+    }
+}
+
+static void
+bench_msg_view(uint64_t n)
+{
+    esk8_uart_msg_t msg;
+    for (uint64_t i = 0; i < n; i++)
+    {
+        esk8_err_t err = esk8_uart_msg_view(bench_reply, bench_reply_len, &msg, NULL);
+        bench_keep(err);
+    }
+}
+
+static void
+bench_msg_parse(uint64_t n)
+{
+    esk8_uart_msg_t msg;
+    for (uint64_t i = 0; i < n; i++)
+    {
+        if (esk8_uart_msg_parse(bench_reply, bench_reply_len, &msg) == ESK8_OK)
+            esk8_uart_msg_free(msg);
+    }
+}
+
+static void
+bench_msg_encode(uint64_t n)
+{
+    uint8_t pld[2] = { 0x34, 0x12 };
+    uint8_t buff[ESK8_MSG_SIZE(2)];
+    esk8_uart_msg_t msg = {
+        .pld_length  = sizeof(pld),
+        .src_address = ESK8_ADDR_BMS,
+        .dst_address = ESK8_ADDR_APP,
+        .cmd_command = ESK8_MSG_CMD_READ_RSP,
+        .cmd_argment = ESK8_REG_BMS_VOLTAGE,
+        .payload     = pld
+    };
+
+    for (uint64_t i = 0; i < n; i++)
+    {
+        size_t len = esk8_uart_msg_encode(&msg, buff, sizeof(buff));
+        bench_keep(len);
+    }
+}
+
+static void
+bench_regread_encode(uint64_t n)
+{
+    uint8_t buff[ESK8_MSG_SIZE(1)];
+    for (uint64_t i = 0; i < n; i++)
+    {
+        size_t len = esk8_uart_regread_encode(ESK8_ADDR_BMS,
+            ESK8_REG_BMS_VOLTAGE, 2, buff, sizeof(buff));
+        bench_keep(len);
+    }
+}
+
+static void
+bench_dec_feed(uint64_t n)
+{
+    static esk8_uart_dec_t dec;
+    esk8_uart_msg_t msg;
+
+    esk8_uart_dec_reset(&dec);
+
+    for (uint64_t i = 0; i < n; i++)
+    {
+        size_t off = 0;
+        while (off < bench_reply_len)
+        {
+            size_t used = 0;
+            esk8_err_t err = esk8_uart_dec_feed(&dec,
+                bench_reply + off, bench_reply_len - off, &used, &msg);
+
+            off += used;
+            bench_keep(err);
+        }
+    }
+}
+
+static void
+bench_find_header_1k(uint64_t n)
+{
+    for (uint64_t i = 0; i < n; i++)
+    {
+        int idx = esk8_uart_msg_find_header(bench_noise, BENCH_NOISE_LEN);
+        bench_keep(idx);
+    }
+}
+
+static void
+bench_ps2_get_parity(uint64_t n)
+{
+    for (uint64_t i = 0; i < n; i++)
+    {
+        int p = esk8_ps2_get_parity((uint8_t)i);
+        bench_keep(p);
+    }
+}
+
+static void
+bench_ps2_set_bit(uint64_t n)
+{
+    uint8_t byte = 0;
+    for (uint64_t i = 0; i < n; i++)
+    {
+        esk8_ps2_set_bit(&byte, i & 7, i & 8);
+        bench_keep(byte);
+    }
+}
+
+static void
+bench_ble_get_attr_idx(uint64_t n)
+{
+    for (uint64_t i = 0; i < n; i++)
+    {
+        int idx;
+        esk8_err_t err = esk8_ble_apps_get_attr_idx(&bench_app,
+            bench_attr_hndl[BENCH_ATTR_NUM - 1], &idx);
+        bench_keep(err);
+        bench_keep(idx);
+    }
+}
+
+static void
+bench_ble_get_ctx(uint64_t n)
+{
+    for (uint64_t i = 0; i < n; i++)
+    {
+        esk8_ble_conn_ctx_t* ctx;
+        esk8_err_t err = esk8_ble_apps_get_ctx(&bench_app, BENCH_CONN_NUM - 1, &ctx);
+        bench_keep(err);
+        bench_keep(ctx);
+    }
+}
+
+
+typedef struct
+{
+    const char* name;
+    void      (*run)(uint64_t n);
+}
+bench_t;
+
+static const bench_t bench_list[] = {
+    { "uart/chk_calc/16",       bench_chk_calc_16       },
+    { "uart/chk_calc/max",      bench_chk_calc_max      },
+    { "uart/msg_view",          bench_msg_view          },
+    { "uart/msg_parse",         bench_msg_parse         },
+    { "uart/msg_encode",        bench_msg_encode        },
+    { "uart/regread_encode",    bench_regread_encode    },
+    { "uart/dec_feed",          bench_dec_feed          },
+    { "uart/find_header/1k",    bench_find_header_1k    },
+    { "ps2/get_parity",         bench_ps2_get_parity    },
+    { "ps2/set_bit",            bench_ps2_set_bit       },
+    { "ble/get_attr_idx",       bench_ble_get_attr_idx  },
+    { "ble/get_ctx",            bench_ble_get_ctx       },
+};
+
+#define BENCH_NUM (sizeof(bench_list) / sizeof(bench_list[0]))
+
+typedef struct
+{
+    char   name[48];
+    double ns_op;
+    double allocs_op;
+}
+bench_res_t;
+
+
+static void
+bench_measure(
+    const bench_t* bench,
+    bench_res_t*   res
+)
+{
+    /* Grow `n` until a run is long enough to time */
+    uint64_t n = 64;
+    uint64_t dt;
+
+    for (;;)
+    {
+        uint64_t t0 = bench_now_ns();
+        bench->run(n);
+        dt = bench_now_ns() - t0;
+
+        if (dt >= BENCH_CALIB_NS)
+            break;
+
+        n *= 4;
+    }
+
+    n = n * BENCH_TARGET_NS / dt + 1;
+
+    double best = -1;
+
+    for (int r = 0; r < BENCH_REPS; r++)
+    {
+        bench_allocs = 0;
+
+        uint64_t t0 = bench_now_ns();
+        bench->run(n);
+        dt = bench_now_ns() - t0;
+
+        double ns_op = (double)dt / n;
+        if (best < 0 || ns_op < best)
+            best = ns_op;
+    }
+
+    snprintf(res->name, sizeof(res->name), "%s", bench->name);
+    res->ns_op     = best;
+    res->allocs_op = (double)bench_allocs / n;
+}
+
+
+/**
+ * Baselines are written one bench per line,
+ * so they read back with a plain sscanf.
+ **/
+static int
+bench_save(
+    const char*        path,
+    const bench_res_t* res,
+    int                n_res
+)
+{
+    FILE* f = fopen(path, "w");
+    if (!f)
+        return -1;
+
+    fprintf(f, "{\n  \"benches\": [\n");
+
+    for (int i = 0; i < n_res; i++)
+        fprintf(f, "    { \"name\": \"%s\", \"ns_op\": %.2f, \"allocs_op\": %.2f }%s\n",
+            res[i].name, res[i].ns_op, res[i].allocs_op,
+            i + 1 < n_res ? "," : ""
+        );
+
+    fprintf(f, "  ]\n}\n");
+    return fclose(f);
+}
+
+static int
+bench_load(
+    const char*  path,
+    bench_res_t* res,
+    int          max_res
+)
+{
+    FILE* f = fopen(path, "r");
+    if (!f)
+        return -1;
+
+    int n_res = 0;
+    char line[256];
+
+    while (n_res < max_res && fgets(line, sizeof(line), f))
+    {
+        bench_res_t* r = &res[n_res];
+
+        if  (
+                sscanf(line, " { \"name\": \"%47[^\"]\", \"ns_op\": %lf, \"allocs_op\": %lf",
+                    r->name, &r->ns_op, &r->allocs_op) == 3
+            )
+            n_res++;
+    }
+
+    fclose(f);
+    return n_res;
+}
+
+
+static void
+usage(
+    const char* argv0
+)
+{
+    fprintf(stderr,
+        "usage: %s [-f filter] [-j out.json] [-c base.json [-s]] [-t pct]\n"
+        "  -f  only run benches whose name contains `filter`\n"
+        "  -j  save the results as a baseline\n"
+        "  -c  compare against a baseline, exit 1 on a regression\n"
+        "  -s  skip, and exit 0, if that baseline was never recorded\n"
+        "  -t  allowed slow down in percent, default %.0f\n",
+        argv0, BENCH_TOLERANCE
+    );
+}
+
+int
+main(
+    int    argc,
+    char** argv
+)
+{
+    const char* filter    = NULL;
+    const char* json_out  = NULL;
+    const char* json_base = NULL;
+    double      tolerance = BENCH_TOLERANCE;
+    int         skip_none = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "f:j:c:t:sh")) != -1)
+    {
+        switch (opt)
+        {
+            case 'f': filter    = optarg;       break;
+            case 'j': json_out  = optarg;       break;
+            case 'c': json_base = optarg;       break;
+            case 't': tolerance = atof(optarg); break;
+            case 's': skip_none = 1;            break;
+            default:
+                usage(argv[0]);
+                return 2;
+        }
+    }
+
+    bench_res_t base[BENCH_MAX];
+    int n_base = 0;
+
+    if (json_base)
+    {
+        n_base = bench_load(json_base, base, BENCH_MAX);
+        if (n_base < 0 && errno == ENOENT && skip_none)
+        {
+            printf("No baseline at %s, skipping. Record one on this machine first.\n", json_base);
+            return 0;
+        }
+
+        if (n_base < 0)
+        {
+            fprintf(stderr, "Can't read baseline %s\n", json_base);
+            return 2;
+        }
+    }
+
+    bench_setup();
+
+    bench_res_t res[BENCH_NUM];
+    int n_res = 0;
+    int n_regressed = 0;
+
+    for (int i = 0; i < BENCH_NUM; i++)
+    {
+        if (filter && !strstr(bench_list[i].name, filter))
+            continue;
+
+        bench_res_t* r = &res[n_res++];
+        bench_measure(&bench_list[i], r);
+
+        printf("%-24s %10.2f ns/op %6.2f allocs/op", r->name, r->ns_op, r->allocs_op);
+
+        const bench_res_t* b = NULL;
+        for (int j = 0; j < n_base; j++)
+            if (!strcmp(base[j].name, r->name))
+                b = &base[j];
+
+        if (b)
+        {
+            double delta = (r->ns_op / b->ns_op - 1.0) * 100.0;
+            int slower   = delta > tolerance && r->ns_op - b->ns_op > BENCH_NOISE_NS;
+            int heavier  = r->allocs_op > b->allocs_op + 0.005;
+
+            printf("  %+7.1f%%%s%s", delta,
+                slower  ? "  SLOWER"   : "",
+                heavier ? "  ALLOCS"   : ""
+            );
+
+            n_regressed += slower || heavier;
+        }
+
+        printf("\n");
+    }
+
+    if (json_out && bench_save(json_out, res, n_res))
+    {
+        fprintf(stderr, "Can't write %s\n", json_out);
+        return 2;
+    }
+
+    if (n_regressed)
+    {
+        fprintf(stderr, "%d bench(es) regressed against %s\n", n_regressed, json_base);
+        return 1;
+    }
+
+    return 0;
+}
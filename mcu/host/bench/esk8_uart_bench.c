@@ -0,0 +1,155 @@
+#include <esk8_err.h>
+#include <esk8_uart.h>
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_ITERATIONS 1000000
+
+
+/**
+ * Heap accounting. The bench is linked with
+ * `--wrap` for the allocator, so every heap
+ * call made by the code under test lands here.
+ **/
+static unsigned long bench_allocs = 0;
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t n, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void  __real_free(void* ptr);
+
+void* __wrap_malloc(size_t size)            { bench_allocs++; return __real_malloc(size);      }
+void* __wrap_calloc(size_t n, size_t size)  { bench_allocs++; return __real_calloc(n, size);   }
+void* __wrap_realloc(void* ptr, size_t size){ bench_allocs++; return __real_realloc(ptr, size); }
+void  __wrap_free(void* ptr)                { if (ptr) bench_allocs++; __real_free(ptr);       }
+
+
+static uint64_t
+bench_now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/**
+ * A 2 byte register reply, as a BMS would
+ * send it back, with some line noise in front.
+ **/
+static size_t
+bench_make_reply(
+    uint8_t* buff,
+    size_t   buff_len
+)
+{
+    uint8_t pld[2] = { 0x34, 0x12 };
+    esk8_uart_msg_t rsp = {
+        .pld_length = sizeof(pld),
+        .src_address = ESK8_ADDR_BMS,
+        .dst_address = ESK8_ADDR_APP,
+        .cmd_command = 0x01,
+        .cmd_argment = ESK8_REG_BMS_VOLTAGE,
+        .payload = pld
+    };
+
+    buff[0] = 0x00;
+    buff[1] = 0xA5;
+    return 2 + esk8_uart_msg_encode(&rsp, buff + 2, buff_len - 2);
+}
+
+/**
+ * One register read, the way `get_data_with_response`
+ * used to do it.
+ **/
+static uint16_t
+bench_trx_alloc(
+    uint8_t* rsp_buf,
+    size_t   rsp_len
+)
+{
+    uint16_t val = 0;
+    esk8_uart_msg_t msg;
+    esk8_uart_msg_t rsp;
+
+    esk8_uart_regread_msg_new(ESK8_ADDR_BMS, ESK8_REG_BMS_VOLTAGE, 2, &msg);
+
+    size_t   msgLen = esk8_uart_msg_get_serialized_length(msg);
+    uint8_t* msgBuf = malloc(msgLen);
+    esk8_uart_msg_serialize(msg, msgBuf);
+    free(msgBuf);
+
+    if (esk8_uart_msg_parse(rsp_buf, rsp_len, &rsp) == ESK8_OK)
+    {
+        memcpy(&val, rsp.payload, 2);
+        esk8_uart_msg_free(rsp);
+    }
+
+    esk8_uart_msg_free(msg);
+    return val;
+}
+
+/**
+ * One register read with the caller owned
+ * buffer codec.
+ **/
+static uint16_t
+bench_trx_noalloc(
+    uint8_t* rsp_buf,
+    size_t   rsp_len
+)
+{
+    uint16_t val = 0;
+    uint8_t  req_buf[ESK8_MSG_SIZE(1)];
+    esk8_uart_msg_t rsp;
+
+    esk8_uart_regread_encode(ESK8_ADDR_BMS, ESK8_REG_BMS_VOLTAGE, 2,
+        req_buf, sizeof(req_buf));
+
+    if (esk8_uart_msg_view(rsp_buf, rsp_len, &rsp, NULL) == ESK8_OK)
+        memcpy(&val, rsp.payload, 2);
+
+    return val + req_buf[ESK8_MSG_SIZE(1) - 1];
+}
+
+static void
+bench_run(
+    const char* name,
+    uint16_t  (*trx)(uint8_t*, size_t),
+    uint8_t*    rsp_buf,
+    size_t      rsp_len
+)
+{
+    volatile uint16_t sink = 0;
+
+    bench_allocs = 0;
+    uint64_t t0 = bench_now_ns();
+
+    for (int i = 0; i < BENCH_ITERATIONS; i++)
+        sink += trx(rsp_buf, rsp_len);
+
+    uint64_t t1 = bench_now_ns();
+
+    printf("%-24s %8.1f ns/trx %8.2f heap ops/trx\n",
+        name,
+        (double)(t1 - t0) / BENCH_ITERATIONS,
+        (double)bench_allocs / BENCH_ITERATIONS
+    );
+
+    (void) sink;
+}
+
+int
+main()
+{
+    uint8_t rsp_buf[ESK8_MSG_SIZE(2) + 2];
+    size_t  rsp_len = bench_make_reply(rsp_buf, sizeof(rsp_buf));
+
+    bench_run("regread (malloc codec)", bench_trx_alloc,   rsp_buf, rsp_len);
+    bench_run("regread (frame codec)",  bench_trx_noalloc, rsp_buf, rsp_len);
+
+    return 0;
+}
@@ -0,0 +1,303 @@
+#include <esk8_config.h>
+#include <esk8_bms_fields.h>
+#include <esk8_bms_utils.h>
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GEN_MAX_PLANS   64
+#define GEN_MAX_BYTES   (64 * 1024)
+
+/**
+ * Writes `lib/bms/esk8_bms_plans.c`: the read
+ * plans of every mask `ESK8_BMS_FIELD_MASK()`
+ * can make, planned here by the firmware's own
+ * `esk8_bms_plan_fields()`, as const data the
+ * worker reads straight from flash. The file
+ * checks, at compile time, that the field table
+ * and the plan limits it was made from still
+ * hold, and fails the build once they don't.
+ *
+ *   $ esk8_bms_plan_gen out.c
+ *   $ esk8_bms_plan_gen -c esk8_bms_plans.c
+ *
+ * `-c` exits with 1 if the file differs from
+ * what would be written now.
+ **/
+
+static const char* gen_names[ESK8_BMS_FIELD_MAX] = {
+#define GEN_NAME(name, dst, field, reg, width, refresh, ...) \
+    [ESK8_BMS_FIELD_##name] = #name,
+
+    ESK8_BMS_FIELD_TABLE(GEN_NAME)
+
+#undef GEN_NAME
+};
+
+static const char* gen_dsts[] = {
+    [ESK8_BMS_DST_STATUS] = "ESK8_BMS_DST_STATUS",
+    [ESK8_BMS_DST_DEEP]   = "ESK8_BMS_DST_DEEP",
+    [ESK8_BMS_DST_ALL]    = "ESK8_BMS_DST_ALL",
+};
+
+static const char* gen_refreshes[] = {
+    "FAST", "MEDIUM", "SLOW", "ONCE"
+};
+
+typedef struct
+{
+    uint8_t         dsts;
+    uint8_t         refreshes;
+    esk8_bms_plan_t plan;
+}
+gen_plan_t;
+
+
+static int
+gen_cmp_plan(
+    const void* a,
+    const void* b
+)
+{
+    esk8_bms_field_mask_t ma = ((const gen_plan_t*)a)->plan.mask;
+    esk8_bms_field_mask_t mb = ((const gen_plan_t*)b)->plan.mask;
+
+    return ma < mb ? -1 : ma > mb;
+}
+
+/**
+ * The mask of `dsts` and `refreshes`, as
+ * `ESK8_BMS_FIELD_MASK()` builds it.
+ **/
+static esk8_bms_field_mask_t
+gen_mask(
+    uint8_t dsts,
+    uint8_t refreshes
+)
+{
+    esk8_bms_field_mask_t mask = 0;
+
+    for (int f = 0; f < ESK8_BMS_FIELD_MAX; f++)
+    {
+        if ((esk8_bms_fields[f].dst & dsts) && (esk8_bms_fields[f].refresh & refreshes))
+            mask |= (esk8_bms_field_mask_t)1 << f;
+    }
+
+    return mask;
+}
+
+/**
+ * Every distinct mask, each under the first
+ * destination and refresh classes giving it.
+ **/
+static int
+gen_plans(
+    gen_plan_t* plans
+)
+{
+    int n_plans = 0;
+
+    for (uint8_t d = 1; d <= ESK8_BMS_DST_ALL; d++)
+    {
+        for (uint8_t r = 1; r <= ESK8_BMS_REFRESH_ALL; r++)
+        {
+            esk8_bms_field_mask_t mask = gen_mask(d, r);
+            bool seen = !mask;
+
+            for (int i = 0; !seen && i < n_plans; i++)
+                seen = plans[i].plan.mask == mask;
+
+            if (seen || n_plans == GEN_MAX_PLANS)
+                continue;
+
+            plans[n_plans].dsts      = d;
+            plans[n_plans].refreshes = r;
+            esk8_bms_plan_fields(mask, &plans[n_plans].plan);
+            n_plans++;
+        }
+    }
+
+    qsort(plans, n_plans, sizeof(gen_plan_t), gen_cmp_plan);
+    return n_plans;
+}
+
+static int
+gen_refresh_expr(
+    char*   out,
+    size_t  len,
+    uint8_t refreshes
+)
+{
+    int n = 0;
+
+    for (int i = 0; i < 4; i++)
+    {
+        if (refreshes & (1 << i))
+            n += snprintf(out + n, len - n, "%sESK8_BMS_REFRESH_%s",
+                n ? " | " : "", gen_refreshes[i]);
+    }
+
+    return n;
+}
+
+static int
+gen_write(
+    char*   out,
+    size_t  len
+)
+{
+    gen_plan_t plans[GEN_MAX_PLANS];
+    int n_plans = gen_plans(plans);
+    int n = 0;
+
+#define OUT(...) (n += snprintf(out + n, n < len ? len - n : 0, __VA_ARGS__))
+
+    OUT("/* Generated by mcu/host/bms_plan/esk8_bms_plan_gen.c, do not edit. */\n"
+        "/* Run the `bms_plans` host target once the field table or the plan limits change. */\n"
+        "#include <esk8_config.h>\n"
+        "#include <esk8_bms_fields.h>\n"
+        "#include <esk8_bms_utils.h>\n"
+        "\n"
+        "\n"
+        "#if ESK8_UART_BMS_PLAN_MAX_GAP != %d || ESK8_UART_BMS_PLAN_MAX_READ != %d\n"
+        "#error \"BMS read plans were made with other limits, run the bms_plans host target\"\n"
+        "#endif\n"
+        "\n"
+        "_Static_assert(\n"
+        "    ESK8_BMS_FIELD_MAX == %d,\n"
+        "    \"BMS read plans were made from another field table, run the bms_plans host target\");\n"
+        "\n",
+        ESK8_UART_BMS_PLAN_MAX_GAP, ESK8_UART_BMS_PLAN_MAX_READ, ESK8_BMS_FIELD_MAX);
+
+    OUT("/* Every field as planned, by register, width, destination and refresh class */\n"
+        "#define PLAN_CHECK(name, dst, field, reg, width, refresh, ...) \\\n"
+        "    _Static_assert( \\\n"
+        "        (reg) == PLAN_REG_##name && (width) == PLAN_WIDTH_##name && \\\n"
+        "        ESK8_BMS_DST_##dst == PLAN_DST_##name && ESK8_BMS_REFRESH_##refresh == PLAN_REFRESH_##name, \\\n"
+        "        \"BMS field \" #name \" changed since the read plans were made, run the bms_plans host target\");\n"
+        "\n");
+
+    for (int f = 0; f < ESK8_BMS_FIELD_MAX; f++)
+    {
+        const esk8_bms_field_t* field = &esk8_bms_fields[f];
+
+        OUT("#define PLAN_REG_%s 0x%02X\n",     gen_names[f], field->reg);
+        OUT("#define PLAN_WIDTH_%s %d\n",       gen_names[f], field->width);
+        OUT("#define PLAN_DST_%s %d\n",         gen_names[f], field->dst);
+        OUT("#define PLAN_REFRESH_%s %d\n",     gen_names[f], field->refresh);
+    }
+
+    OUT("\n"
+        "ESK8_BMS_FIELD_TABLE(PLAN_CHECK)\n"
+        "\n"
+        "\n"
+        "const esk8_bms_plan_t\n"
+        "esk8_bms_plans[] = {\n");
+
+    for (int i = 0; i < n_plans; i++)
+    {
+        const esk8_bms_plan_t* plan = &plans[i].plan;
+        char refresh_expr[128];
+
+        gen_refresh_expr(refresh_expr, sizeof(refresh_expr), plans[i].refreshes);
+
+        OUT("    /* %s, %s */\n", gen_dsts[plans[i].dsts], refresh_expr);
+        OUT("    {\n");
+        OUT("        .mask     = 0x%08X,\n", (unsigned)plan->mask);
+        OUT("        .n_ranges = %d,\n", plan->n_ranges);
+        OUT("        .fields   = {");
+
+        for (int j = 0; j < plan->ranges[plan->n_ranges - 1].first + plan->ranges[plan->n_ranges - 1].num; j++)
+            OUT("%s\n            ESK8_BMS_FIELD_%s", j ? "," : "", gen_names[plan->fields[j]]);
+
+        OUT("\n        },\n");
+        OUT("        .ranges   = {\n");
+
+        for (int r = 0; r < plan->n_ranges; r++)
+        {
+            const esk8_bms_range_t* range = &plan->ranges[r];
+
+            OUT("            { .reg = 0x%02X, .size = %2d, .first = %2d, .num = %2d },\n",
+                range->reg, range->size, range->first, range->num);
+        }
+
+        OUT("        },\n");
+        OUT("    },\n");
+    }
+
+    OUT("};\n"
+        "\n"
+        "const uint8_t\n"
+        "esk8_bms_plans_num = sizeof(esk8_bms_plans) / sizeof(esk8_bms_plans[0]);\n"
+        "\n");
+
+    for (int i = 0; i < n_plans; i++)
+    {
+        char refresh_expr[128];
+
+        gen_refresh_expr(refresh_expr, sizeof(refresh_expr), plans[i].refreshes);
+
+        OUT("_Static_assert(ESK8_BMS_FIELD_MASK(%s, %s) == 0x%08X, \"Stale BMS read plan\");\n",
+            gen_dsts[plans[i].dsts], refresh_expr, (unsigned)plans[i].plan.mask);
+    }
+
+#undef OUT
+
+    return n;
+}
+
+int
+main(
+    int    argc,
+    char** argv
+)
+{
+    bool check = argc == 3 && !strcmp(argv[1], "-c");
+
+    if (argc != 2 && !check)
+    {
+        fprintf(stderr, "usage: %s out.c | -c esk8_bms_plans.c\n", argv[0]);
+        return 2;
+    }
+
+    const char* path = argv[argc - 1];
+    char* out = malloc(GEN_MAX_BYTES);
+    int n = gen_write(out, GEN_MAX_BYTES);
+
+    if (n >= GEN_MAX_BYTES)
+    {
+        fprintf(stderr, "Plans do not fit in %d bytes\n", GEN_MAX_BYTES);
+        return 2;
+    }
+
+    if (check)
+    {
+        char* old = malloc(GEN_MAX_BYTES);
+        FILE* f = fopen(path, "r");
+        size_t n_old = f ? fread(old, 1, GEN_MAX_BYTES, f) : 0;
+
+        if (f)
+            fclose(f);
+
+        if (n_old != n || memcmp(old, out, n))
+        {
+            fprintf(stderr, "%s is stale, run the bms_plans target\n", path);
+            return 1;
+        }
+
+        printf("%s is up to date\n", path);
+        return 0;
+    }
+
+    FILE* f = fopen(path, "w");
+
+    if (!f || fwrite(out, 1, n, f) != n || fclose(f))
+    {
+        perror(path);
+        return 2;
+    }
+
+    return 0;
+}
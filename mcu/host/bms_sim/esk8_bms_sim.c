@@ -0,0 +1,303 @@
+#include <esk8_bms_sim.h>
+#include <esk8_uart.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SIM_CMD_READ        0x01
+#define SIM_CMD_READ_RSP    0x04
+
+
+static uint32_t
+sim_rand(
+    esk8_bms_sim_t* sim
+)
+{
+    /* xorshift32, good enough to roll fault dice */
+    uint32_t x = sim->rng;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    return sim->rng = x;
+}
+
+static bool
+sim_roll(
+    esk8_bms_sim_t* sim,
+    float           rate
+)
+{
+    if (rate <= 0)
+        return false;
+
+    return (sim_rand(sim) >> 8) < rate * (1 << 24);
+}
+
+static void
+sim_set_str(
+    esk8_bms_sim_pack_t* pack,
+    uint8_t              reg,
+    const char*          str,
+    size_t               len
+)
+{
+    memcpy((uint8_t*)&pack->regs[reg], str, len);
+}
+
+/**
+ * A 10S pack, a little over half full,
+ * discharging. Values drift a bit per pack
+ * so mixed up packs show up in the data.
+ **/
+static void
+sim_pack_defaults(
+    esk8_bms_sim_pack_t* pack,
+    int                  idx
+)
+{
+    char serial[15];
+    snprintf(serial, sizeof(serial), "3GCAS1900%04d%d", 1234 + idx, idx % 10);
+
+    memset(pack->regs, 0, sizeof(pack->regs));
+
+    sim_set_str(pack, ESK8_REG_BMS_SERIAL_NUMBER, serial, 14);
+    pack->regs[ESK8_REG_BMS_FW_VERSION]         = 0x0115;
+    pack->regs[ESK8_REG_BMS_FACTORY_CAPACITY]   = 7800;
+    pack->regs[ESK8_REG_BMS_ACTUAL_CAPACITY]    = 7600 - idx * 50;
+    pack->regs[ESK8_REG_BMS_CHARGE_FULL_CYCLES] = 40 + idx;
+    pack->regs[ESK8_REG_BMS_CHARGE_COUNT]       = 120 + idx;
+    pack->regs[ESK8_REG_BMS_MANUFACTURE_DATE]   = (19 << 9) | (6 << 5) | (12 + idx);
+
+    pack->regs[ESK8_REG_BMS_CAPACITY_mAh]       = 5200 - idx * 10;
+    pack->regs[ESK8_REG_BMS_CAPACITY]           = 68 - idx;
+    pack->regs[ESK8_REG_BMS_CURRENT]            = (uint16_t)(int16_t)(-350 - idx);
+    pack->regs[ESK8_REG_BMS_VOLTAGE]            = 3890 + idx;
+    pack->regs[ESK8_REG_BMS_TEMPRTR]            = ((44 + idx) << 8) | (45 + idx);
+    pack->regs[ESK8_REG_BMS_HEALTH]             = 96 - idx;
+
+    for (int c = 0; c < 10; c++)
+        pack->regs[ESK8_REG_BMS_CELL0_V + c] = 3885 + idx * 3 + c;
+}
+
+void
+esk8_bms_sim_init(
+    esk8_bms_sim_t* sim,
+    int             pack_num,
+    uint32_t        seed
+)
+{
+    memset(sim, 0, sizeof(*sim));
+
+    sim->pack_num = pack_num < ESK8_BMS_SIM_MAX_PACKS ? pack_num : ESK8_BMS_SIM_MAX_PACKS;
+    sim->byte_us  = ESK8_BMS_SIM_BYTE_US;
+    sim->rng      = seed ? seed : 0x2545F491;
+
+    for (int i = 0; i < sim->pack_num; i++)
+    {
+        esk8_bms_sim_pack_t* pack = &sim->packs[i];
+
+        pack->fault = ESK8_BMS_SIM_FAULT_NONE();
+        pack->addr  = ESK8_ADDR_BMS;
+        esk8_uart_dec_reset(&pack->dec);
+        sim_pack_defaults(pack, i);
+    }
+}
+
+void
+esk8_bms_sim_make_esc(
+    esk8_bms_sim_t* sim,
+    int             pack_idx
+)
+{
+    esk8_bms_sim_pack_t* pack = &sim->packs[pack_idx];
+
+    memset(pack->regs, 0, sizeof(pack->regs));
+
+    pack->addr = ESK8_ADDR_ESC;
+    pack->regs[ESK8_REG_ESC_CURRENT]    = 1240;
+    pack->regs[ESK8_REG_ESC_BATTERY]    = 67;
+    pack->regs[ESK8_REG_ESC_SPEED]      = 18500;
+    pack->regs[ESK8_REG_ESC_AVG_SPEED]  = 16200;
+    pack->regs[ESK8_REG_ESC_ODOMETER]   = 41250;
+    pack->regs[ESK8_REG_ESC_TRIP]       = 312;
+    pack->regs[ESK8_REG_ESC_UPTIME]     = 1870;
+    pack->regs[ESK8_REG_ESC_TEMPRTR]    = 384;
+}
+
+void
+esk8_bms_sim_read(
+    const esk8_bms_sim_t*   sim,
+    int                     pack,
+    uint8_t                 reg,
+    void*                   out,
+    size_t                  size
+)
+{
+    const uint8_t* regs = (const uint8_t*)sim->packs[pack].regs;
+    size_t off = reg * 2;
+
+    if (off + size > sizeof(sim->packs[pack].regs))
+        size = sizeof(sim->packs[pack].regs) - off;
+
+    memcpy(out, regs + off, size);
+}
+
+/**
+ * Answers one decoded request, or does not,
+ * depending on the faults of `pack`.
+ **/
+static void
+sim_reply(
+    esk8_bms_sim_t*         sim,
+    int                     pack_idx,
+    const esk8_uart_msg_t*  req,
+    uint32_t                req_us,
+    esk8_bms_sim_tx_t       tx,
+    void*                   ctx
+)
+{
+    esk8_bms_sim_pack_t* pack = &sim->packs[pack_idx];
+    esk8_bms_sim_fault_t* fault = &pack->fault;
+
+    if  (
+            req->dst_address != pack->addr ||
+            req->cmd_command != SIM_CMD_READ ||
+            req->pld_length != 1
+        )
+    {
+        pack->stats.n_ignored++;
+        return;
+    }
+
+    pack->stats.n_req++;
+
+    if (sim_roll(sim, fault->silent_rate))
+    {
+        pack->stats.n_silent++;
+        return;
+    }
+
+    uint8_t pld[ESK8_MSG_MAX_PLD_SIZE];
+    uint8_t size = req->payload[0];
+
+    esk8_bms_sim_read(sim, pack_idx, req->cmd_argment, pld, size);
+
+    esk8_uart_msg_t rsp = {
+        .pld_length  = size,
+        .src_address = pack->addr,
+        .dst_address = req->src_address,
+        .cmd_command = SIM_CMD_READ_RSP,
+        .cmd_argment = req->cmd_argment,
+        .payload     = pld
+    };
+
+    if (sim_roll(sim, fault->wrong_addr_rate))
+    {
+        rsp.src_address = pack->addr == ESK8_ADDR_BMS ? ESK8_ADDR_ESC : ESK8_ADDR_BMS;
+        pack->stats.n_wrong_addr++;
+    }
+
+    uint8_t frame[ESK8_MSG_MAX_SIZE];
+    size_t frame_len = esk8_uart_msg_encode(&rsp, frame, sizeof(frame));
+
+    if (sim_roll(sim, fault->bad_chk_rate))
+    {
+        frame[frame_len - 1] ^= 0x5A;
+        pack->stats.n_bad_chk++;
+    }
+
+    /* Lost bytes still take their time on the wire */
+    size_t sent = 0;
+    for (size_t i = 0; i < frame_len; i++)
+    {
+        if (sim_roll(sim, fault->drop_byte_rate))
+        {
+            pack->stats.n_dropped++;
+            continue;
+        }
+
+        frame[sent++] = frame[i];
+    }
+
+    uint32_t delay_us = req_us + fault->latency_us + frame_len * sim->byte_us;
+
+    if (fault->jitter_us)
+        delay_us += sim_rand(sim) % fault->jitter_us;
+
+    pack->stats.n_rsp++;
+    tx(pack_idx, frame, sent, delay_us, ctx);
+}
+
+void
+esk8_bms_sim_feed(
+    esk8_bms_sim_t*     sim,
+    int                 pack_idx,
+    const uint8_t*      data,
+    size_t              len,
+    esk8_bms_sim_tx_t   tx,
+    void*               ctx
+)
+{
+    if (pack_idx < 0 || pack_idx >= sim->pack_num)
+        return;
+
+    esk8_bms_sim_pack_t* pack = &sim->packs[pack_idx];
+
+    if (!pack->fault.present)
+        return;
+
+    if (pack->fault.echo)
+        tx(pack_idx, data, len, len * sim->byte_us, ctx);
+
+    size_t off = 0;
+    while (1)
+    {
+        size_t used;
+        esk8_uart_msg_t req;
+
+        esk8_err_t err = esk8_uart_dec_feed(
+            &pack->dec,
+            data + off,
+            len - off,
+            &used,
+            &req);
+
+        off += used;
+
+        if (err != ESK8_OK)
+            break;
+
+        sim_reply(sim, pack_idx, &req, ESK8_MSG_SIZE(req.pld_length) * sim->byte_us, tx, ctx);
+    }
+}
+
+bool
+esk8_bms_sim_fault_parse(
+    esk8_bms_sim_fault_t*   fault,
+    const char*             opt
+)
+{
+    const char* eq = strchr(opt, '=');
+    const char* val = eq ? eq + 1 : "1";
+    size_t key_len = eq ? (size_t)(eq - opt) : strlen(opt);
+
+#define SIM_KEY(name) (key_len == strlen(name) && !strncmp(opt, name, key_len))
+
+    if      (SIM_KEY("absent"))     fault->present          = !atoi(val);
+    else if (SIM_KEY("echo"))       fault->echo             = atoi(val);
+    else if (SIM_KEY("latency"))    fault->latency_us       = strtoul(val, NULL, 0);
+    else if (SIM_KEY("jitter"))     fault->jitter_us        = strtoul(val, NULL, 0);
+    else if (SIM_KEY("drop"))       fault->drop_byte_rate   = atof(val);
+    else if (SIM_KEY("badchk"))     fault->bad_chk_rate     = atof(val);
+    else if (SIM_KEY("wrongaddr"))  fault->wrong_addr_rate  = atof(val);
+    else if (SIM_KEY("silent"))     fault->silent_rate      = atof(val);
+    else
+        return false;
+
+#undef SIM_KEY
+
+    return true;
+}
@@ -0,0 +1,155 @@
+#ifndef _ESK8_BMS_SIM_H
+#define _ESK8_BMS_SIM_H
+
+/**
+ * Virtual Ninebot BMSs, for testing the
+ * firmware without packs on the bench.
+ * Requests are fed in as raw bytes, and
+ * replies come out of a callback along with
+ * when they should show up on the wire.
+ * The sim knows nothing about the transport,
+ * see `esk8_bms_sim_uart.h` and the pty tool.
+ **/
+
+#include <esk8_uart.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define ESK8_BMS_SIM_MAX_PACKS  8
+#define ESK8_BMS_SIM_REG_NUM    0x100
+#define ESK8_BMS_SIM_BYTE_US    87      /* One 8N1 byte at 115200 baud */
+
+
+/**
+ * How badly a pack behaves.
+ * Rates are probabilities, 0 to 1.
+ **/
+typedef struct
+{
+    bool        present;            /* Absent packs never answer            */
+    bool        echo;               /* Echo requests back, like one wire    */
+    uint32_t    latency_us;         /* Before the first byte of a reply     */
+    uint32_t    jitter_us;          /* Random extra latency, up to this     */
+    float       drop_byte_rate;     /* Each reply byte may be lost          */
+    float       bad_chk_rate;       /* Reply with a broken checksum         */
+    float       wrong_addr_rate;    /* Reply as if from another device      */
+    float       silent_rate;        /* Do not reply at all                  */
+}
+esk8_bms_sim_fault_t;
+
+#define ESK8_BMS_SIM_FAULT_NONE() \
+    ((esk8_bms_sim_fault_t){ .present = true, .latency_us = 1000 })
+
+typedef struct
+{
+    uint32_t    n_req;              /* Requests addressed to the pack       */
+    uint32_t    n_rsp;              /* Replies sent, broken or not          */
+    uint32_t    n_silent;
+    uint32_t    n_bad_chk;
+    uint32_t    n_wrong_addr;
+    uint32_t    n_dropped;          /* Reply bytes lost                     */
+    uint32_t    n_ignored;          /* Frames not meant for the pack        */
+}
+esk8_bms_sim_stats_t;
+
+typedef struct
+{
+    esk8_bms_sim_fault_t    fault;
+    esk8_bms_sim_stats_t    stats;
+    uint8_t                 addr;       /* Answers to, `ESK8_ADDR_BMS` by default */
+
+    /* Little endian words, as on the wire */
+    uint16_t                regs[ESK8_BMS_SIM_REG_NUM];
+    esk8_uart_dec_t         dec;
+}
+esk8_bms_sim_pack_t;
+
+typedef struct
+{
+    int                     pack_num;
+    esk8_bms_sim_pack_t     packs[ESK8_BMS_SIM_MAX_PACKS];
+    uint32_t                byte_us;    /* Wire time of a byte  */
+    uint32_t                rng;
+}
+esk8_bms_sim_t;
+
+/**
+ * Called with each byte string the sim puts
+ * on the wire. `delay_us` is how long after
+ * the request it should arrive, including
+ * the wire time of request and reply.
+ **/
+typedef void (*esk8_bms_sim_tx_t)(
+    int             pack,
+    const uint8_t*  data,
+    size_t          len,
+    uint32_t        delay_us,
+    void*           ctx
+);
+
+
+/**
+ * Sets up `pack_num` healthy packs, each with
+ * its own plausible register values.
+ * `seed` makes the fault dice repeatable.
+ **/
+void
+esk8_bms_sim_init(
+    esk8_bms_sim_t* sim,
+    int             pack_num,
+    uint32_t        seed
+);
+
+/**
+ * Turns `pack` into an ESC riding at a steady
+ * speed, answering on `ESK8_ADDR_ESC`, so ESC
+ * and BMS traffic can share a sim.
+ **/
+void
+esk8_bms_sim_make_esc(
+    esk8_bms_sim_t* sim,
+    int             pack
+);
+
+/**
+ * Feeds bytes the firmware sent to `pack`.
+ * Every complete request gets `tx` called,
+ * unless a fault eats the reply.
+ **/
+void
+esk8_bms_sim_feed(
+    esk8_bms_sim_t*     sim,
+    int                 pack,
+    const uint8_t*      data,
+    size_t              len,
+    esk8_bms_sim_tx_t   tx,
+    void*               ctx
+);
+
+/**
+ * Copies `size` bytes of registers of `pack`,
+ * starting at `reg`, as a read would return them.
+ **/
+void
+esk8_bms_sim_read(
+    const esk8_bms_sim_t*   sim,
+    int                     pack,
+    uint8_t                 reg,
+    void*                   out,
+    size_t                  size
+);
+
+/**
+ * Parses a fault option like `latency=2000`
+ * or `drop=0.01` into `fault`. Returns false
+ * if the option is not known.
+ **/
+bool
+esk8_bms_sim_fault_parse(
+    esk8_bms_sim_fault_t*   fault,
+    const char*             opt
+);
+
+#endif /* _ESK8_BMS_SIM_H */
@@ -0,0 +1,673 @@
+#include <esk8_config.h>
+#include <esk8_err.h>
+#include <esk8_bms.h>
+#include <esk8_bms_fields.h>
+#include <esk8_esc.h>
+#include <esk8_uart_bus.h>
+#include <esk8_bms_sim.h>
+#include <esk8_bms_sim_uart.h>
+
+#include <driver/uart.h>
+#include <esp_timer.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#define BENCH_PACKS         4
+#define BENCH_MAX_SLOTS     ESK8_UART_BMS_REQ_QUEUE_LEN
+#define BENCH_MAX_SAMPLES   (1 << 20)
+#define BENCH_DOWN_RETRY_MS 20      /* A pack that is down is asked again after this */
+#define BENCH_ERR_NUM       128
+#define BENCH_MASTER_MS     25      /* The other master asks a pack this often, in turns */
+
+/**
+ * Drives the real BMS worker, UART port and
+ * codec against virtual packs, one scenario at
+ * a time, and reports transactions per second
+ * and latency from submit to callback:
+ *
+ *   $ esk8_bms_sim_bench [-d ms] [-o outstanding] [-a] [scenario]...
+ *
+ * `-a` reads every field instead of the fast
+ * and medium ones. Each scenario runs in its
+ * own process. Bus use of every client follows
+ * the results. Last, a request per slot is
+ * queued and the BMS lib stopped, which has to
+ * call each of them back.
+ **/
+
+typedef struct
+{
+    const char* name;
+    bool        two_ports;      /* Packs 2 and 3 on their own UART and TX pin */
+    bool        esc;            /* An ESC polled at 20 Hz on the packs' UART  */
+    bool        sniff;          /* Another master polls the packs, listen to it */
+    uint32_t    period_ms;      /* Ask each slot this often, 0 for back to back */
+    int         fault_pack;     /* -1 for every pack */
+    const char* faults;         /* Comma separated, see `esk8_bms_sim_fault_parse` */
+}
+bench_scenario_t;
+
+static const bench_scenario_t bench_scenarios[] = {
+    { "clean",      false,  false,  false,  0,      -1, ""                          },
+    { "two-ports",  true,   false,  false,  0,      -1, ""                          },
+    { "esc-shared", false,  true,   false,  0,      -1, ""                          },
+    { "esc-slow",   false,  true,   false,  0,      -1, "latency=5000,jitter=5000"  },
+    { "paced",      false,  false,  false,  200,    -1, ""                          },
+    { "sniff",      false,  false,  true,   200,    -1, ""                          },
+    { "echo",       false,  false,  false,  0,      -1, "echo"                      },
+    { "slow",       false,  false,  false,  0,      -1, "latency=5000,jitter=5000"  },
+    { "drops",      false,  false,  false,  0,      -1, "drop=0.002"                },
+    { "badchk",     false,  false,  false,  0,      -1, "badchk=0.05"               },
+    { "wrongaddr",  false,  false,  false,  0,      -1, "wrongaddr=0.05"            },
+    { "silent",     false,  false,  false,  0,      1,  "silent=0.2"                },
+    { "dead-pack",  false,  false,  false,  0,      3,  "absent"                    },
+};
+
+#define BENCH_SCENARIO_NUM (sizeof(bench_scenarios) / sizeof(bench_scenarios[0]))
+
+typedef struct
+{
+    esk8_bms_req_t          req;
+    esk8_bms_status_t       status;
+    esk8_bms_deep_status_t  deep;
+
+    int64_t                 submit_us;
+    int64_t                 retry_us;
+    volatile int            done;
+    esk8_err_t              err;
+    uint32_t                lat_us;
+    uint32_t                bus_us;
+}
+bench_slot_t;
+
+typedef struct
+{
+    esk8_bms_sim_t*         sim;
+    int                     pack;   /* Index in `sim` */
+}
+bench_pack_t;
+
+static TaskHandle_t         bench_task;
+static bench_pack_t         bench_packs[BENCH_PACKS];
+static bench_slot_t         bench_slots[BENCH_PACKS][BENCH_MAX_SLOTS];
+
+static uint32_t*            bench_lat;
+static uint32_t             bench_lat_num;
+static uint64_t             bench_bus_us;
+static uint32_t             bench_errs[BENCH_ERR_NUM];
+static uint32_t             bench_mismatch;
+
+static uint32_t             bench_esc_polls;
+static uint32_t             bench_esc_ok;
+static int64_t              bench_esc_last_us;
+static uint32_t             bench_esc_gap_max_us;   /* Longest stretch without fresh telemetry */
+
+static esk8_bms_sim_uart_t* bench_master_bus;
+static uint32_t             bench_master_reqs;
+
+
+static void
+bench_cb(
+    const esk8_bms_req_t*   req,
+    esk8_err_t              err
+)
+{
+    bench_slot_t* slot = (bench_slot_t*)req->ctx;
+
+    slot->err    = err;
+    slot->lat_us = esp_timer_get_time() - slot->submit_us;
+    slot->bus_us = req->bus_us;
+
+    __atomic_store_n(&slot->done, 1, __ATOMIC_RELEASE);
+    xTaskNotifyGive(bench_task);
+}
+
+static void
+bench_esc_cb(
+    const esk8_esc_telemetry_t* telemetry,
+    esk8_err_t                  err,
+    void*                       ctx
+)
+{
+    int64_t now_us = esp_timer_get_time();
+
+    bench_esc_polls++;
+
+    if (err)
+        return;
+
+    if (bench_esc_last_us && now_us - bench_esc_last_us > bench_esc_gap_max_us)
+        bench_esc_gap_max_us = now_us - bench_esc_last_us;
+
+    bench_esc_last_us = now_us;
+    bench_esc_ok++;
+}
+
+static void
+bench_submit(
+    esk8_bms_hndl_t hndl,
+    bench_slot_t*   slot
+)
+{
+    slot->done      = 0;
+    slot->submit_us = esp_timer_get_time();
+
+    esk8_err_t err = esk8_bms_submit(hndl, &slot->req);
+
+    if (err)
+    {
+        slot->err    = err;
+        slot->lat_us = 0;
+        slot->done   = 1;
+    }
+}
+
+/**
+ * Whether the values read for `slot` are
+ * the ones the virtual pack holds.
+ **/
+static bool
+bench_check(
+    const bench_slot_t* slot
+)
+{
+    const bench_pack_t* bp = &bench_packs[slot->req.pack];
+    uint16_t voltage;
+    uint16_t cells[10];
+
+    esk8_bms_sim_read(bp->sim, bp->pack, ESK8_REG_BMS_VOLTAGE, &voltage, sizeof(voltage));
+    esk8_bms_sim_read(bp->sim, bp->pack, ESK8_REG_BMS_CELL0_V, cells, sizeof(cells));
+
+    if (slot->status.voltage != voltage)
+        return false;
+
+    if  (
+            (slot->req.fields & ESK8_BMS_FIELD_BIT(CELL_VOLTAGES)) &&
+            memcmp(slot->deep.cellVoltage_mV, cells, sizeof(cells))
+        )
+        return false;
+
+    return true;
+}
+
+static void
+bench_record(
+    bench_slot_t* slot
+)
+{
+    if (slot->err < BENCH_ERR_NUM)
+        bench_errs[slot->err]++;
+
+    if (slot->err == ESK8_BMS_ERR_PACK_DOWN || slot->err == ESK8_BMS_ERR_QUEUE_FULL)
+        return;
+
+    if (slot->err == ESK8_OK && !bench_check(slot))
+        bench_mismatch++;
+
+    if (bench_lat_num < BENCH_MAX_SAMPLES)
+    {
+        bench_lat[bench_lat_num++] = slot->lat_us;
+        bench_bus_us += slot->bus_us;
+    }
+}
+
+static int
+bench_cmp_u32(
+    const void* a,
+    const void* b
+)
+{
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+
+    return (x > y) - (x < y);
+}
+
+static uint32_t
+bench_pct(
+    double pct
+)
+{
+    if (!bench_lat_num)
+        return 0;
+
+    uint32_t idx = pct / 100.0 * (bench_lat_num - 1) + 0.5;
+    return bench_lat[idx];
+}
+
+static void
+bench_apply_faults(
+    esk8_bms_sim_fault_t*   fault,
+    const char*             faults
+)
+{
+    char buff[128];
+    snprintf(buff, sizeof(buff), "%s", faults);
+
+    for (char* opt = strtok(buff, ","); opt; opt = strtok(NULL, ","))
+    {
+        if (!esk8_bms_sim_fault_parse(fault, opt))
+            fprintf(stderr, "unknown fault: %s\n", opt);
+    }
+}
+
+/**
+ * A stock controller, reading capacity to
+ * health of each pack in turn, but never
+ * the cell voltages or the identity.
+ **/
+static void
+bench_master_task(
+    void* param
+)
+{
+    uint8_t req[ESK8_MSG_SIZE(1)];
+    size_t req_len = esk8_uart_regread_encode(
+        ESK8_ADDR_BMS, ESK8_REG_BMS_CAPACITY_mAh,
+        (ESK8_REG_BMS_HEALTH - ESK8_REG_BMS_CAPACITY_mAh + 1) * 2,
+        req, sizeof(req)
+    );
+
+    TickType_t last_wake = xTaskGetTickCount();
+
+    for (int pack = 0; ; pack = (pack + 1) % BENCH_PACKS)
+    {
+        esk8_bms_sim_uart_master(bench_master_bus, pack, req, req_len);
+        bench_master_reqs++;
+
+        vTaskDelayUntil(&last_wake, BENCH_MASTER_MS / portTICK_PERIOD_MS);
+    }
+}
+
+/**
+ * Clients on the bus of `uart_port`,
+ * removed ones at the end not counted.
+ **/
+static uint8_t
+bench_client_num(
+    int uart_port
+)
+{
+    esk8_uart_bus_hndl_t bus;
+
+    if (esk8_uart_bus_open(uart_port, 0, 0, 0, 0, &bus))
+        return 0;
+
+    uint8_t n = esk8_uart_bus_client_num(bus);
+
+    esk8_uart_bus_close(bus);
+    return n;
+}
+
+/**
+ * Prints how much of the run each client of
+ * the bus on `uart_port` held the bus, and
+ * how long it waited for it.
+ **/
+static void
+bench_print_bus(
+    int uart_port
+)
+{
+    esk8_uart_bus_hndl_t bus;
+
+    /* Already open, this only shares it */
+    if (esk8_uart_bus_open(uart_port, 0, 0, 0, 0, &bus))
+        return;
+
+    int64_t now_us = esp_timer_get_time();
+
+    for (uint8_t c = 0; c < esk8_uart_bus_client_num(bus); c++)
+    {
+        esk8_uart_bus_stats_t stats;
+
+        /* A slot left by a removed client */
+        if (esk8_uart_bus_get_stats(bus, c, &stats))
+            continue;
+
+        printf("%10s uart%d %-5s %5.1f%% busy %5.1f%% listen %7u trx, wait avg %5u max %6u us, %u missed\n", "",
+            uart_port, stats.name,
+            100.0 * stats.busy_us / (now_us - stats.since_us),
+            100.0 * stats.listen_us / (now_us - stats.since_us),
+            (unsigned)stats.n_trx,
+            (unsigned)(stats.n_trx ? stats.wait_us / stats.n_trx : 0),
+            (unsigned)stats.wait_max_us,
+            (unsigned)stats.n_missed);
+    }
+
+    esk8_uart_bus_close(bus);
+}
+
+static int
+bench_run(
+    const bench_scenario_t* scn,
+    uint32_t                duration_ms,
+    int                     outstanding,
+    esk8_bms_field_mask_t   fields
+)
+{
+    static esk8_bms_sim_t       sims[2];
+    static esk8_bms_sim_uart_t  buses[2];
+
+    uint8_t rx_pins[BENCH_PACKS + 1] = { GPIO_NUM_27, GPIO_NUM_26, GPIO_NUM_25, GPIO_NUM_33, GPIO_NUM_16 };
+    uint8_t tx_pins[BENCH_PACKS] = { GPIO_NUM_14, GPIO_NUM_14, GPIO_NUM_14, GPIO_NUM_14 };
+    int     ports[BENCH_PACKS]   = { UART_NUM_1,  UART_NUM_1,  UART_NUM_1,  UART_NUM_1  };
+
+    if (scn->two_ports)
+    {
+        tx_pins[2] = tx_pins[3] = GPIO_NUM_12;
+        ports[2]   = ports[3]   = UART_NUM_2;
+
+        esk8_bms_sim_init(&sims[0], 2, 1);
+        esk8_bms_sim_init(&sims[1], 2, 2);
+
+        for (int p = 0; p < BENCH_PACKS; p++)
+            bench_packs[p] = (bench_pack_t){ &sims[p / 2], p % 2 };
+
+        esk8_bms_sim_uart_attach(&buses[0], &sims[0], UART_NUM_1, &rx_pins[0]);
+        esk8_bms_sim_uart_attach(&buses[1], &sims[1], UART_NUM_2, &rx_pins[2]);
+    }
+    else
+    {
+        esk8_bms_sim_init(&sims[0], BENCH_PACKS + scn->esc, 1);
+
+        for (int p = 0; p < BENCH_PACKS; p++)
+            bench_packs[p] = (bench_pack_t){ &sims[0], p };
+
+        /* The ESC is one more device on the mux, after the packs */
+        if (scn->esc)
+            esk8_bms_sim_make_esc(&sims[0], BENCH_PACKS);
+
+        esk8_bms_sim_uart_attach(&buses[0], &sims[0], UART_NUM_1, rx_pins);
+    }
+
+    for (int p = 0; p < BENCH_PACKS; p++)
+    {
+        if (scn->fault_pack < 0 || scn->fault_pack == p)
+            bench_apply_faults(&bench_packs[p].sim->packs[bench_packs[p].pack].fault, scn->faults);
+    }
+
+    esk8_bms_config_t bms_cnfg = {
+        .uart_port      = UART_NUM_1,
+        .uart_ports     = ports,
+        .bat_num        = BENCH_PACKS,
+        .rx_pins        = rx_pins,
+        .tx_pins        = tx_pins,
+        .bms_update_ms  = ESK8_UART_BMS_UPDATE_MS,
+        .sniff          = scn->sniff,
+    };
+
+    esk8_bms_hndl_t hndl;
+    esk8_err_t err = esk8_bms_init(&bms_cnfg, &hndl);
+
+    if (err)
+    {
+        fprintf(stderr, "%s: init failed: %s\n", scn->name, esk8_err_to_str(err));
+        return 1;
+    }
+
+    esk8_esc_hndl_t esc_hndl = NULL;
+    uint8_t bms_clients = bench_client_num(UART_NUM_1);
+
+    if (scn->esc)
+    {
+        esk8_esc_config_t esc_cnfg = {
+            .uart_port  = UART_NUM_1,
+            .tx_pin     = tx_pins[0],
+            .rx_pin     = rx_pins[BENCH_PACKS],
+            .poll_ms    = ESK8_UART_ESC_POLL_MS,
+            .timeout_ms = ESK8_UART_ESC_TIMEOUT_MS,
+            .wheel_mm   = ESK8_ESC_WHEEL_MM,
+            .cb         = bench_esc_cb,
+        };
+
+        err = esk8_esc_init(&esc_cnfg, &esc_hndl);
+
+        if (err)
+        {
+            fprintf(stderr, "%s: esc init failed: %s\n", scn->name, esk8_err_to_str(err));
+            return 1;
+        }
+    }
+
+    if (scn->sniff)
+    {
+        bench_master_bus = &buses[0];
+        xTaskCreate(bench_master_task, "master", 0, NULL, 0, NULL);
+    }
+
+    bench_task = xTaskGetCurrentTaskHandle();
+    bench_lat  = malloc(BENCH_MAX_SAMPLES * sizeof(uint32_t));
+
+    for (int p = 0; p < BENCH_PACKS; p++)
+    {
+        for (int s = 0; s < outstanding; s++)
+        {
+            bench_slot_t* slot = &bench_slots[p][s];
+
+            slot->req = (esk8_bms_req_t){
+                .pack        = p,
+                .fields      = fields,
+                .status      = &slot->status,
+                .deep_status = &slot->deep,
+                .cb          = bench_cb,
+                .ctx         = slot,
+            };
+
+            bench_submit(hndl, slot);
+        }
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    int64_t end_us   = start_us + duration_ms * 1000ll;
+    uint32_t trx     = 0;
+    int pending      = BENCH_PACKS * outstanding;
+
+    /* Keep `outstanding` requests per pack until time is up, then drain */
+    while (pending)
+    {
+        int64_t now_us = esp_timer_get_time();
+        bool running = now_us < end_us;
+
+        if (now_us > end_us + 2000000ll)
+        {
+            fprintf(stderr, "%s: %d requests never completed\n", scn->name, pending);
+            break;
+        }
+
+        ulTaskNotifyTake(pdTRUE, 5);
+        now_us = esp_timer_get_time();
+
+        for (int p = 0; p < BENCH_PACKS; p++)
+        {
+            for (int s = 0; s < outstanding; s++)
+            {
+                bench_slot_t* slot = &bench_slots[p][s];
+
+                if (__atomic_load_n(&slot->done, __ATOMIC_ACQUIRE) != 1)
+                    continue;
+
+                if (slot->retry_us == 0)
+                {
+                    bench_record(slot);
+                    trx++;
+
+                    slot->retry_us = now_us;
+                    if (slot->submit_us + scn->period_ms * 1000 > now_us)
+                        slot->retry_us = slot->submit_us + scn->period_ms * 1000;
+                    if (slot->err == ESK8_BMS_ERR_PACK_DOWN || slot->err == ESK8_BMS_ERR_QUEUE_FULL)
+                        slot->retry_us += BENCH_DOWN_RETRY_MS * 1000;
+                }
+
+                if (!running)
+                {
+                    slot->done = 2;
+                    pending--;
+                    continue;
+                }
+
+                if (now_us >= slot->retry_us)
+                {
+                    slot->retry_us = 0;
+                    bench_submit(hndl, slot);
+                }
+            }
+        }
+    }
+
+    double secs = (esp_timer_get_time() - start_us) / 1e6;
+    uint32_t ok = bench_errs[ESK8_OK];
+    uint32_t bus_trx = bench_lat_num ? bench_lat_num : 1;
+
+    qsort(bench_lat, bench_lat_num, sizeof(uint32_t), bench_cmp_u32);
+
+    printf("%-10s %8.1f %8.1f %6.1f%% %8u %8u %8u %8u %8llu %6u\n",
+        scn->name,
+        trx / secs,
+        ok / secs,
+        trx ? 100.0 * ok / trx : 0.0,
+        bench_pct(50), bench_pct(99), bench_pct(99.9),
+        bench_lat_num ? bench_lat[bench_lat_num - 1] : 0,
+        (unsigned long long)(bench_bus_us / bus_trx),
+        bench_mismatch);
+
+    for (int e = 1; e < BENCH_ERR_NUM; e++)
+    {
+        if (bench_errs[e])
+            printf("%10s %8u x %s\n", "", bench_errs[e], esk8_err_to_str(e));
+    }
+
+    for (int p = 0; p < BENCH_PACKS; p++)
+    {
+        esk8_bms_health_t health;
+
+        if (esk8_bms_get_health(hndl, p, &health) == ESK8_OK && health.state != ESK8_BMS_LINK_CLOSED)
+            printf("%10s pack %d link %s, %u fast fails\n", "", p,
+                health.state == ESK8_BMS_LINK_OPEN ? "open" : "half open",
+                (unsigned)health.fast_fails);
+    }
+
+    if (scn->esc)
+        printf("%10s esc %u polls, %u ok, longest without telemetry %u us\n", "",
+            (unsigned)bench_esc_polls, (unsigned)bench_esc_ok, (unsigned)bench_esc_gap_max_us);
+
+    if (scn->sniff)
+        printf("%10s other master %u requests\n", "", (unsigned)bench_master_reqs);
+
+    bench_print_bus(UART_NUM_1);
+
+    if (scn->two_ports)
+        bench_print_bus(UART_NUM_2);
+
+    /* Its bus client has to go with it, or the slot stays taken */
+    if (esc_hndl)
+    {
+        esk8_esc_deinit(esc_hndl);
+
+        if (bench_client_num(UART_NUM_1) != bms_clients)
+        {
+            fprintf(stderr, "%s: esc client left on the bus\n", scn->name);
+            bench_mismatch++;
+        }
+    }
+
+    for (int p = 0; p < BENCH_PACKS; p++)
+    {
+        for (int s = 0; s < outstanding; s++)
+        {
+            if (bench_slots[p][s].done == 2)
+                bench_submit(hndl, &bench_slots[p][s]);
+        }
+    }
+
+    esk8_bms_deinit(hndl);
+
+    for (int p = 0; p < BENCH_PACKS; p++)
+    {
+        for (int s = 0; s < outstanding; s++)
+        {
+            if (__atomic_load_n(&bench_slots[p][s].done, __ATOMIC_ACQUIRE) == 0)
+            {
+                fprintf(stderr, "%s: pack %d request not called back on deinit\n", scn->name, p);
+                bench_mismatch++;
+            }
+        }
+    }
+
+    fflush(stdout);
+    return bench_mismatch ? 1 : 0;
+}
+
+int
+main(
+    int     argc,
+    char**  argv
+)
+{
+    uint32_t duration_ms = 2000;
+    int outstanding = 2;
+    esk8_bms_field_mask_t fields = ESK8_BMS_FIELD_MASK(
+        ESK8_BMS_DST_ALL,
+        ESK8_BMS_REFRESH_FAST | ESK8_BMS_REFRESH_MEDIUM
+    );
+    int opt;
+
+    while ((opt = getopt(argc, argv, "d:o:ah")) != -1)
+    {
+        switch (opt)
+        {
+            case 'd': duration_ms = strtoul(optarg, NULL, 0);   break;
+            case 'o': outstanding = atoi(optarg);               break;
+            case 'a': fields = ESK8_BMS_FIELDS_ALL;             break;
+            default:
+                fprintf(stderr, "usage: %s [-d ms] [-o outstanding] [-a] [scenario]...\n", argv[0]);
+                return 1;
+        }
+    }
+
+    if (outstanding < 1 || outstanding > BENCH_MAX_SLOTS)
+    {
+        fprintf(stderr, "outstanding must be 1 to %d\n", BENCH_MAX_SLOTS);
+        return 1;
+    }
+
+    printf("%d packs, %d outstanding each, fields 0x%04x, %u ms per scenario\n",
+        BENCH_PACKS, outstanding, (unsigned)fields, duration_ms);
+    printf("%-10s %8s %8s %7s %8s %8s %8s %8s %8s %6s\n",
+        "scenario", "trx/s", "ok/s", "ok", "p50 us", "p99 us", "p999 us", "max us", "bus us", "bad");
+    fflush(stdout);
+
+    int failed = 0;
+
+    for (size_t i = 0; i < BENCH_SCENARIO_NUM; i++)
+    {
+        const bench_scenario_t* scn = &bench_scenarios[i];
+        bool wanted = optind == argc;
+
+        for (int a = optind; a < argc; a++)
+            wanted |= !strcmp(argv[a], scn->name);
+
+        if (!wanted)
+            continue;
+
+        pid_t pid = fork();
+
+        if (pid == 0)
+            _exit(bench_run(scn, duration_ms, outstanding, fields));
+
+        int status;
+        waitpid(pid, &status, 0);
+
+        if (!WIFEXITED(status) || WEXITSTATUS(status))
+            failed++;
+    }
+
+    return failed ? 1 : 0;
+}
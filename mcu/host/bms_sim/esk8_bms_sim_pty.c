@@ -0,0 +1,266 @@
+#define _GNU_SOURCE
+
+#include <esk8_bms_sim.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <termios.h>
+
+#define PTY_PENDING 16
+
+
+/**
+ * Serves virtual BMSs over ptys, one per pack,
+ * for anything that talks to a serial port:
+ *
+ *   $ esk8_bms_sim_pty -n 2 -f 1:drop=0.01 -f latency=3000
+ *   pack 0: /dev/pts/5
+ *   pack 1: /dev/pts/6
+ *
+ * Faults given without a pack apply to all.
+ * Stats are printed on Ctrl-C.
+ **/
+
+typedef struct
+{
+    int64_t     due_us;
+    size_t      len;
+    uint8_t     data[ESK8_MSG_MAX_SIZE];
+}
+pty_rsp_t;
+
+typedef struct
+{
+    int         master;
+    int         slave;
+    pty_rsp_t   pending[PTY_PENDING];
+    int         pend_head;
+    int         pend_num;
+}
+pty_pack_t;
+
+static pty_pack_t pty_packs[ESK8_BMS_SIM_MAX_PACKS];
+static volatile sig_atomic_t pty_stop = 0;
+
+
+static int64_t
+pty_now_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000ll + ts.tv_nsec / 1000;
+}
+
+static void
+pty_on_sigint(
+    int sig
+)
+{
+    pty_stop = 1;
+}
+
+static void
+pty_queue(
+    int             pack,
+    const uint8_t*  data,
+    size_t          len,
+    uint32_t        delay_us,
+    void*           ctx
+)
+{
+    pty_pack_t* pty = &pty_packs[pack];
+
+    if (pty->pend_num == PTY_PENDING)
+        return;
+
+    pty_rsp_t* rsp = &pty->pending[(pty->pend_head + pty->pend_num++) % PTY_PENDING];
+
+    rsp->due_us = pty_now_us() + delay_us;
+    rsp->len    = len;
+    memcpy(rsp->data, data, len);
+}
+
+static int
+pty_open(
+    pty_pack_t* pty
+)
+{
+    struct termios tio;
+
+    pty->master = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if  (
+            pty->master < 0 ||
+            grantpt(pty->master) ||
+            unlockpt(pty->master)
+        )
+        return -1;
+
+    /* Hold the slave open, so the master does not see EIO between clients */
+    pty->slave = open(ptsname(pty->master), O_RDWR | O_NOCTTY);
+
+    if (pty->slave < 0 || tcgetattr(pty->slave, &tio))
+        return -1;
+
+    cfmakeraw(&tio);
+    cfsetspeed(&tio, B115200);
+
+    return tcsetattr(pty->slave, TCSANOW, &tio);
+}
+
+static void
+pty_usage(
+    const char* prog
+)
+{
+    fprintf(stderr,
+        "usage: %s [-n packs] [-s seed] [-f [pack:]fault]...\n"
+        "faults: absent echo latency=us jitter=us drop=rate\n"
+        "        badchk=rate wrongaddr=rate silent=rate\n",
+        prog);
+}
+
+int
+main(
+    int     argc,
+    char**  argv
+)
+{
+    static esk8_bms_sim_t sim;
+    int pack_num = 1;
+    uint32_t seed = 1;
+    int opt;
+
+    /* Faults wait until the pack count is known */
+    const char* faults[32];
+    int fault_num = 0;
+
+    while ((opt = getopt(argc, argv, "n:s:f:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n': pack_num = atoi(optarg);          break;
+            case 's': seed = strtoul(optarg, NULL, 0);  break;
+            case 'f':
+                if (fault_num < 32)
+                    faults[fault_num++] = optarg;
+                break;
+            default:
+                pty_usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (pack_num < 1 || pack_num > ESK8_BMS_SIM_MAX_PACKS)
+    {
+        fprintf(stderr, "packs must be 1 to %d\n", ESK8_BMS_SIM_MAX_PACKS);
+        return 1;
+    }
+
+    esk8_bms_sim_init(&sim, pack_num, seed);
+
+    for (int i = 0; i < fault_num; i++)
+    {
+        const char* colon = strchr(faults[i], ':');
+        const char* fault = colon ? colon + 1 : faults[i];
+        int first = colon ? atoi(faults[i]) : 0;
+        int last  = colon ? first : pack_num - 1;
+
+        for (int p = first; p <= last && p < pack_num; p++)
+        {
+            if (!esk8_bms_sim_fault_parse(&sim.packs[p].fault, fault))
+            {
+                fprintf(stderr, "unknown fault: %s\n", fault);
+                pty_usage(argv[0]);
+                return 1;
+            }
+        }
+    }
+
+    for (int p = 0; p < pack_num; p++)
+    {
+        if (pty_open(&pty_packs[p]))
+        {
+            perror("pty");
+            return 1;
+        }
+
+        printf("pack %d: %s\n", p, ptsname(pty_packs[p].master));
+    }
+
+    fflush(stdout);
+    signal(SIGINT, pty_on_sigint);
+    signal(SIGTERM, pty_on_sigint);
+
+    while (!pty_stop)
+    {
+        struct pollfd fds[ESK8_BMS_SIM_MAX_PACKS];
+        int64_t now_us = pty_now_us();
+        int timeout_ms = 100;
+
+        for (int p = 0; p < pack_num; p++)
+        {
+            pty_pack_t* pty = &pty_packs[p];
+
+            /* Send what is due, and sleep until the next reply is */
+            while (pty->pend_num && pty->pending[pty->pend_head].due_us <= now_us)
+            {
+                pty_rsp_t* rsp = &pty->pending[pty->pend_head];
+
+                if (write(pty->master, rsp->data, rsp->len) < 0 && errno != EAGAIN)
+                    perror("write");
+
+                pty->pend_head = (pty->pend_head + 1) % PTY_PENDING;
+                pty->pend_num--;
+            }
+
+            if (pty->pend_num)
+            {
+                int wait_ms = (pty->pending[pty->pend_head].due_us - now_us + 999) / 1000;
+
+                if (wait_ms < timeout_ms)
+                    timeout_ms = wait_ms;
+            }
+
+            fds[p].fd     = pty->master;
+            fds[p].events = POLLIN;
+        }
+
+        if (poll(fds, pack_num, timeout_ms) <= 0)
+            continue;
+
+        for (int p = 0; p < pack_num; p++)
+        {
+            uint8_t buff[256];
+
+            if (!(fds[p].revents & POLLIN))
+                continue;
+
+            ssize_t len = read(pty_packs[p].master, buff, sizeof(buff));
+
+            if (len > 0)
+                esk8_bms_sim_feed(&sim, p, buff, len, pty_queue, NULL);
+        }
+    }
+
+    printf("\n%-5s %8s %8s %8s %8s %8s %8s %8s\n",
+        "pack", "req", "rsp", "silent", "badchk", "wrongad", "dropped", "ignored");
+
+    for (int p = 0; p < pack_num; p++)
+    {
+        esk8_bms_sim_stats_t* st = &sim.packs[p].stats;
+
+        printf("%-5d %8u %8u %8u %8u %8u %8u %8u\n", p,
+            st->n_req, st->n_rsp, st->n_silent, st->n_bad_chk,
+            st->n_wrong_addr, st->n_dropped, st->n_ignored);
+    }
+
+    return 0;
+}
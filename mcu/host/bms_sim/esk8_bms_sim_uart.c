@@ -0,0 +1,203 @@
+#include <esk8_bms_sim.h>
+#include <esk8_bms_sim_uart.h>
+
+#include <driver/uart.h>
+#include <esp_timer.h>
+
+#include <string.h>
+#include <time.h>
+
+
+static void
+sim_uart_on_pins(
+    int     port,
+    int     tx_pin,
+    int     rx_pin,
+    void*   ctx
+)
+{
+    esk8_bms_sim_uart_t* bus = (esk8_bms_sim_uart_t*)ctx;
+
+    if (rx_pin == UART_PIN_NO_CHANGE)
+        return;
+
+    int selected = -1;
+    for (int i = 0; i < bus->sim->pack_num; i++)
+    {
+        if (bus->rx_pins[i] == rx_pin)
+            selected = i;
+    }
+
+    bus->selected = selected;
+}
+
+static void
+sim_uart_queue(
+    int             pack,
+    const uint8_t*  data,
+    size_t          len,
+    uint32_t        delay_us,
+    void*           ctx
+)
+{
+    esk8_bms_sim_uart_t* bus = (esk8_bms_sim_uart_t*)ctx;
+    int64_t due_us = esp_timer_get_time() + delay_us;
+
+    pthread_mutex_lock(&bus->mutex);
+
+    /* One wire, so replies can not overtake each other */
+    if (due_us < bus->last_due_us)
+        due_us = bus->last_due_us;
+
+    if (bus->pend_num < ESK8_BMS_SIM_UART_PENDING)
+    {
+        int idx = (bus->pend_head + bus->pend_num++) % ESK8_BMS_SIM_UART_PENDING;
+        esk8_bms_sim_uart_rsp_t* rsp = &bus->pending[idx];
+
+        rsp->due_us = due_us;
+        rsp->pack   = pack;
+        rsp->len    = len;
+        memcpy(rsp->data, data, len);
+
+        bus->last_due_us = due_us;
+        pthread_cond_signal(&bus->cond);
+    }
+
+    pthread_mutex_unlock(&bus->mutex);
+}
+
+static void
+sim_uart_on_tx(
+    int             port,
+    const uint8_t*  data,
+    size_t          len,
+    void*           ctx
+)
+{
+    esk8_bms_sim_uart_t* bus = (esk8_bms_sim_uart_t*)ctx;
+
+    pthread_mutex_lock(&bus->feed_mutex);
+    esk8_bms_sim_feed(bus->sim, bus->selected, data, len, sim_uart_queue, bus);
+    pthread_mutex_unlock(&bus->feed_mutex);
+}
+
+void
+esk8_bms_sim_uart_master(
+    esk8_bms_sim_uart_t*    bus,
+    int                     pack,
+    const uint8_t*          data,
+    size_t                  len
+)
+{
+    pthread_mutex_lock(&bus->feed_mutex);
+    esk8_bms_sim_feed(bus->sim, pack, data, len, sim_uart_queue, bus);
+    pthread_mutex_unlock(&bus->feed_mutex);
+}
+
+static void*
+sim_uart_deliver(
+    void* arg
+)
+{
+    esk8_bms_sim_uart_t* bus = (esk8_bms_sim_uart_t*)arg;
+
+    pthread_mutex_lock(&bus->mutex);
+
+    while (bus->running)
+    {
+        if (!bus->pend_num)
+        {
+            pthread_cond_wait(&bus->cond, &bus->mutex);
+            continue;
+        }
+
+        esk8_bms_sim_uart_rsp_t* rsp = &bus->pending[bus->pend_head];
+        int64_t now_us = esp_timer_get_time();
+
+        if (rsp->due_us > now_us)
+        {
+            struct timespec ts;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+
+            int64_t ns = ts.tv_nsec + (rsp->due_us - now_us) * 1000;
+            ts.tv_sec  += ns / 1000000000ll;
+            ts.tv_nsec  = ns % 1000000000ll;
+
+            pthread_cond_timedwait(&bus->cond, &bus->mutex, &ts);
+            continue;
+        }
+
+        esk8_bms_sim_uart_rsp_t out = *rsp;
+        bus->pend_head = (bus->pend_head + 1) % ESK8_BMS_SIM_UART_PENDING;
+        bus->pend_num--;
+
+        pthread_mutex_unlock(&bus->mutex);
+
+        /* The mux moved on while the pack was talking */
+        if (out.pack == bus->selected)
+            esk8_shim_uart_rx(bus->uart_port, out.data, out.len);
+        else
+            bus->n_lost++;
+
+        pthread_mutex_lock(&bus->mutex);
+    }
+
+    pthread_mutex_unlock(&bus->mutex);
+    return NULL;
+}
+
+int
+esk8_bms_sim_uart_attach(
+    esk8_bms_sim_uart_t*    bus,
+    esk8_bms_sim_t*         sim,
+    int                     uart_port,
+    const uint8_t*          rx_pins
+)
+{
+    pthread_condattr_t attr;
+
+    memset(bus, 0, sizeof(*bus));
+
+    bus->sim       = sim;
+    bus->uart_port = uart_port;
+    bus->selected  = -1;
+    bus->running   = true;
+
+    for (int i = 0; i < sim->pack_num; i++)
+        bus->rx_pins[i] = rx_pins[i];
+
+    pthread_mutex_init(&bus->feed_mutex, NULL);
+    pthread_mutex_init(&bus->mutex, NULL);
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&bus->cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    esk8_shim_uart_hooks_t hooks = {
+        .on_pins = sim_uart_on_pins,
+        .on_tx   = sim_uart_on_tx,
+        .ctx     = bus,
+    };
+
+    esk8_shim_uart_set_hooks(uart_port, &hooks);
+
+    return pthread_create(&bus->thread, NULL, sim_uart_deliver, bus);
+}
+
+void
+esk8_bms_sim_uart_detach(
+    esk8_bms_sim_uart_t* bus
+)
+{
+    esk8_shim_uart_set_hooks(bus->uart_port, NULL);
+
+    pthread_mutex_lock(&bus->mutex);
+    bus->running = false;
+    pthread_cond_signal(&bus->cond);
+    pthread_mutex_unlock(&bus->mutex);
+
+    pthread_join(bus->thread, NULL);
+    pthread_mutex_destroy(&bus->feed_mutex);
+    pthread_mutex_destroy(&bus->mutex);
+    pthread_cond_destroy(&bus->cond);
+}
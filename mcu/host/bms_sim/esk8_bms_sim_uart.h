@@ -0,0 +1,90 @@
+#ifndef _ESK8_BMS_SIM_UART_H
+#define _ESK8_BMS_SIM_UART_H
+
+/**
+ * Puts a `esk8_bms_sim_t` at the other end of
+ * a shimmed UART, so the real `lib/bms` and
+ * `lib/uart` code can talk to it in process.
+ * The pack answering is the one whose RX pin
+ * the UART is set to, like the pack mux on
+ * the board. Replies show up on the UART
+ * after the delay the sim asked for.
+ **/
+
+#include <esk8_bms_sim.h>
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ESK8_BMS_SIM_UART_PENDING 16
+
+
+typedef struct
+{
+    int64_t     due_us;
+    int         pack;
+    size_t      len;
+    uint8_t     data[ESK8_MSG_MAX_SIZE];
+}
+esk8_bms_sim_uart_rsp_t;
+
+typedef struct
+{
+    esk8_bms_sim_t*         sim;
+    int                     uart_port;
+    int                     rx_pins[ESK8_BMS_SIM_MAX_PACKS];
+    volatile int            selected;
+
+    pthread_t               thread;
+    pthread_mutex_t         feed_mutex; /* The firmware and other masters both talk */
+    pthread_mutex_t         mutex;
+    pthread_cond_t          cond;
+    bool                    running;
+
+    esk8_bms_sim_uart_rsp_t pending[ESK8_BMS_SIM_UART_PENDING];
+    int                     pend_head;
+    int                     pend_num;
+    int64_t                 last_due_us;
+    uint32_t                n_lost;     /* Replies to a pack no longer selected */
+}
+esk8_bms_sim_uart_t;
+
+
+/**
+ * Attaches `sim` to `uart_port`. Pack `i` of
+ * the sim answers while the UART RX pin is
+ * `rx_pins[i]`. Starts the delivery thread.
+ **/
+int
+esk8_bms_sim_uart_attach(
+    esk8_bms_sim_uart_t*    bus,
+    esk8_bms_sim_t*         sim,
+    int                     uart_port,
+    const uint8_t*          rx_pins
+);
+
+/**
+ * Sends `data` to `pack` as another master
+ * on the wire would, like a stock controller.
+ * The reply is only heard by the firmware if
+ * its UART is on the pack's RX pin by then.
+ **/
+void
+esk8_bms_sim_uart_master(
+    esk8_bms_sim_uart_t*    bus,
+    int                     pack,
+    const uint8_t*          data,
+    size_t                  len
+);
+
+/**
+ * Stops the delivery thread, and unhooks
+ * the UART. Pending replies are dropped.
+ **/
+void
+esk8_bms_sim_uart_detach(
+    esk8_bms_sim_uart_t*    bus
+);
+
+#endif /* _ESK8_BMS_SIM_UART_H */
@@ -0,0 +1,517 @@
+#include <esk8_err.h>
+#include <esk8_uart.h>
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define DUMP_OUT_BUFF_SIZE  (1 << 20)
+#define DUMP_COL_MAGIC      "ESK8REG1"
+
+/**
+ * Decodes a raw UART capture into register time series:
+ *
+ *   $ esk8_uart_dump [-b baud] [-o out] [-k] [-F] [-s addr] [-r reg]... capture
+ *
+ * Every valid read reply in the capture gives one row
+ * per register it carries, in CSV:
+ *
+ *   t_us,src,dst,reg,value
+ *
+ * Captures are raw bytes, so `t_us` is the wire time of
+ * the bytes before the frame at `-b` baud. It runs slow
+ * over idle gaps, but keeps the order and spacing of a
+ * busy bus.
+ *
+ * `-k` writes the rows as columns instead, for numpy and
+ * friends. All little endian:
+ *
+ *   char     magic[8]     "ESK8REG1"
+ *   uint64_t rows
+ *   uint64_t t_us[rows]
+ *   uint8_t  src[rows]
+ *   uint8_t  dst[rows]
+ *   uint8_t  reg[rows]
+ *   uint16_t value[rows]
+ *
+ * `-F` writes one CSV row per frame, of any command,
+ * with its payload in hex. `-s` and `-r` keep frames
+ * from one address, and the registers asked for.
+ * Counts and throughput go to stderr.
+ **/
+
+typedef struct
+{
+    uint64_t    rows;
+    uint64_t    cap;
+    uint64_t*   t_us;
+    uint8_t*    src;
+    uint8_t*    dst;
+    uint8_t*    reg;
+    uint16_t*   value;
+}
+dump_cols_t;
+
+typedef struct
+{
+    FILE*       out;
+    char*       buff;
+    size_t      len;
+}
+dump_out_t;
+
+typedef struct
+{
+    uint32_t    baud;
+    bool        columns;
+    bool        frames;
+    int         src;                /* -1 for any */
+    bool        any_reg;
+    uint8_t     regs[256 / 8];
+}
+dump_opts_t;
+
+typedef struct
+{
+    uint64_t    frames;
+    uint64_t    rows;
+    uint64_t    bad;                /* Headers that did not lead to a valid frame */
+}
+dump_stats_t;
+
+
+static void
+dump_flush(
+    dump_out_t* out
+)
+{
+    fwrite(out->buff, 1, out->len, out->out);
+    out->len = 0;
+}
+
+/**
+ * Room for a row of at most `len` bytes.
+ **/
+static char*
+dump_reserve(
+    dump_out_t* out,
+    size_t      len
+)
+{
+    if (out->len + len > DUMP_OUT_BUFF_SIZE)
+        dump_flush(out);
+
+    return out->buff + out->len;
+}
+
+/* printf is most of the time spent otherwise */
+static char*
+dump_put_u64(
+    char*    pos,
+    uint64_t val
+)
+{
+    char tmp[20];
+    int n = 0;
+
+    do
+    {
+        tmp[n++] = '0' + val % 10;
+        val /= 10;
+    }
+    while (val);
+
+    while (n)
+        *pos++ = tmp[--n];
+
+    return pos;
+}
+
+static char*
+dump_put_hex(
+    char*   pos,
+    uint8_t val
+)
+{
+    static const char digits[] = "0123456789ABCDEF";
+
+    *pos++ = digits[val >> 4];
+    *pos++ = digits[val & 0x0F];
+    return pos;
+}
+
+static char*
+dump_put_addr(
+    char*   pos,
+    uint8_t val
+)
+{
+    *pos++ = '0';
+    *pos++ = 'x';
+    return dump_put_hex(pos, val);
+}
+
+static bool
+dump_cols_add(
+    dump_cols_t* cols,
+    uint64_t     t_us,
+    uint8_t      src,
+    uint8_t      dst,
+    uint8_t      reg,
+    uint16_t     value
+)
+{
+    if (cols->rows == cols->cap)
+    {
+        uint64_t cap = cols->cap ? cols->cap * 2 : 1 << 16;
+
+        cols->t_us  = realloc(cols->t_us,  cap * sizeof(uint64_t));
+        cols->src   = realloc(cols->src,   cap);
+        cols->dst   = realloc(cols->dst,   cap);
+        cols->reg   = realloc(cols->reg,   cap);
+        cols->value = realloc(cols->value, cap * sizeof(uint16_t));
+
+        if (!cols->t_us || !cols->src || !cols->dst || !cols->reg || !cols->value)
+            return false;
+
+        cols->cap = cap;
+    }
+
+    uint64_t r = cols->rows++;
+
+    cols->t_us[r]  = t_us;
+    cols->src[r]   = src;
+    cols->dst[r]   = dst;
+    cols->reg[r]   = reg;
+    cols->value[r] = value;
+
+    return true;
+}
+
+static void
+dump_cols_write(
+    dump_cols_t* cols,
+    FILE*        out
+)
+{
+    fwrite(DUMP_COL_MAGIC, 1, 8, out);
+    fwrite(&cols->rows, sizeof(uint64_t), 1, out);
+    fwrite(cols->t_us,  sizeof(uint64_t), cols->rows, out);
+    fwrite(cols->src,   1, cols->rows, out);
+    fwrite(cols->dst,   1, cols->rows, out);
+    fwrite(cols->reg,   1, cols->rows, out);
+    fwrite(cols->value, sizeof(uint16_t), cols->rows, out);
+}
+
+static bool
+dump_reg_wanted(
+    const dump_opts_t* opts,
+    uint8_t            reg
+)
+{
+    return opts->any_reg || (opts->regs[reg / 8] & (1 << (reg % 8)));
+}
+
+/**
+ * Writes the rows of one frame, found at
+ * byte `offset` of the capture.
+ **/
+static bool
+dump_frame(
+    const dump_opts_t*      opts,
+    const esk8_uart_msg_t*  msg,
+    uint64_t                offset,
+    dump_out_t*             out,
+    dump_cols_t*            cols,
+    dump_stats_t*           stats
+)
+{
+    uint64_t t_us = offset * 10 * 1000000 / opts->baud;
+
+    if (opts->src >= 0 && msg->src_address != opts->src)
+        return true;
+
+    if (opts->frames)
+    {
+        if (!dump_reg_wanted(opts, msg->cmd_argment))
+            return true;
+
+        char* pos = dump_reserve(out, 64 + 2 * msg->pld_length);
+        char* start = pos;
+
+        pos = dump_put_u64(pos, t_us);                      *pos++ = ',';
+        pos = dump_put_addr(pos, msg->src_address);         *pos++ = ',';
+        pos = dump_put_addr(pos, msg->dst_address);         *pos++ = ',';
+        pos = dump_put_addr(pos, msg->cmd_command);         *pos++ = ',';
+        pos = dump_put_addr(pos, msg->cmd_argment);         *pos++ = ',';
+        pos = dump_put_u64(pos, msg->pld_length);           *pos++ = ',';
+
+        for (int i = 0; i < msg->pld_length; i++)
+            pos = dump_put_hex(pos, msg->payload[i]);
+
+        *pos++ = '\n';
+        out->len += pos - start;
+        stats->rows++;
+        return true;
+    }
+
+    if (msg->cmd_command != ESK8_MSG_CMD_READ_RSP)
+        return true;
+
+    /* Every row of the frame starts the same */
+    char prefix[48];
+    char* prefix_end = prefix;
+
+    if (!opts->columns)
+    {
+        prefix_end = dump_put_u64(prefix_end, t_us);                *prefix_end++ = ',';
+        prefix_end = dump_put_addr(prefix_end, msg->src_address);   *prefix_end++ = ',';
+        prefix_end = dump_put_addr(prefix_end, msg->dst_address);   *prefix_end++ = ',';
+    }
+
+    /* Registers are 16 bit words, an odd tail is a byte of the last one */
+    for (int i = 0; i < msg->pld_length; i += 2)
+    {
+        uint8_t  reg   = msg->cmd_argment + i / 2;
+        uint16_t value = msg->payload[i];
+
+        if (i + 1 < msg->pld_length)
+            value |= msg->payload[i + 1] << 8;
+
+        if (!dump_reg_wanted(opts, reg))
+            continue;
+
+        stats->rows++;
+
+        if (opts->columns)
+        {
+            if (!dump_cols_add(cols, t_us, msg->src_address, msg->dst_address, reg, value))
+                return false;
+
+            continue;
+        }
+
+        char* pos = dump_reserve(out, 64);
+        char* start = pos;
+
+        memcpy(pos, prefix, prefix_end - prefix);
+        pos += prefix_end - prefix;
+
+        pos = dump_put_addr(pos, reg);                      *pos++ = ',';
+        pos = dump_put_u64(pos, value);
+        *pos++ = '\n';
+
+        out->len += pos - start;
+    }
+
+    return true;
+}
+
+/**
+ * Walks every frame of `data`. A header that
+ * does not lead to a valid frame is skipped
+ * by one byte, so frames hiding behind it
+ * are still found.
+ **/
+static bool
+dump_capture(
+    const dump_opts_t*  opts,
+    const uint8_t*      data,
+    uint64_t            size,
+    dump_out_t*         out,
+    dump_cols_t*        cols,
+    dump_stats_t*       stats
+)
+{
+    uint64_t off = 0;
+
+    while (off < size)
+    {
+        uint64_t rem = size - off;
+        int found = esk8_uart_msg_find_header(
+            (uint8_t*) data + off,
+            rem < INT_MAX ? rem : INT_MAX
+        );
+
+        if (found < 0)
+        {
+            /* A header may straddle the window */
+            if (rem <= INT_MAX)
+                break;
+
+            off += INT_MAX - 1;
+            continue;
+        }
+
+        off += found;
+
+        size_t end;
+        esk8_uart_msg_t msg;
+        esk8_err_t err = esk8_uart_msg_view(
+            data + off,
+            size - off < ESK8_MSG_MAX_SIZE ? size - off : ESK8_MSG_MAX_SIZE,
+            &msg, &end
+        );
+
+        if (err)
+        {
+            stats->bad++;
+            off++;
+            continue;
+        }
+
+        stats->frames++;
+
+        if (!dump_frame(opts, &msg, off, out, cols, stats))
+            return false;
+
+        off += end;
+    }
+
+    return true;
+}
+
+static void
+dump_usage(
+    const char* name
+)
+{
+    fprintf(stderr,
+        "usage: %s [-b baud] [-o out] [-k] [-F] [-s addr] [-r reg]... capture\n"
+        "  -b baud   wire speed, for timestamps (%d)\n"
+        "  -o out    output file, stdout by default\n"
+        "  -k        columns instead of CSV, see the source for the layout\n"
+        "  -F        one CSV row per frame, with its payload\n"
+        "  -s addr   only frames from `addr`, like 0x22\n"
+        "  -r reg    only register `reg`, may be repeated\n",
+        name, ESK8_UART_BAUD_RATE);
+}
+
+int
+main(
+    int     argc,
+    char**  argv
+)
+{
+    dump_opts_t opts = {
+        .baud    = ESK8_UART_BAUD_RATE,
+        .src     = -1,
+        .any_reg = true,
+    };
+    const char* out_path = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:o:kFs:r:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'b': opts.baud    = strtoul(optarg, NULL, 0);  break;
+            case 'o': out_path     = optarg;                    break;
+            case 'k': opts.columns = true;                      break;
+            case 'F': opts.frames  = true;                      break;
+            case 's': opts.src     = strtoul(optarg, NULL, 0);  break;
+            case 'r':
+            {
+                uint8_t reg = strtoul(optarg, NULL, 0);
+
+                opts.any_reg = false;
+                opts.regs[reg / 8] |= 1 << (reg % 8);
+                break;
+            }
+            default:
+                dump_usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (optind != argc - 1 || !opts.baud || (opts.columns && opts.frames))
+    {
+        dump_usage(argv[0]);
+        return 1;
+    }
+
+    int fd = open(argv[optind], O_RDONLY);
+    struct stat st;
+
+    if (fd < 0 || fstat(fd, &st))
+    {
+        perror(argv[optind]);
+        return 1;
+    }
+
+    const uint8_t* data = NULL;
+
+    if (st.st_size)
+    {
+        data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (data == MAP_FAILED)
+        {
+            perror("mmap");
+            return 1;
+        }
+
+        madvise((void*) data, st.st_size, MADV_SEQUENTIAL);
+    }
+
+    FILE* out_file = out_path ? fopen(out_path, "wb") : stdout;
+
+    if (!out_file)
+    {
+        perror(out_path);
+        return 1;
+    }
+
+    dump_out_t out = {
+        .out  = out_file,
+        .buff = malloc(DUMP_OUT_BUFF_SIZE),
+    };
+    dump_cols_t cols = { 0 };
+    dump_stats_t stats = { 0 };
+
+    if (!opts.columns)
+    {
+        const char* head = opts.frames ?
+            "t_us,src,dst,cmd,arg,len,payload\n" : "t_us,src,dst,reg,value\n";
+
+        fputs(head, out_file);
+    }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    bool ok = dump_capture(&opts, data, st.st_size, &out, &cols, &stats);
+
+    if (opts.columns)
+        dump_cols_write(&cols, out_file);
+    else
+        dump_flush(&out);
+
+    fflush(out_file);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    double secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+    fprintf(stderr, "%llu bytes, %llu frames, %llu bad, %llu rows in %.3f s, %.1f MB/s\n",
+        (unsigned long long) st.st_size,
+        (unsigned long long) stats.frames,
+        (unsigned long long) stats.bad,
+        (unsigned long long) stats.rows,
+        secs, secs > 0 ? st.st_size / secs / 1e6 : 0.0);
+
+    if (!ok)
+        fprintf(stderr, "out of memory\n");
+
+    if (out_file != stdout)
+        fclose(out_file);
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,827 @@
+#include <esk8_ps2_sim.h>
+
+#include <driver/gpio.h>
+
+#include <sched.h>
+#include <string.h>
+#include <time.h>
+
+#define SIM_ACK             0xFA
+#define SIM_RESEND          0xFE
+#define SIM_BAT_OK          0xAA
+#define SIM_DEFAULT_RATE    100
+
+#define SIM_SYN_MAGIC       0x47
+#define SIM_SYN_FW_MAJOR    7
+#define SIM_SYN_FW_MINOR    8
+#define SIM_SYN_SET_MODE    0x14
+#define SIM_SYN_Z           60      /* A finger resting on the pad */
+#define SIM_SYN_W           4
+#define SIM_SYN_MIN         1000    /* Range the finger wanders in */
+#define SIM_SYN_MAX         5000
+
+#define SIM_MOVE_MAX        20      /* Largest step of a packet, in counts */
+
+
+static int64_t
+sim_now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000000000ll + ts.tv_nsec;
+}
+
+static int64_t
+sim_now_us()
+{
+    return sim_now_ns() / 1000;
+}
+
+static uint32_t
+sim_rand(
+    esk8_ps2_sim_t* sim
+)
+{
+    /* xorshift32, same dice as the BMS sim */
+    uint32_t x = sim->rng;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    return sim->rng = x;
+}
+
+static bool
+sim_roll(
+    esk8_ps2_sim_t* sim,
+    float           rate
+)
+{
+    if (rate <= 0)
+        return false;
+
+    return (sim_rand(sim) >> 8) < rate * (1 << 24);
+}
+
+static int
+sim_odd_parity(
+    uint8_t byte
+)
+{
+    return !__builtin_parity(byte);
+}
+
+/**
+ * Half a clock period. Bits are far too short
+ * to sleep, so this spins like the device would.
+ **/
+static void
+sim_half_bit(
+    esk8_ps2_sim_t* sim
+)
+{
+    if (!sim->cnfg.bit_us)
+        return;
+
+    int64_t end_ns = sim_now_ns() + sim->cnfg.bit_us * 500ll;
+
+    while (sim_now_ns() < end_ns)
+        ;
+}
+
+static void
+sim_wave(
+    esk8_ps2_sim_t* sim
+)
+{
+    if (!sim->wave)
+        return;
+
+    fprintf(sim->wave, "%lld,%d,%d\n",
+        (long long)(sim_now_us() - sim->start_us),
+        gpio_get_level(sim->clock_pin),
+        gpio_get_level(sim->data_pin));
+}
+
+/**
+ * One clock pulse. The ISR only runs if the
+ * line really went high: a host holding the
+ * clock low keeps the edge from happening.
+ **/
+static void
+sim_clock(
+    esk8_ps2_sim_t* sim
+)
+{
+    esk8_shim_gpio_drive(sim->clock_pin, 0);
+    sim_wave(sim);
+    sim_half_bit(sim);
+
+    esk8_shim_gpio_drive(sim->clock_pin, 1);
+    sim_wave(sim);
+
+    if (gpio_get_level(sim->clock_pin))
+    {
+        int64_t t0_ns = sim_now_ns();
+        bool ran = esk8_shim_gpio_edge(sim->clock_pin);
+        uint32_t isr_ns = sim_now_ns() - t0_ns;
+
+        if (ran)
+        {
+            sim->stats.n_edges++;
+            sim->stats.isr_ns += isr_ns;
+
+            if (isr_ns > sim->stats.isr_max_ns)
+                sim->stats.isr_max_ns = isr_ns;
+        }
+    }
+
+    sim_half_bit(sim);
+}
+
+static bool
+sim_host_holds(
+    esk8_ps2_sim_t* sim
+)
+{
+    return !gpio_get_level(sim->clock_pin);
+}
+
+/**
+ * Clocks one byte out to the host, start,
+ * 8 data bits, odd parity and stop. Gives up
+ * when the host is holding the clock, as the
+ * device has to. If `faulty` is given, the
+ * dice may break the byte on purpose, and it
+ * is set when they do.
+ * Returns false if the byte was cut short.
+ **/
+static bool
+sim_send_byte(
+    esk8_ps2_sim_t* sim,
+    uint8_t         byte,
+    bool*           faulty
+)
+{
+    int bits[11];
+    int glitch_at = -1;
+
+    bits[0] = 0;
+    for (int i = 0; i < 8; i++)
+        bits[1 + i] = (byte >> i) & 1;
+    bits[9]  = sim_odd_parity(byte);
+    bits[10] = 1;
+
+    if (faulty && sim_roll(sim, sim->cnfg.flip_rate))
+    {
+        bits[1 + sim_rand(sim) % 8] ^= 1;
+        *faulty = true;
+    }
+
+    if (faulty && sim_roll(sim, sim->cnfg.glitch_rate))
+    {
+        glitch_at = sim_rand(sim) % 10;
+        *faulty = true;
+    }
+
+    for (int i = 0; i < 11; i++)
+    {
+        if (sim_host_holds(sim))
+        {
+            esk8_shim_gpio_drive(sim->data_pin, 1);
+            return false;
+        }
+
+        esk8_shim_gpio_drive(sim->data_pin, bits[i]);
+        sim_clock(sim);
+
+        if (i == glitch_at)
+            sim_clock(sim);
+    }
+
+    esk8_shim_gpio_drive(sim->data_pin, 1);
+    return true;
+}
+
+static void
+sim_queue(
+    esk8_ps2_sim_t* sim,
+    const uint8_t*  bytes,
+    int             len
+)
+{
+    if (sim->tx_len + len > sizeof(sim->tx))
+        return;
+
+    memcpy(sim->tx + sim->tx_len, bytes, len);
+    sim->tx_len += len;
+}
+
+static void
+sim_queue_byte(
+    esk8_ps2_sim_t* sim,
+    uint8_t         byte
+)
+{
+    sim_queue(sim, &byte, 1);
+}
+
+static void
+sim_reset(
+    esk8_ps2_sim_t* sim
+)
+{
+    sim->enabled   = false;
+    sim->remote    = false;
+    sim->wheel     = false;
+    sim->absolute  = false;
+    sim->rate      = SIM_DEFAULT_RATE;
+    sim->arg_cmd   = 0;
+    sim->n_special = 0;
+    sim->touch     = false;
+    sim->abs_x     = (SIM_SYN_MIN + SIM_SYN_MAX) / 2;
+    sim->abs_y     = (SIM_SYN_MIN + SIM_SYN_MAX) / 2;
+
+    memset(sim->knock, 0, sizeof(sim->knock));
+}
+
+static int
+sim_step(
+    esk8_ps2_sim_t* sim
+)
+{
+    return (int)(sim_rand(sim) % (2 * SIM_MOVE_MAX + 1)) - SIM_MOVE_MAX;
+}
+
+/**
+ * Builds the next movement packet in the
+ * current mode. `out_dx` and `out_dy` get the
+ * relative motion the host should decode.
+ **/
+static int
+sim_make_pkt(
+    esk8_ps2_sim_t* sim,
+    uint8_t*        pkt,
+    int*            out_dx,
+    int*            out_dy
+)
+{
+    int dx = sim_step(sim);
+    int dy = sim_step(sim);
+
+    if (sim->absolute)
+    {
+        /* Touching down only gives the host a starting point */
+        if (!sim->touch)
+        {
+            dx = 0;
+            dy = 0;
+            sim->touch = true;
+        }
+
+        if (sim->abs_x + dx * (int)sim->cnfg.abs_div < SIM_SYN_MIN ||
+            sim->abs_x + dx * (int)sim->cnfg.abs_div > SIM_SYN_MAX)
+            dx = -dx;
+
+        if (sim->abs_y + dy * (int)sim->cnfg.abs_div < SIM_SYN_MIN ||
+            sim->abs_y + dy * (int)sim->cnfg.abs_div > SIM_SYN_MAX)
+            dy = -dy;
+
+        sim->abs_x += dx * sim->cnfg.abs_div;
+        sim->abs_y += dy * sim->cnfg.abs_div;
+
+        int x = sim->abs_x;
+        int y = sim->abs_y;
+        int w = SIM_SYN_W;
+
+        pkt[0] = 0x80 | ((w >> 2) & 0x03) << 4 | ((w >> 1) & 0x01) << 2;
+        pkt[1] = ((y >> 8) & 0x0F) << 4 | ((x >> 8) & 0x0F);
+        pkt[2] = SIM_SYN_Z;
+        pkt[3] = 0xC0 | ((y >> 12) & 0x01) << 5 | ((x >> 12) & 0x01) << 4 | (w & 0x01) << 2;
+        pkt[4] = x & 0xFF;
+        pkt[5] = y & 0xFF;
+
+        *out_dx = dx;
+        *out_dy = dy;
+        return 6;
+    }
+
+    pkt[0] = 0x08 | (dx < 0) << 4 | (dy < 0) << 5;
+    pkt[1] = dx & 0xFF;
+    pkt[2] = dy & 0xFF;
+
+    *out_dx = dx;
+    *out_dy = dy;
+
+    if (!sim->wheel)
+        return 3;
+
+    pkt[3] = (uint8_t)(int8_t)((int)(sim_rand(sim) % 3) - 1);
+    return 4;
+}
+
+/**
+ * Sends a movement packet right away,
+ * and books its motion if it got through
+ * whole and unbroken.
+ **/
+static void
+sim_send_pkt(
+    esk8_ps2_sim_t* sim
+)
+{
+    uint8_t pkt[ESK8_PS2_SIM_PKT_MAX];
+    int dx, dy;
+    bool faulty = false;
+
+    int len = sim_make_pkt(sim, pkt, &dx, &dy);
+
+    /* Throws the host off by a byte, the packet itself is fine */
+    if (sim->absolute && sim_roll(sim, sim->cnfg.stray_rate))
+    {
+        if (!sim_send_byte(sim, 0x80 | (sim_rand(sim) & 0x37), NULL))
+        {
+            sim->stats.n_aborted++;
+            return;
+        }
+
+        sim->stats.n_strays++;
+    }
+
+    for (int i = 0; i < len; i++)
+    {
+        if (!sim_send_byte(sim, pkt[i], &faulty))
+        {
+            sim->stats.n_aborted++;
+            return;
+        }
+    }
+
+    if (faulty)
+    {
+        sim->stats.n_faulty++;
+        return;
+    }
+
+    sim->stats.n_pkts++;
+    sim->stats.sum_x += dx;
+    sim->stats.sum_y += dy;
+}
+
+static void
+sim_handle_arg(
+    esk8_ps2_sim_t* sim,
+    uint8_t         cmd,
+    uint8_t         arg
+)
+{
+    sim_queue_byte(sim, SIM_ACK);
+
+    if (cmd == 0xE8)
+    {
+        sim->special = sim->special << 2 | (arg & 0x03);
+        if (sim->n_special < 4)
+            sim->n_special++;
+        return;
+    }
+
+    /* SET_SMPL_RATE */
+    sim->knock[0] = sim->knock[1];
+    sim->knock[1] = sim->knock[2];
+    sim->knock[2] = arg;
+
+    if  (
+            sim->cnfg.model == ESK8_PS2_SIM_SYNAPTICS &&
+            arg == SIM_SYN_SET_MODE &&
+            sim->n_special == 4
+        )
+    {
+        sim->absolute  = sim->special & 0x80;
+        sim->touch     = false;
+        sim->n_special = 0;
+        return;
+    }
+
+    sim->n_special = 0;
+    sim->rate = arg;
+
+    if  (
+            sim->cnfg.model == ESK8_PS2_SIM_IMPS &&
+            sim->knock[0] == 200 && sim->knock[1] == 100 && sim->knock[2] == 80
+        )
+        sim->wheel = true;
+}
+
+static void
+sim_handle(
+    esk8_ps2_sim_t* sim,
+    uint8_t         byte
+)
+{
+    if (sim->arg_cmd)
+    {
+        uint8_t cmd = sim->arg_cmd;
+        sim->arg_cmd = 0;
+        sim_handle_arg(sim, cmd, byte);
+        return;
+    }
+
+    /* Whatever was left to send is stale now */
+    sim->tx_len = 0;
+
+    /* Only the commands that read the special byte keep it */
+    if (byte != 0xE8 && byte != 0xE9 && byte != 0xF3)
+        sim->n_special = 0;
+
+    switch (byte)
+    {
+    case 0xFF:
+        sim_reset(sim);
+        sim_queue(sim, (uint8_t[]){ SIM_ACK, SIM_BAT_OK, 0x00 }, 3);
+        break;
+    case 0xF6:
+        sim->enabled = false;
+        sim->remote  = false;
+        sim->rate    = SIM_DEFAULT_RATE;
+        sim_queue_byte(sim, SIM_ACK);
+        break;
+    case 0xF5:
+        sim->enabled = false;
+        sim_queue_byte(sim, SIM_ACK);
+        break;
+    case 0xF4:
+        sim->enabled     = true;
+        sim->touch       = false;
+        sim->next_pkt_us = sim_now_us();
+        sim_queue_byte(sim, SIM_ACK);
+        break;
+    case 0xEA:
+    case 0xF0:
+        sim->remote = byte == 0xF0;
+        sim->touch  = false;
+        sim_queue_byte(sim, SIM_ACK);
+        break;
+    case 0xE6:
+    case 0xE7:
+    case 0xEC:
+        sim_queue_byte(sim, SIM_ACK);
+        break;
+    case 0xE8:
+    case 0xF3:
+        sim->arg_cmd = byte;
+        sim_queue_byte(sim, SIM_ACK);
+        break;
+    case 0xF2:
+        sim_queue(sim, (uint8_t[]){ SIM_ACK, sim->wheel ? 0x03 : 0x00 }, 2);
+        break;
+    case 0xE9:
+        if  (
+                sim->cnfg.model == ESK8_PS2_SIM_SYNAPTICS &&
+                sim->n_special == 4 && sim->special == 0
+            )
+        {
+            sim_queue(sim, (uint8_t[]){
+                SIM_ACK, SIM_SYN_FW_MINOR, SIM_SYN_MAGIC, SIM_SYN_FW_MAJOR
+            }, 4);
+        }
+        else
+        {
+            sim_queue(sim, (uint8_t[]){
+                SIM_ACK, sim->remote << 6 | sim->enabled << 5, 0x02, sim->rate
+            }, 4);
+        }
+        sim->n_special = 0;
+        break;
+    case 0xEB:
+        /* The packet follows the ACK, sent by the loop */
+        sim_queue_byte(sim, SIM_ACK);
+        sim->next_pkt_us = -1;
+        break;
+    default:
+        sim_queue_byte(sim, SIM_RESEND);
+        break;
+    }
+}
+
+/**
+ * Clocks in a byte the host is sending, the
+ * host sets each bit while the clock is high,
+ * then acknowledges it by pulling data low.
+ **/
+static void
+sim_recv_host(
+    esk8_ps2_sim_t* sim
+)
+{
+    int bits[11];
+
+    for (int i = 0; i < 11; i++)
+    {
+        sim_clock(sim);
+        bits[i] = gpio_get_level(sim->data_pin);
+    }
+
+    esk8_shim_gpio_drive(sim->data_pin, 0);
+    sim_clock(sim);
+    esk8_shim_gpio_drive(sim->data_pin, 1);
+
+    uint8_t byte = 0;
+    for (int i = 0; i < 8; i++)
+        byte |= bits[1 + i] << i;
+
+    if  (
+            bits[0] != 0 ||
+            bits[9] != sim_odd_parity(byte) ||
+            bits[10] != 1
+        )
+    {
+        sim->stats.n_host_errs++;
+        sim->tx_len = 0;
+        sim_queue_byte(sim, SIM_RESEND);
+        return;
+    }
+
+    sim->stats.n_cmds++;
+    sim_handle(sim, byte);
+}
+
+/**
+ * Whether a streamed packet is due, and if
+ * not, when it will be.
+ **/
+static bool
+sim_pkt_due(
+    esk8_ps2_sim_t* sim,
+    int64_t*        out_wait_us
+)
+{
+    *out_wait_us = 1000;
+
+    /* A poll always gets its packet */
+    if (sim->next_pkt_us < 0)
+        return true;
+
+    if (!sim->enabled || sim->remote || sim->arg_cmd)
+        return false;
+
+    if (esk8_ps2_sim_done(sim))
+        return false;
+
+    if (sim->cnfg.flood)
+        return true;
+
+    int64_t now_us = sim_now_us();
+
+    if (now_us < sim->next_pkt_us)
+    {
+        *out_wait_us = sim->next_pkt_us - now_us;
+        return false;
+    }
+
+    sim->next_pkt_us += 1000000 / (sim->rate ? sim->rate : SIM_DEFAULT_RATE);
+
+    /* Don't try to catch up after a long command exchange */
+    if (sim->next_pkt_us < now_us)
+        sim->next_pkt_us = now_us;
+
+    return true;
+}
+
+static void*
+sim_thread(
+    void* arg
+)
+{
+    esk8_ps2_sim_t* sim = (esk8_ps2_sim_t*)arg;
+
+    pthread_mutex_lock(&sim->mutex);
+
+    while (sim->running)
+    {
+        int64_t wait_us = 1000;
+
+        if (!sim->present)
+        {
+            /* Nobody there to see the host asking */
+            sim->rts = false;
+            sim->host_hold = false;
+
+            if (sim->plug_at_us && sim_now_us() >= sim->plug_at_us)
+            {
+                sim->present    = true;
+                sim->plug_at_us = 0;
+                sim_reset(sim);
+                sim->tx_len = 0;
+                sim_queue(sim, (uint8_t[]){ SIM_BAT_OK, 0x00 }, 2);
+
+                sim->stats.n_plugs++;
+                sim->stats.plug_us = sim_now_us();
+                continue;
+            }
+
+            if (sim->plug_at_us)
+                wait_us = sim->plug_at_us - sim_now_us();
+        }
+        else if (sim->rts)
+        {
+            sim->rts = false;
+            pthread_mutex_unlock(&sim->mutex);
+            sim_recv_host(sim);
+            pthread_mutex_lock(&sim->mutex);
+            continue;
+        }
+        else if (sim->host_hold)
+        {
+            pthread_cond_wait(&sim->cond, &sim->mutex);
+            continue;
+        }
+        else if (sim->tx_len)
+        {
+            uint8_t tx[sizeof(sim->tx)];
+            int tx_len = sim->tx_len;
+
+            memcpy(tx, sim->tx, tx_len);
+            sim->tx_len = 0;
+            pthread_mutex_unlock(&sim->mutex);
+
+            for (int i = 0; i < tx_len; i++)
+                if (!sim_send_byte(sim, tx[i], NULL))
+                    break;
+
+            pthread_mutex_lock(&sim->mutex);
+            continue;
+        }
+        else if (sim_pkt_due(sim, &wait_us))
+        {
+            if (sim->next_pkt_us < 0)
+                sim->next_pkt_us = 0;
+
+            pthread_mutex_unlock(&sim->mutex);
+            sim_send_pkt(sim);
+
+            /* Flat out, the host still gets the CPU between packets */
+            sched_yield();
+
+            pthread_mutex_lock(&sim->mutex);
+            continue;
+        }
+
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+
+        int64_t ns = ts.tv_nsec + wait_us * 1000;
+        ts.tv_sec  += ns / 1000000000;
+        ts.tv_nsec  = ns % 1000000000;
+
+        pthread_cond_timedwait(&sim->cond, &sim->mutex, &ts);
+    }
+
+    pthread_mutex_unlock(&sim->mutex);
+    return NULL;
+}
+
+/**
+ * The firmware grabs the clock to send, and
+ * lets it go once it has the start bit out.
+ * Requests to send cut short are counted.
+ **/
+static void
+sim_on_clock_dir(
+    int         pin,
+    gpio_mode_t mode,
+    void*       ctx
+)
+{
+    esk8_ps2_sim_t* sim = (esk8_ps2_sim_t*)ctx;
+
+    pthread_mutex_lock(&sim->mutex);
+
+    if (mode == GPIO_MODE_OUTPUT)
+    {
+        sim->host_hold = true;
+        sim->hold_us   = sim_now_us();
+    }
+    else if (sim->host_hold)
+    {
+        /* A request to send holds the clock 100 us, then pulls data down */
+        if  (
+                sim_now_us() - sim->hold_us < 100 ||
+                gpio_get_level(sim->data_pin)
+            )
+            sim->stats.n_bad_rts++;
+
+        sim->host_hold = false;
+        sim->rts = true;
+    }
+
+    pthread_cond_signal(&sim->cond);
+    pthread_mutex_unlock(&sim->mutex);
+}
+
+
+void
+esk8_ps2_sim_cnfg_default(
+    esk8_ps2_sim_cnfg_t* cnfg
+)
+{
+    memset(cnfg, 0, sizeof(*cnfg));
+
+    cnfg->model   = ESK8_PS2_SIM_MOUSE;
+    cnfg->abs_div = 16;
+}
+
+int
+esk8_ps2_sim_start(
+    esk8_ps2_sim_t*            sim,
+    const esk8_ps2_sim_cnfg_t* cnfg,
+    int                        clock_pin,
+    int                        data_pin,
+    uint32_t                   seed
+)
+{
+    FILE* wave = sim->wave;
+
+    memset(sim, 0, sizeof(*sim));
+
+    sim->cnfg      = *cnfg;
+    sim->clock_pin = clock_pin;
+    sim->data_pin  = data_pin;
+    sim->wave      = wave;
+    sim->rng       = seed ? seed : 0x2545F491;
+    sim->start_us  = sim_now_us();
+    sim->running   = true;
+    sim->present   = !cnfg->plug_ms;
+
+    if (cnfg->plug_ms)
+        sim->plug_at_us = sim->start_us + cnfg->plug_ms * 1000ll;
+
+    if (!sim->cnfg.abs_div)
+        sim->cnfg.abs_div = 16;
+
+    sim_reset(sim);
+
+    esk8_shim_gpio_drive(clock_pin, 1);
+    esk8_shim_gpio_drive(data_pin, 1);
+
+    pthread_mutex_init(&sim->mutex, NULL);
+    pthread_cond_init(&sim->cond, NULL);
+
+    esk8_shim_gpio_set_hooks(clock_pin, &(esk8_shim_gpio_hooks_t){
+        .on_dir = sim_on_clock_dir,
+        .ctx    = sim,
+    });
+
+    if (sim->wave)
+        fprintf(sim->wave, "t_us,clk,data\n");
+
+    return pthread_create(&sim->thread, NULL, sim_thread, sim);
+}
+
+void
+esk8_ps2_sim_stop(
+    esk8_ps2_sim_t* sim
+)
+{
+    pthread_mutex_lock(&sim->mutex);
+    sim->running = false;
+    pthread_cond_signal(&sim->cond);
+    pthread_mutex_unlock(&sim->mutex);
+
+    pthread_join(sim->thread, NULL);
+
+    esk8_shim_gpio_set_hooks(sim->clock_pin, NULL);
+    esk8_shim_gpio_drive(sim->clock_pin, 1);
+    esk8_shim_gpio_drive(sim->data_pin, 1);
+
+    if (sim->wave)
+        fflush(sim->wave);
+}
+
+void
+esk8_ps2_sim_unplug(
+    esk8_ps2_sim_t* sim,
+    uint32_t        off_ms
+)
+{
+    pthread_mutex_lock(&sim->mutex);
+    sim->present    = false;
+    sim->plug_at_us = sim_now_us() + off_ms * 1000ll;
+    pthread_cond_signal(&sim->cond);
+    pthread_mutex_unlock(&sim->mutex);
+}
+
+bool
+esk8_ps2_sim_done(
+    esk8_ps2_sim_t* sim
+)
+{
+    if (!sim->cnfg.max_pkts)
+        return false;
+
+    uint32_t sent = __atomic_load_n(&sim->stats.n_pkts, __ATOMIC_RELAXED) +
+                    __atomic_load_n(&sim->stats.n_faulty, __ATOMIC_RELAXED);
+
+    return sent >= sim->cnfg.max_pkts;
+}
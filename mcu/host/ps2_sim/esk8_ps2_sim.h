@@ -0,0 +1,169 @@
+#ifndef _ESK8_PS2_SIM_H
+#define _ESK8_PS2_SIM_H
+
+/**
+ * A virtual PS/2 mouse or trackpad at the other
+ * end of two shimmed GPIOs, so the real `lib/ps2`
+ * ISR sees the clock and data lines bit by bit.
+ * The device clocks every bit itself, as a real
+ * one would, and runs the firmware ISR on each
+ * rising clock edge from its own thread. Host
+ * to device sends are picked up when the firmware
+ * lets go of the clock line it was holding low.
+ **/
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#define ESK8_PS2_SIM_PKT_MAX 6
+
+
+typedef enum
+{
+    ESK8_PS2_SIM_MOUSE,             /* Standard 3 byte packets              */
+    ESK8_PS2_SIM_IMPS,              /* Turns its wheel on after the knock   */
+    ESK8_PS2_SIM_SYNAPTICS,         /* Identifies, and goes absolute        */
+}
+esk8_ps2_sim_model_t;
+
+/**
+ * How the device behaves on the wire.
+ * Rates are probabilities per byte, 0 to 1.
+ * Faults only hit movement packets, so
+ * negotiation always goes through.
+ **/
+typedef struct
+{
+    esk8_ps2_sim_model_t model;
+    uint32_t    bit_us;             /* Clock period, 0 to run flat out      */
+    bool        flood;              /* Ignore the sample rate in stream mode */
+    uint32_t    max_pkts;           /* Stop reporting after these, 0 never  */
+    uint32_t    abs_div;            /* Absolute units per relative count    */
+    uint32_t    plug_ms;            /* Absent at first, then plugged in     */
+    float       flip_rate;          /* Flip a data bit, breaking parity     */
+    float       glitch_rate;        /* Add a spurious clock edge            */
+    float       stray_rate;         /* Per packet, absolute ones only: a lone
+                                       byte that looks like a header first  */
+}
+esk8_ps2_sim_cnfg_t;
+
+typedef struct
+{
+    uint64_t    n_edges;            /* Rising edges the ISR ran on          */
+    uint64_t    isr_ns;             /* Time spent in the ISR                */
+    uint32_t    isr_max_ns;
+
+    uint32_t    n_pkts;             /* Movement packets sent whole          */
+    uint32_t    n_aborted;          /* Cut short by the host inhibiting     */
+    uint32_t    n_faulty;           /* Sent with a flipped bit or glitch    */
+    uint32_t    n_strays;           /* Header lookalikes sent before one    */
+    uint32_t    n_cmds;             /* Host bytes received                  */
+    uint32_t    n_host_errs;        /* Host bytes with a bad frame          */
+    uint32_t    n_bad_rts;          /* Clock let go under 100 us, or data up */
+
+    /* Relative motion of the good packets, as the host should decode it */
+    int64_t     sum_x;
+    int64_t     sum_y;
+
+    uint32_t    n_plugs;            /* Power on announcements sent          */
+    int64_t     plug_us;            /* CLOCK_MONOTONIC time of the last one */
+}
+esk8_ps2_sim_stats_t;
+
+typedef struct
+{
+    esk8_ps2_sim_cnfg_t  cnfg;
+    esk8_ps2_sim_stats_t stats;
+    int         clock_pin;
+    int         data_pin;
+    FILE*       wave;               /* `t_us,clk,data` rows, if set         */
+
+    bool        present;
+    int64_t     plug_at_us;         /* When an absent device shows up, 0 never */
+
+    /* Device state, only touched by the device thread */
+    bool        enabled;
+    bool        remote;
+    bool        wheel;
+    bool        absolute;
+    uint8_t     rate;
+    uint8_t     arg_cmd;            /* Command waiting for its argument     */
+    uint8_t     knock[3];           /* Last sample rates, newest last       */
+    uint8_t     special;            /* Synaptics byte, 2 bits per E8        */
+    uint8_t     n_special;
+    int         abs_x;
+    int         abs_y;
+    bool        touch;
+    int64_t     next_pkt_us;
+    uint32_t    rng;
+    int64_t     start_us;
+
+    uint8_t     tx[16];             /* Bytes queued for the host            */
+    int         tx_len;
+
+    pthread_t       thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+    bool        running;
+    bool        host_hold;          /* Host is holding the clock low        */
+    int64_t     hold_us;            /* Since when                           */
+    bool        rts;                /* Host let the clock go, data to read  */
+}
+esk8_ps2_sim_t;
+
+
+/**
+ * Defaults: a standard mouse clocking
+ * flat out, with no faults.
+ **/
+void
+esk8_ps2_sim_cnfg_default(
+    esk8_ps2_sim_cnfg_t* cnfg
+);
+
+/**
+ * Hooks the device to the two pins and
+ * starts its thread. It waits for a reset
+ * or commands, like a freshly plugged one.
+ **/
+int
+esk8_ps2_sim_start(
+    esk8_ps2_sim_t*            sim,
+    const esk8_ps2_sim_cnfg_t* cnfg,
+    int                        clock_pin,
+    int                        data_pin,
+    uint32_t                   seed
+);
+
+/**
+ * Stops the device thread, and lets go
+ * of both lines.
+ **/
+void
+esk8_ps2_sim_stop(
+    esk8_ps2_sim_t* sim
+);
+
+/**
+ * Pulls the device out, and plugs it back
+ * in after `off_ms`. It then announces itself
+ * like on power up, with 0xAA 0x00.
+ **/
+void
+esk8_ps2_sim_unplug(
+    esk8_ps2_sim_t* sim,
+    uint32_t        off_ms
+);
+
+/**
+ * Whether the device is done sending the
+ * `max_pkts` packets it was asked for.
+ **/
+bool
+esk8_ps2_sim_done(
+    esk8_ps2_sim_t* sim
+);
+
+#endif /* _ESK8_PS2_SIM_H */
@@ -0,0 +1,473 @@
+#include <esk8_config.h>
+#include <esk8_err.h>
+#include <esk8_hist.h>
+#include <esk8_ps2.h>
+#include <esk8_ps2_priv.h>
+#include <esk8_ps2_sim.h>
+
+#include <driver/gpio.h>
+#include <esp_timer.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#define BENCH_CLOCK_PIN     23
+#define BENCH_DATA_PIN      22
+#define BENCH_RX_TIMEOUT_MS 200     /* Also how long a finished stream is waited on */
+#define BENCH_MAX_SYNCS     8
+#define BENCH_PLUG_WAIT_MS  2000    /* The remote's probe, shorter */
+
+/**
+ * Runs the real PS/2 ISR and driver against a
+ * virtual device, bit by bit, one scenario at
+ * a time, and reports how long negotiation took,
+ * packets per second through the ISR ring, how
+ * long a packet took from the ISR to the task,
+ * and what an ISR call costs per clock edge.
+ * The plug scenarios report how long after the
+ * device announced itself the first packet came:
+ *
+ *   $ esk8_ps2_sim_bench [-n packets] [-w wave.csv] [scenario]...
+ *   $ esk8_ps2_sim_bench -r wave.csv [-p std|imps|syn]
+ *
+ * `-w` records the clock and data lines of the
+ * scenario as `t_us,clk,data` rows, `-r` feeds
+ * such a capture, from the sim or a logic
+ * analyser, to the ISR in movement mode and
+ * prints the packets it decodes.
+ * Each scenario runs in its own process, since
+ * the GPIO ISR stays registered.
+ **/
+
+typedef struct
+{
+    const char*          name;
+    esk8_ps2_sim_model_t model;
+    uint32_t             bit_us;    /* Clock period, 0 for flat out */
+    bool                 flood;     /* Stream back to back, not at the sample rate */
+    bool                 poll;      /* Remote mode, the bench asks for each packet */
+    float                flip_rate;
+    float                glitch_rate;
+    uint32_t             plug_ms;   /* Device absent at first, for this long */
+    uint32_t             off_ms;    /* Pulled out halfway through, for this long */
+    float                stray_rate;
+}
+bench_scenario_t;
+
+static const bench_scenario_t bench_scenarios[] = {
+    { "std-stream",     ESK8_PS2_SIM_MOUSE,     0,  false,  false,  0,      0       },
+    { "imps-stream",    ESK8_PS2_SIM_IMPS,      0,  false,  false,  0,      0       },
+    { "syn-stream",     ESK8_PS2_SIM_SYNAPTICS, 0,  false,  false,  0,      0       },
+    { "std-poll",       ESK8_PS2_SIM_MOUSE,     0,  false,  true,   0,      0       },
+    { "syn-poll",       ESK8_PS2_SIM_SYNAPTICS, 0,  false,  true,   0,      0       },
+    { "std-flood",      ESK8_PS2_SIM_MOUSE,     0,  true,   false,  0,      0       },
+    { "syn-flood",      ESK8_PS2_SIM_SYNAPTICS, 0,  true,   false,  0,      0       },
+    { "std-wire",       ESK8_PS2_SIM_MOUSE,     40, false,  false,  0,      0       },
+    { "flips",          ESK8_PS2_SIM_MOUSE,     0,  true,   false,  0.01,   0       },
+    { "glitches",       ESK8_PS2_SIM_MOUSE,     0,  true,   false,  0,      0.01    },
+    { "hotplug",        ESK8_PS2_SIM_SYNAPTICS, 0,  false,  false,  0,      0,      500     },
+    { "replug",         ESK8_PS2_SIM_MOUSE,     0,  false,  false,  0,      0,      0,  300 },
+    { "replug-poll",    ESK8_PS2_SIM_SYNAPTICS, 0,  false,  true,   0,      0,      0,  300 },
+    { "syn-misalign",   ESK8_PS2_SIM_SYNAPTICS, 0,  false,  false,  0,      0,      0,  0,  0.05 },
+};
+
+#define BENCH_SCENARIO_NUM (sizeof(bench_scenarios) / sizeof(bench_scenarios[0]))
+
+static const char* bench_proto_names[ESK8_PS2_PROTO_MAX] = {
+    "none", "std", "imps", "syn"
+};
+
+
+static int64_t
+bench_now_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ * Syncs like the remote task does: again right
+ * away when the device was reset under it, and
+ * after it plugs in when it does not answer.
+ **/
+static esk8_err_t
+bench_sync(
+    const bench_scenario_t* scn,
+    esk8_ps2_hndl_t         hndl,
+    int*                    n_syncs
+)
+{
+    esk8_err_t err;
+
+    while (1)
+    {
+        (*n_syncs)++;
+        err = scn->poll ? esk8_ps2_mvmt_sync_remote(hndl) : esk8_ps2_mvmt_sync(hndl);
+
+        if (!err || *n_syncs >= BENCH_MAX_SYNCS)
+            return err;
+
+        if (err == ESK8_PS2_ERR_DEV_RESET)
+            continue;
+
+        err = esk8_ps2_await_plug(hndl, BENCH_PLUG_WAIT_MS);
+
+        if (err)
+            return err;
+    }
+}
+
+static int
+bench_run(
+    const bench_scenario_t* scn,
+    uint32_t                n_pkts,
+    FILE*                   wave
+)
+{
+    esk8_ps2_sim_t sim = { .wave = wave };
+    esk8_ps2_sim_cnfg_t sim_cnfg;
+
+    esk8_ps2_sim_cnfg_default(&sim_cnfg);
+    sim_cnfg.model       = scn->model;
+    sim_cnfg.bit_us      = scn->bit_us;
+    sim_cnfg.flood       = scn->flood;
+    sim_cnfg.max_pkts    = scn->poll ? 0 : n_pkts;
+    sim_cnfg.abs_div     = ESK8_PS2_ABS_DIV;
+    sim_cnfg.flip_rate   = scn->flip_rate;
+    sim_cnfg.glitch_rate = scn->glitch_rate;
+    sim_cnfg.plug_ms     = scn->plug_ms;
+    sim_cnfg.stray_rate  = scn->stray_rate;
+
+    esk8_ps2_sim_start(&sim, &sim_cnfg, BENCH_CLOCK_PIN, BENCH_DATA_PIN, 0);
+
+    esk8_ps2_cnfg_t ps2_cnfg = {
+        .rx_queue_len  = ESK8_PS2_QUEUE_LENGTH,
+        .rx_timeout_ms = BENCH_RX_TIMEOUT_MS,
+        .clock_pin     = BENCH_CLOCK_PIN,
+        .data_pin      = BENCH_DATA_PIN,
+    };
+
+    esk8_ps2_hndl_t hndl;
+    esk8_err_t err = esk8_ps2_init(&hndl, &ps2_cnfg);
+
+    if (err)
+    {
+        fprintf(stderr, "%s: init failed: %s\n", scn->name, esk8_err_to_str(err));
+        return 1;
+    }
+
+    int64_t sync_us = esp_timer_get_time();
+    int n_syncs = 0;
+
+    err = bench_sync(scn, hndl, &n_syncs);
+    sync_us = esp_timer_get_time() - sync_us;
+
+    if (err)
+    {
+        fprintf(stderr, "%s: sync failed: %s\n", scn->name, esk8_err_to_str(err));
+        esk8_ps2_sim_stop(&sim);
+        return 1;
+    }
+
+    uint32_t n_recv = 0;
+    uint32_t n_errs = 0;
+    int64_t sum_x = 0;
+    int64_t sum_y = 0;
+    esk8_hist_t lat = { 0 };
+    esk8_ps2_proto_t proto = ESK8_PS2_PROTO_NONE;
+
+    int64_t start_us = esp_timer_get_time();
+    int64_t last_us  = start_us;
+    int64_t replug_us = -1;         /* Announcement to first packet */
+    bool unplugged = false;
+
+    while (!scn->poll || n_recv < n_pkts)
+    {
+        esk8_ps2_mvmt_t mvmt;
+
+        err = scn->poll ? esk8_ps2_poll_mvmt(hndl, &mvmt) : esk8_ps2_await_mvmt(hndl, &mvmt);
+
+        if (err == ESK8_PS2_ERR_TIMEOUT && esk8_ps2_sim_done(&sim))
+            break;
+
+        if  (
+                (err == ESK8_PS2_ERR_BAD_MVMT || err == ESK8_PS2_ERR_DEV_RESET ||
+                    (err && unplugged)) &&
+                n_syncs < BENCH_MAX_SYNCS
+            )
+        {
+            /* What the remote does when the stream can't be realigned */
+            err = bench_sync(scn, hndl, &n_syncs);
+            if (!err)
+                continue;
+        }
+
+        if (err)
+        {
+            if (++n_errs > 2 * BENCH_MAX_SYNCS)
+                break;
+            continue;
+        }
+
+        if (scn->off_ms && !unplugged && n_recv == n_pkts / 2)
+        {
+            esk8_ps2_sim_unplug(&sim, scn->off_ms);
+            unplugged = true;
+        }
+
+        if ((scn->plug_ms || unplugged) && replug_us < 0 && sim.stats.n_plugs)
+            replug_us = bench_now_us() - sim.stats.plug_us;
+
+        esk8_hist_add(&lat, esp_timer_get_time() - mvmt.t_us);
+
+        n_recv++;
+        sum_x += mvmt.x;
+        sum_y += mvmt.y;
+        proto  = mvmt.proto;
+        last_us = esp_timer_get_time();
+    }
+
+    esk8_ps2_sim_stop(&sim);
+
+    esk8_ps2_stats_t stats;
+    esk8_ps2_get_stats(hndl, &stats);
+
+    const esk8_ps2_sim_stats_t* dev = &sim.stats;
+    double secs = (last_us - start_us) / 1e6;
+    bool faults = scn->flip_rate > 0 || scn->glitch_rate > 0;
+    bool match  = sum_x == dev->sum_x && sum_y == dev->sum_y && n_recv == dev->n_pkts;
+
+    printf("%-12s %5s %8.1f %9.1f %7u %7u %6s %8.0f %8u %6u %6u %6u %6u %6u\n",
+        scn->name,
+        bench_proto_names[proto],
+        sync_us / 1000.0,
+        secs > 0 ? n_recv / secs : 0.0,
+        (unsigned)(dev->n_pkts + dev->n_faulty),
+        (unsigned)n_recv,
+        faults ? "n/a" : match ? "ok" : "BAD",
+        dev->n_edges ? (double)dev->isr_ns / dev->n_edges : 0.0,
+        (unsigned)dev->isr_max_ns,
+        (unsigned)stats.n_resync,
+        (unsigned)stats.n_fallback,
+        (unsigned)stats.n_dropped,
+        (unsigned)esk8_hist_pct(&lat, 50),
+        (unsigned)esk8_hist_pct(&lat, 99));
+
+    if (n_syncs > 1 || n_errs || dev->n_aborted || dev->n_host_errs || dev->n_bad_rts)
+        printf("%12s %d syncs, %u errors, %u packets cut short, %u bad host bytes of %u, "
+            "%u bad requests to send\n", "",
+            n_syncs, (unsigned)n_errs, (unsigned)dev->n_aborted,
+            (unsigned)dev->n_host_errs, (unsigned)dev->n_cmds, (unsigned)dev->n_bad_rts);
+
+    if (dev->n_strays)
+        printf("%12s %u stray header bytes sent between packets\n", "",
+            (unsigned)dev->n_strays);
+
+    if (scn->plug_ms || scn->off_ms)
+        printf("%12s plugged in %u times, first packet %.1f ms after the announcement\n", "",
+            (unsigned)dev->n_plugs, replug_us < 0 ? -1.0 : replug_us / 1000.0);
+
+    if (!faults && !match)
+        printf("%12s motion %lld,%lld sent, %lld,%lld decoded\n", "",
+            (long long)dev->sum_x, (long long)dev->sum_y,
+            (long long)sum_x, (long long)sum_y);
+
+    fflush(stdout);
+
+    /* Dropped packets are the ring being too short, not bad decoding */
+    return !faults && !match && !stats.n_dropped ? 1 : 0;
+}
+
+/**
+ * Feeds a `t_us,clk,data` capture to the ISR,
+ * one rising clock edge at a time, with the
+ * driver already in movement mode.
+ **/
+static int
+bench_replay(
+    const char*      path,
+    esk8_ps2_proto_t proto
+)
+{
+    FILE* f = fopen(path, "r");
+    if (!f)
+    {
+        perror(path);
+        return 1;
+    }
+
+    esk8_ps2_cnfg_t ps2_cnfg = {
+        .rx_queue_len  = ESK8_PS2_QUEUE_LENGTH,
+        .rx_timeout_ms = 1,
+        .clock_pin     = BENCH_CLOCK_PIN,
+        .data_pin      = BENCH_DATA_PIN,
+    };
+
+    esk8_ps2_hndl_t hndl;
+    esk8_err_t err = esk8_ps2_init(&hndl, &ps2_cnfg);
+
+    if (err)
+    {
+        fprintf(stderr, "init failed: %s\n", esk8_err_to_str(err));
+        fclose(f);
+        return 1;
+    }
+
+    esk8_ps2_hndl_def_t* ps2_hndl = (esk8_ps2_hndl_def_t*)hndl;
+
+    esk8_ps2_set_proto(ps2_hndl, proto);
+    ps2_hndl->mv_task   = xTaskGetCurrentTaskHandle();
+    ps2_hndl->ps2_state = ESK8_PS2_STATE_MVMT;
+
+    char line[128];
+    int prev_clk = 1;
+    uint32_t n_edges = 0;
+    uint32_t n_pkts  = 0;
+
+    while (fgets(line, sizeof(line), f))
+    {
+        long long t_us;
+        int clk, data;
+
+        if (sscanf(line, "%lld,%d,%d", &t_us, &clk, &data) != 3)
+            continue;
+
+        esk8_shim_gpio_drive(BENCH_DATA_PIN, data);
+        esk8_shim_gpio_drive(BENCH_CLOCK_PIN, clk);
+
+        if (clk && !prev_clk)
+        {
+            esk8_shim_gpio_edge(BENCH_CLOCK_PIN);
+            n_edges++;
+        }
+
+        prev_clk = clk;
+
+        /* Keep the ring drained, a capture can hold any number of packets */
+        esk8_ps2_mvmt_t mvmt;
+        while (ps2_hndl->mv_ring.head != ps2_hndl->mv_ring.tail)
+        {
+            err = esk8_ps2_await_mvmt(hndl, &mvmt);
+            n_pkts++;
+
+            if (err)
+                printf("%10lld us  %s\n", t_us, esk8_err_to_str(err));
+            else
+                printf("%10lld us  x %4d  y %4d  z %4d  btn %d%d%d  abs %d,%d\n",
+                    t_us, mvmt.x, mvmt.y, mvmt.z,
+                    mvmt.lft_btn, mvmt.mdl_btn, mvmt.rgt_btn,
+                    mvmt.abs_x, mvmt.abs_y);
+        }
+    }
+
+    fclose(f);
+
+    esk8_ps2_stats_t stats;
+    esk8_ps2_get_stats(hndl, &stats);
+
+    printf("%u edges, %u packets, %u resyncs, %u fallbacks\n",
+        (unsigned)n_edges, (unsigned)n_pkts,
+        (unsigned)stats.n_resync, (unsigned)stats.n_fallback);
+
+    return 0;
+}
+
+int
+main(
+    int     argc,
+    char**  argv
+)
+{
+    uint32_t n_pkts = 400;
+    const char* wave_path = NULL;
+    const char* replay_path = NULL;
+    esk8_ps2_proto_t proto = ESK8_PS2_PROTO_STD;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:w:r:p:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n': n_pkts = strtoul(optarg, NULL, 0);    break;
+            case 'w': wave_path = optarg;                   break;
+            case 'r': replay_path = optarg;                 break;
+            case 'p':
+                proto = ESK8_PS2_PROTO_NONE;
+                for (int p = ESK8_PS2_PROTO_STD; p < ESK8_PS2_PROTO_MAX; p++)
+                    if (!strcmp(optarg, bench_proto_names[p]))
+                        proto = p;
+                if (proto == ESK8_PS2_PROTO_NONE)
+                {
+                    fprintf(stderr, "unknown protocol %s\n", optarg);
+                    return 1;
+                }
+                break;
+            default:
+                fprintf(stderr,
+                    "usage: %s [-n packets] [-w wave.csv] [scenario]...\n"
+                    "       %s -r wave.csv [-p std|imps|syn]\n", argv[0], argv[0]);
+                return 1;
+        }
+    }
+
+    if (replay_path)
+        return bench_replay(replay_path, proto);
+
+    if (wave_path && argc - optind != 1)
+    {
+        fprintf(stderr, "-w records a single scenario\n");
+        return 1;
+    }
+
+    FILE* wave = NULL;
+    if (wave_path && !(wave = fopen(wave_path, "w")))
+    {
+        perror(wave_path);
+        return 1;
+    }
+
+    printf("%u packets per scenario, %d reports/s asked in stream mode\n",
+        (unsigned)n_pkts, ESK8_PS2_SMPL_RATE);
+    printf("%-12s %5s %8s %9s %7s %7s %6s %8s %8s %6s %6s %6s %6s %6s\n",
+        "scenario", "proto", "sync ms", "pkt/s", "sent", "recv", "motion",
+        "isr ns", "max ns", "resync", "fallbk", "drop", "p50 us", "p99 us");
+    fflush(stdout);
+
+    int failed = 0;
+
+    for (size_t i = 0; i < BENCH_SCENARIO_NUM; i++)
+    {
+        const bench_scenario_t* scn = &bench_scenarios[i];
+        bool wanted = optind == argc;
+
+        for (int a = optind; a < argc; a++)
+            wanted |= !strcmp(argv[a], scn->name);
+
+        if (!wanted)
+            continue;
+
+        pid_t pid = fork();
+
+        if (pid == 0)
+            _exit(bench_run(scn, n_pkts, wave));
+
+        int status;
+        waitpid(pid, &status, 0);
+
+        if (!WIFEXITED(status) || WEXITSTATUS(status))
+            failed++;
+    }
+
+    if (wave)
+        fclose(wave);
+
+    return failed ? 1 : 0;
+}
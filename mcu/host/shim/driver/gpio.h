@@ -0,0 +1,138 @@
+#ifndef _ESK8_SHIM_GPIO_H
+#define _ESK8_SHIM_GPIO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef int gpio_num_t;
+
+typedef enum
+{
+    GPIO_MODE_DISABLE,
+    GPIO_MODE_INPUT,
+    GPIO_MODE_OUTPUT,
+    GPIO_MODE_OUTPUT_OD,
+    GPIO_MODE_INPUT_OUTPUT_OD,
+    GPIO_MODE_INPUT_OUTPUT,
+}
+gpio_mode_t;
+
+typedef enum
+{
+    GPIO_PULLUP_ONLY,
+    GPIO_PULLDOWN_ONLY,
+    GPIO_PULLUP_PULLDOWN,
+    GPIO_FLOATING,
+}
+gpio_pull_mode_t;
+
+typedef enum
+{
+    GPIO_DRIVE_CAP_0,
+    GPIO_DRIVE_CAP_1,
+    GPIO_DRIVE_CAP_2,
+    GPIO_DRIVE_CAP_3,
+}
+gpio_drive_cap_t;
+
+typedef enum
+{
+    GPIO_INTR_DISABLE,
+    GPIO_INTR_POSEDGE,
+    GPIO_INTR_NEGEDGE,
+    GPIO_INTR_ANYEDGE,
+}
+gpio_int_type_t;
+
+typedef void (*gpio_isr_t)(void* arg);
+
+#define ESP_INTR_FLAG_IRAM  (1 << 10)
+
+#define GPIO_NUM_0  0
+#define GPIO_NUM_1  1
+#define GPIO_NUM_2  2
+#define GPIO_NUM_3  3
+#define GPIO_NUM_4  4
+#define GPIO_NUM_5  5
+#define GPIO_NUM_6  6
+#define GPIO_NUM_7  7
+#define GPIO_NUM_8  8
+#define GPIO_NUM_9  9
+#define GPIO_NUM_10 10
+#define GPIO_NUM_11 11
+#define GPIO_NUM_12 12
+#define GPIO_NUM_13 13
+#define GPIO_NUM_14 14
+#define GPIO_NUM_15 15
+#define GPIO_NUM_16 16
+#define GPIO_NUM_17 17
+#define GPIO_NUM_18 18
+#define GPIO_NUM_19 19
+#define GPIO_NUM_20 20
+#define GPIO_NUM_21 21
+#define GPIO_NUM_22 22
+#define GPIO_NUM_23 23
+#define GPIO_NUM_24 24
+#define GPIO_NUM_25 25
+#define GPIO_NUM_26 26
+#define GPIO_NUM_27 27
+#define GPIO_NUM_28 28
+#define GPIO_NUM_29 29
+#define GPIO_NUM_30 30
+#define GPIO_NUM_31 31
+#define GPIO_NUM_32 32
+#define GPIO_NUM_33 33
+#define GPIO_NUM_34 34
+#define GPIO_NUM_35 35
+#define GPIO_NUM_36 36
+#define GPIO_NUM_37 37
+#define GPIO_NUM_38 38
+#define GPIO_NUM_39 39
+
+
+/**
+ * Every pin is an open drain line with a pull
+ * up: it reads low if the firmware drives it low
+ * as an output, or the other end pulls it low
+ * with `esk8_shim_gpio_drive()`. Interrupts only
+ * happen when the other end asks for them with
+ * `esk8_shim_gpio_edge()`.
+ **/
+int gpio_set_direction(gpio_num_t pin, gpio_mode_t mode);
+int gpio_set_level(gpio_num_t pin, uint32_t level);
+int gpio_get_level(gpio_num_t pin);
+int gpio_set_pull_mode(gpio_num_t pin, gpio_pull_mode_t pull);
+int gpio_set_drive_capability(gpio_num_t pin, gpio_drive_cap_t cap);
+int gpio_set_intr_type(gpio_num_t pin, gpio_int_type_t type);
+int gpio_intr_enable(gpio_num_t pin);
+int gpio_intr_disable(gpio_num_t pin);
+int gpio_install_isr_service(int flags);
+int gpio_isr_handler_add(gpio_num_t pin, gpio_isr_t isr, void* arg);
+int gpio_isr_handler_remove(gpio_num_t pin);
+
+
+typedef struct
+{
+    void  (*on_dir)(int pin, gpio_mode_t mode, void* ctx);
+    void*   ctx;
+}
+esk8_shim_gpio_hooks_t;
+
+/**
+ * Sets what is told when the firmware turns
+ * `pin` into an input or an output.
+ **/
+void esk8_shim_gpio_set_hooks(int pin, const esk8_shim_gpio_hooks_t* hooks);
+
+/**
+ * The other end pulls `pin` low, or lets it go.
+ **/
+void esk8_shim_gpio_drive(int pin, int level);
+
+/**
+ * Runs the ISR of `pin`, as on an edge.
+ * Returns false if it has none.
+ **/
+bool esk8_shim_gpio_edge(int pin);
+
+#endif /* _ESK8_SHIM_GPIO_H */
\ No newline at end of file
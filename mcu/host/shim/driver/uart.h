@@ -0,0 +1,90 @@
+#ifndef _ESK8_SHIM_UART_H
+#define _ESK8_SHIM_UART_H
+
+/**
+ * Host stand in for the ESP-IDF UART driver.
+ * Bytes written go to the hooks set with
+ * `esk8_shim_uart_set_hooks()`, and bytes
+ * given to `esk8_shim_uart_rx()` come out as
+ * driver events, like on the ESP32.
+ **/
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <driver/gpio.h>
+#include <esp_err.h>
+
+typedef int uart_port_t;
+
+#define UART_NUM_0          0
+#define UART_NUM_1          1
+#define UART_NUM_2          2
+#define UART_NUM_MAX        3
+
+#define UART_PIN_NO_CHANGE  (-1)
+
+typedef enum { UART_DATA_5_BITS, UART_DATA_6_BITS, UART_DATA_7_BITS, UART_DATA_8_BITS } uart_word_length_t;
+typedef enum { UART_PARITY_DISABLE, UART_PARITY_EVEN, UART_PARITY_ODD } uart_parity_t;
+typedef enum { UART_STOP_BITS_1, UART_STOP_BITS_1_5, UART_STOP_BITS_2 } uart_stop_bits_t;
+typedef enum { UART_HW_FLOWCTRL_DISABLE } uart_hw_flowcontrol_t;
+
+typedef struct
+{
+    int                     baud_rate;
+    uart_word_length_t      data_bits;
+    uart_parity_t           parity;
+    uart_stop_bits_t        stop_bits;
+    uart_hw_flowcontrol_t   flow_ctrl;
+}
+uart_config_t;
+
+typedef enum
+{
+    UART_DATA,
+    UART_BREAK,
+    UART_BUFFER_FULL,
+    UART_FIFO_OVF,
+    UART_FRAME_ERR,
+    UART_PARITY_ERR,
+    UART_EVENT_MAX,
+}
+uart_event_type_t;
+
+typedef struct
+{
+    uart_event_type_t   type;
+    size_t              size;
+    bool                timeout_flag;
+}
+uart_event_t;
+
+esp_err_t uart_param_config(uart_port_t port, const uart_config_t* cnfg);
+esp_err_t uart_set_pin(uart_port_t port, int tx, int rx, int rts, int cts);
+esp_err_t uart_driver_install(uart_port_t port, int rx_buff, int tx_buff,
+    int queue_len, QueueHandle_t* out_queue, int flags);
+esp_err_t uart_driver_delete(uart_port_t port);
+esp_err_t uart_flush_input(uart_port_t port);
+esp_err_t uart_wait_tx_done(uart_port_t port, TickType_t ticks);
+int       uart_write_bytes(uart_port_t port, const char* data, size_t len);
+int       uart_read_bytes(uart_port_t port, uint8_t* buf, uint32_t len, TickType_t ticks);
+
+
+typedef struct
+{
+    void  (*on_pins)(int port, int tx_pin, int rx_pin, void* ctx);
+    void  (*on_tx)(int port, const uint8_t* data, size_t len, void* ctx);
+    void*   ctx;
+}
+esk8_shim_uart_hooks_t;
+
+/**
+ * Sets what is on the other end of `port`.
+ **/
+void esk8_shim_uart_set_hooks(int port, const esk8_shim_uart_hooks_t* hooks);
+
+/**
+ * Bytes arriving on `port`, as if from the wire.
+ **/
+void esk8_shim_uart_rx(int port, const uint8_t* data, size_t len);
+
+#endif /* _ESK8_SHIM_UART_H */
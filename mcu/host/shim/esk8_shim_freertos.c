@@ -0,0 +1,569 @@
+#define _GNU_SOURCE
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <esp_timer.h>
+
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+
+
+/* ========================================== Time ======================================================= */
+
+static int64_t
+shim_now_us()
+{
+    static struct timespec boot = { 0 };
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    if (!boot.tv_sec && !boot.tv_nsec)
+        boot = ts;
+
+    return (ts.tv_sec - boot.tv_sec) * 1000000ll + (ts.tv_nsec - boot.tv_nsec) / 1000;
+}
+
+int64_t
+esp_timer_get_time()
+{
+    return shim_now_us();
+}
+
+TickType_t
+xTaskGetTickCount()
+{
+    return (TickType_t)(shim_now_us() / 1000 / portTICK_PERIOD_MS);
+}
+
+void
+vTaskDelay(
+    TickType_t ticks
+)
+{
+    struct timespec ts = {
+        .tv_sec  = ticks * portTICK_PERIOD_MS / 1000,
+        .tv_nsec = (ticks * portTICK_PERIOD_MS % 1000) * 1000000l,
+    };
+
+    while (nanosleep(&ts, &ts) && errno == EINTR);
+}
+
+void
+vTaskDelayUntil(
+    TickType_t* prev_wake,
+    TickType_t  period
+)
+{
+    TickType_t now = xTaskGetTickCount();
+
+    /* Like FreeRTOS, a late task runs again at once */
+    (*prev_wake) += period;
+
+    if ((int32_t)((*prev_wake) - now) > 0)
+        vTaskDelay((*prev_wake) - now);
+}
+
+/**
+ * Absolute deadline `ticks` from now, for
+ * `pthread_cond_timedwait`. NULL means forever.
+ */
+static struct timespec*
+shim_deadline(
+    TickType_t       ticks,
+    struct timespec* out_ts
+)
+{
+    if (ticks == portMAX_DELAY)
+        return NULL;
+
+    clock_gettime(CLOCK_MONOTONIC, out_ts);
+
+    int64_t ns = out_ts->tv_nsec + (int64_t)ticks * portTICK_PERIOD_MS * 1000000ll;
+    out_ts->tv_sec  += ns / 1000000000ll;
+    out_ts->tv_nsec  = ns % 1000000000ll;
+
+    return out_ts;
+}
+
+static void
+shim_cond_init(
+    pthread_cond_t* cond
+)
+{
+    pthread_condattr_t attr;
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+/**
+ * Waits on `cond` until `deadline`, or forever
+ * if it is NULL. Returns 0 once timed out.
+ */
+static int
+shim_cond_wait(
+    pthread_cond_t*         cond,
+    pthread_mutex_t*        mutex,
+    const struct timespec*  deadline
+)
+{
+    if (!deadline)
+        return pthread_cond_wait(cond, mutex) == 0;
+
+    return pthread_cond_timedwait(cond, mutex, deadline) != ETIMEDOUT;
+}
+
+static void
+shim_unlock(
+    void* mutex
+)
+{
+    pthread_mutex_unlock((pthread_mutex_t*)mutex);
+}
+
+
+/* ========================================== ISRs ======================================================= */
+
+#define SHIM_ISR_WAKE_MAX 8
+
+static __thread int             shim_isr_depth;
+static __thread pthread_cond_t* shim_isr_wakes[SHIM_ISR_WAKE_MAX];
+static __thread int             shim_isr_wake_num;
+
+/**
+ * Wakes whoever waits on `cond`. From an ISR,
+ * this waits until it returns: a task can't
+ * run halfway through an interrupt on the chip,
+ * and the firmware counts on that.
+ */
+static void
+shim_wake(
+    pthread_cond_t* cond
+)
+{
+    if (!shim_isr_depth)
+    {
+        pthread_cond_broadcast(cond);
+        return;
+    }
+
+    for (int i = 0; i < shim_isr_wake_num; i++)
+        if (shim_isr_wakes[i] == cond)
+            return;
+
+    if (shim_isr_wake_num == SHIM_ISR_WAKE_MAX)
+    {
+        pthread_cond_broadcast(cond);
+        return;
+    }
+
+    shim_isr_wakes[shim_isr_wake_num++] = cond;
+}
+
+void
+esk8_shim_isr_enter()
+{
+    shim_isr_depth++;
+}
+
+void
+esk8_shim_isr_exit()
+{
+    if (--shim_isr_depth)
+        return;
+
+    /* Waiters recheck under their mutex, waking them unlocked is fine */
+    for (int i = 0; i < shim_isr_wake_num; i++)
+        pthread_cond_broadcast(shim_isr_wakes[i]);
+
+    shim_isr_wake_num = 0;
+}
+
+
+/* ========================================== Tasks ====================================================== */
+
+typedef struct
+{
+    pthread_t       thread;
+    TaskFunction_t  fn;
+    void*           param;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+    uint32_t        notify;
+}
+shim_task_t;
+
+static __thread shim_task_t* shim_task_self = NULL;
+
+static shim_task_t*
+shim_task_new()
+{
+    shim_task_t* task = calloc(1, sizeof(shim_task_t));
+
+    if (!task)
+        return NULL;
+
+    pthread_mutex_init(&task->mutex, NULL);
+    shim_cond_init(&task->cond);
+    return task;
+}
+
+static void*
+shim_task_run(
+    void* arg
+)
+{
+    shim_task_self = (shim_task_t*)arg;
+    shim_task_self->fn(shim_task_self->param);
+    return NULL;
+}
+
+BaseType_t
+xTaskCreate(
+    TaskFunction_t  fn,
+    const char*     name,
+    uint32_t        stack,
+    void*           param,
+    UBaseType_t     prio,
+    TaskHandle_t*   out_task
+)
+{
+    shim_task_t* task = shim_task_new();
+
+    if (!task)
+        return pdFAIL;
+
+    task->fn    = fn;
+    task->param = param;
+
+    if (pthread_create(&task->thread, NULL, shim_task_run, task))
+    {
+        free(task);
+        return pdFAIL;
+    }
+
+    pthread_detach(task->thread);
+
+    if (out_task)
+        (*out_task) = task;
+
+    return pdPASS;
+}
+
+TaskHandle_t
+xTaskGetCurrentTaskHandle()
+{
+    /* Threads not made by xTaskCreate, like main(), become tasks on demand */
+    if (!shim_task_self)
+    {
+        shim_task_self = shim_task_new();
+        shim_task_self->thread = pthread_self();
+    }
+
+    return shim_task_self;
+}
+
+void
+vTaskDelete(
+    TaskHandle_t handle
+)
+{
+    shim_task_t* task = handle ? (shim_task_t*)handle : shim_task_self;
+
+    if (task == shim_task_self)
+        pthread_exit(NULL);
+
+    /* Tasks only block in cancellation points, waiting on a queue or a delay */
+    pthread_cancel(task->thread);
+}
+
+BaseType_t
+xTaskNotifyGive(
+    TaskHandle_t handle
+)
+{
+    shim_task_t* task = (shim_task_t*)handle;
+
+    pthread_mutex_lock(&task->mutex);
+    task->notify++;
+    shim_wake(&task->cond);
+    pthread_mutex_unlock(&task->mutex);
+
+    return pdPASS;
+}
+
+void
+vTaskNotifyGiveFromISR(
+    TaskHandle_t handle,
+    BaseType_t*  woken
+)
+{
+    xTaskNotifyGive(handle);
+
+    if (woken)
+        (*woken) = pdTRUE;
+}
+
+uint32_t
+ulTaskNotifyTake(
+    BaseType_t clear,
+    TickType_t ticks
+)
+{
+    struct timespec ts;
+    struct timespec* deadline = shim_deadline(ticks, &ts);
+    shim_task_t* task = xTaskGetCurrentTaskHandle();
+    uint32_t notify;
+
+    pthread_mutex_lock(&task->mutex);
+    pthread_cleanup_push(shim_unlock, &task->mutex);
+
+    while (!task->notify && shim_cond_wait(&task->cond, &task->mutex, deadline));
+
+    notify = task->notify;
+
+    if (notify)
+        task->notify = clear ? 0 : notify - 1;
+
+    pthread_cleanup_pop(1);
+    return notify;
+}
+
+
+/* ========================================== Queues ===================================================== */
+
+typedef struct
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+    QueueSetHandle_t set;           /* Told of every item sent, if in one   */
+
+    size_t          item_size;
+    size_t          len;
+    size_t          head;
+    size_t          count;
+    uint8_t         items[];
+}
+shim_queue_t;
+
+QueueHandle_t
+xQueueCreate(
+    UBaseType_t len,
+    UBaseType_t item_size
+)
+{
+    shim_queue_t* queue = calloc(1, sizeof(shim_queue_t) + len * item_size);
+
+    if (!queue)
+        return NULL;
+
+    pthread_mutex_init(&queue->mutex, NULL);
+    shim_cond_init(&queue->cond);
+
+    queue->item_size = item_size;
+    queue->len       = len;
+    return queue;
+}
+
+void
+vQueueDelete(
+    QueueHandle_t handle
+)
+{
+    shim_queue_t* queue = (shim_queue_t*)handle;
+
+    pthread_mutex_destroy(&queue->mutex);
+    pthread_cond_destroy(&queue->cond);
+    free(queue);
+}
+
+BaseType_t
+xQueueSend(
+    QueueHandle_t handle,
+    const void*   item,
+    TickType_t    ticks
+)
+{
+    struct timespec ts;
+    struct timespec* deadline = shim_deadline(ticks, &ts);
+    shim_queue_t* queue = (shim_queue_t*)handle;
+    BaseType_t sent = pdFALSE;
+
+    pthread_mutex_lock(&queue->mutex);
+    pthread_cleanup_push(shim_unlock, &queue->mutex);
+
+    while   (
+                queue->count == queue->len &&
+                ticks && shim_cond_wait(&queue->cond, &queue->mutex, deadline)
+            );
+
+    if (queue->count < queue->len)
+    {
+        size_t tail = (queue->head + queue->count) % queue->len;
+
+        if (queue->item_size)
+            memcpy(&queue->items[tail * queue->item_size], item, queue->item_size);
+
+        queue->count++;
+        shim_wake(&queue->cond);
+        sent = pdTRUE;
+
+        /* Under our mutex, so the set never lists an item not in yet */
+        if (queue->set)
+            xQueueSend(queue->set, &handle, 0);
+    }
+
+    pthread_cleanup_pop(1);
+    return sent;
+}
+
+BaseType_t
+xQueueSendFromISR(
+    QueueHandle_t handle,
+    const void*   item,
+    BaseType_t*   woken
+)
+{
+    BaseType_t sent = xQueueSend(handle, item, 0);
+
+    if (woken)
+        (*woken) = sent;
+
+    return sent;
+}
+
+BaseType_t
+xQueueReceive(
+    QueueHandle_t handle,
+    void*         out_item,
+    TickType_t    ticks
+)
+{
+    struct timespec ts;
+    struct timespec* deadline = shim_deadline(ticks, &ts);
+    shim_queue_t* queue = (shim_queue_t*)handle;
+    BaseType_t received = pdFALSE;
+
+    pthread_mutex_lock(&queue->mutex);
+    pthread_cleanup_push(shim_unlock, &queue->mutex);
+
+    while   (
+                !queue->count &&
+                ticks && shim_cond_wait(&queue->cond, &queue->mutex, deadline)
+            );
+
+    if (queue->count)
+    {
+        if (queue->item_size && out_item)
+            memcpy(out_item, &queue->items[queue->head * queue->item_size], queue->item_size);
+
+        queue->head = (queue->head + 1) % queue->len;
+        queue->count--;
+        pthread_cond_broadcast(&queue->cond);
+        received = pdTRUE;
+    }
+
+    pthread_cleanup_pop(1);
+    return received;
+}
+
+BaseType_t
+xQueueReset(
+    QueueHandle_t handle
+)
+{
+    shim_queue_t* queue = (shim_queue_t*)handle;
+
+    pthread_mutex_lock(&queue->mutex);
+    queue->head  = 0;
+    queue->count = 0;
+    pthread_cond_broadcast(&queue->cond);
+    pthread_mutex_unlock(&queue->mutex);
+
+    return pdPASS;
+}
+
+UBaseType_t
+uxQueueMessagesWaiting(
+    QueueHandle_t handle
+)
+{
+    shim_queue_t* queue = (shim_queue_t*)handle;
+
+    pthread_mutex_lock(&queue->mutex);
+    UBaseType_t count = queue->count;
+    pthread_mutex_unlock(&queue->mutex);
+
+    return count;
+}
+
+SemaphoreHandle_t
+xSemaphoreCreateBinary()
+{
+    return xQueueCreate(1, 0);
+}
+
+SemaphoreHandle_t
+xSemaphoreCreateMutex()
+{
+    SemaphoreHandle_t sem = xQueueCreate(1, 0);
+
+    if (sem)
+        xSemaphoreGive(sem);
+
+    return sem;
+}
+
+/**
+ * A set is a queue of member handles, one per
+ * item sent to a member. Like in FreeRTOS, items
+ * must only be received from a member once the
+ * set hands out its handle.
+ */
+QueueSetHandle_t
+xQueueCreateSet(
+    UBaseType_t len
+)
+{
+    return xQueueCreate(len, sizeof(QueueSetMemberHandle_t));
+}
+
+BaseType_t
+xQueueAddToSet(
+    QueueSetMemberHandle_t member,
+    QueueSetHandle_t       set
+)
+{
+    shim_queue_t* queue = (shim_queue_t*)member;
+    BaseType_t added = pdFAIL;
+
+    pthread_mutex_lock(&queue->mutex);
+
+    if (!queue->set && !queue->count)
+    {
+        queue->set = set;
+        added = pdPASS;
+    }
+
+    pthread_mutex_unlock(&queue->mutex);
+    return added;
+}
+
+QueueSetMemberHandle_t
+xQueueSelectFromSet(
+    QueueSetHandle_t set,
+    TickType_t       ticks
+)
+{
+    QueueSetMemberHandle_t member = NULL;
+
+    xQueueReceive(set, &member, ticks);
+    return member;
+}
@@ -0,0 +1,25 @@
+#include <esp_gatts_api.h>
+
+
+esp_err_t
+esp_ble_gatts_set_attr_value(
+    uint16_t       attr_handle,
+    uint16_t       length,
+    const uint8_t* value
+)
+{
+    return ESP_OK;
+}
+
+esp_err_t
+esp_ble_gatts_send_indicate(
+    esp_gatt_if_t gatts_if,
+    uint16_t      conn_id,
+    uint16_t      attr_handle,
+    uint16_t      value_len,
+    uint8_t*      value,
+    bool          need_confirm
+)
+{
+    return ESP_OK;
+}
@@ -0,0 +1,212 @@
+#include <driver/gpio.h>
+#include <esp_err.h>
+#include <freertos/FreeRTOS.h>
+
+#include <stddef.h>
+
+
+#define SHIM_GPIO_NUM 40
+
+typedef struct
+{
+    gpio_mode_t             mode;
+    uint8_t                 level;      /* What the firmware drives, as an output */
+    uint8_t                 ext_level;  /* What the other end drives, 1 is released */
+
+    gpio_isr_t              isr;
+    void*                   isr_arg;
+    esk8_shim_gpio_hooks_t  hooks;
+}
+shim_gpio_t;
+
+static shim_gpio_t shim_gpios[SHIM_GPIO_NUM] = {
+    [0 ... SHIM_GPIO_NUM - 1] = { .level = 1, .ext_level = 1 },
+};
+
+static shim_gpio_t*
+shim_gpio_get(
+    int pin
+)
+{
+    if (pin < 0 || pin >= SHIM_GPIO_NUM)
+        return NULL;
+
+    return &shim_gpios[pin];
+}
+
+
+int
+gpio_set_direction(
+    gpio_num_t  pin,
+    gpio_mode_t mode
+)
+{
+    shim_gpio_t* gpio = shim_gpio_get(pin);
+    if (!gpio)
+        return ESP_ERR_INVALID_ARG;
+
+    gpio->mode = mode;
+
+    if (gpio->hooks.on_dir)
+        gpio->hooks.on_dir(pin, mode, gpio->hooks.ctx);
+
+    return ESP_OK;
+}
+
+int
+gpio_set_level(
+    gpio_num_t pin,
+    uint32_t   level
+)
+{
+    shim_gpio_t* gpio = shim_gpio_get(pin);
+    if (!gpio)
+        return ESP_ERR_INVALID_ARG;
+
+    gpio->level = level ? 1 : 0;
+    return ESP_OK;
+}
+
+int
+gpio_get_level(
+    gpio_num_t pin
+)
+{
+    shim_gpio_t* gpio = shim_gpio_get(pin);
+    if (!gpio)
+        return 0;
+
+    bool driven = gpio->mode == GPIO_MODE_OUTPUT ||
+                  gpio->mode == GPIO_MODE_OUTPUT_OD ||
+                  gpio->mode == GPIO_MODE_INPUT_OUTPUT_OD ||
+                  gpio->mode == GPIO_MODE_INPUT_OUTPUT;
+
+    return (driven ? gpio->level : 1) & gpio->ext_level;
+}
+
+int
+gpio_set_pull_mode(
+    gpio_num_t       pin,
+    gpio_pull_mode_t pull
+)
+{
+    return shim_gpio_get(pin) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+int
+gpio_set_drive_capability(
+    gpio_num_t       pin,
+    gpio_drive_cap_t cap
+)
+{
+    return shim_gpio_get(pin) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+int
+gpio_set_intr_type(
+    gpio_num_t      pin,
+    gpio_int_type_t type
+)
+{
+    return shim_gpio_get(pin) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+int
+gpio_intr_enable(
+    gpio_num_t pin
+)
+{
+    return shim_gpio_get(pin) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+int
+gpio_intr_disable(
+    gpio_num_t pin
+)
+{
+    return shim_gpio_get(pin) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+int
+gpio_install_isr_service(
+    int flags
+)
+{
+    return ESP_OK;
+}
+
+int
+gpio_isr_handler_add(
+    gpio_num_t pin,
+    gpio_isr_t isr,
+    void*      arg
+)
+{
+    shim_gpio_t* gpio = shim_gpio_get(pin);
+    if (!gpio)
+        return ESP_ERR_INVALID_ARG;
+
+    gpio->isr_arg = arg;
+    __atomic_store_n(&gpio->isr, isr, __ATOMIC_RELEASE);
+    return ESP_OK;
+}
+
+int
+gpio_isr_handler_remove(
+    gpio_num_t pin
+)
+{
+    shim_gpio_t* gpio = shim_gpio_get(pin);
+    if (!gpio)
+        return ESP_ERR_INVALID_ARG;
+
+    __atomic_store_n(&gpio->isr, NULL, __ATOMIC_RELEASE);
+    return ESP_OK;
+}
+
+
+void
+esk8_shim_gpio_set_hooks(
+    int                           pin,
+    const esk8_shim_gpio_hooks_t* hooks
+)
+{
+    shim_gpio_t* gpio = shim_gpio_get(pin);
+    if (!gpio)
+        return;
+
+    gpio->hooks = hooks ? *hooks : (esk8_shim_gpio_hooks_t){ 0 };
+}
+
+void
+esk8_shim_gpio_drive(
+    int pin,
+    int level
+)
+{
+    shim_gpio_t* gpio = shim_gpio_get(pin);
+    if (!gpio)
+        return;
+
+    gpio->ext_level = level ? 1 : 0;
+}
+
+bool
+esk8_shim_gpio_edge(
+    int pin
+)
+{
+    shim_gpio_t* gpio = shim_gpio_get(pin);
+    if (!gpio)
+        return false;
+
+    gpio_isr_t isr = __atomic_load_n(&gpio->isr, __ATOMIC_ACQUIRE);
+    if (!isr)
+        return false;
+
+    esk8_shim_isr_enter();
+    isr(gpio->isr_arg);
+    esk8_shim_isr_exit();
+
+    return true;
+}
@@ -0,0 +1,284 @@
+#include <driver/uart.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
+#include <pthread.h>
+
+
+typedef struct
+{
+    pthread_mutex_t         mutex;
+    bool                    installed;
+
+    QueueHandle_t           evt_queue;
+    esk8_shim_uart_hooks_t  hooks;
+
+    uint8_t*                rx_buff;
+    size_t                  rx_size;
+    size_t                  rx_head;
+    size_t                  rx_len;
+}
+shim_uart_t;
+
+static shim_uart_t shim_uarts[UART_NUM_MAX] = {
+    [0 ... UART_NUM_MAX - 1] = { .mutex = PTHREAD_MUTEX_INITIALIZER },
+};
+
+static shim_uart_t*
+shim_uart_get(
+    uart_port_t port
+)
+{
+    if (port < 0 || port >= UART_NUM_MAX)
+        return NULL;
+
+    return &shim_uarts[port];
+}
+
+
+esp_err_t
+uart_param_config(
+    uart_port_t             port,
+    const uart_config_t*    cnfg
+)
+{
+    return shim_uart_get(port) && cnfg ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t
+uart_set_pin(
+    uart_port_t port,
+    int         tx,
+    int         rx,
+    int         rts,
+    int         cts
+)
+{
+    shim_uart_t* uart = shim_uart_get(port);
+
+    if (!uart)
+        return ESP_ERR_INVALID_ARG;
+
+    pthread_mutex_lock(&uart->mutex);
+    esk8_shim_uart_hooks_t hooks = uart->hooks;
+    pthread_mutex_unlock(&uart->mutex);
+
+    if (hooks.on_pins)
+        hooks.on_pins(port, tx, rx, hooks.ctx);
+
+    return ESP_OK;
+}
+
+esp_err_t
+uart_driver_install(
+    uart_port_t     port,
+    int             rx_buff,
+    int             tx_buff,
+    int             queue_len,
+    QueueHandle_t*  out_queue,
+    int             flags
+)
+{
+    shim_uart_t* uart = shim_uart_get(port);
+
+    if (!uart || rx_buff <= 0)
+        return ESP_ERR_INVALID_ARG;
+
+    pthread_mutex_lock(&uart->mutex);
+
+    if (uart->installed)
+    {
+        pthread_mutex_unlock(&uart->mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uart->rx_buff   = malloc(rx_buff);
+    uart->evt_queue = queue_len ? xQueueCreate(queue_len, sizeof(uart_event_t)) : NULL;
+
+    if (!uart->rx_buff || (queue_len && !uart->evt_queue))
+    {
+        free(uart->rx_buff);
+        uart->rx_buff = NULL;
+
+        pthread_mutex_unlock(&uart->mutex);
+        return ESP_ERR_NO_MEM;
+    }
+
+    uart->rx_size   = rx_buff;
+    uart->rx_head   = 0;
+    uart->rx_len    = 0;
+    uart->installed = true;
+
+    if (out_queue)
+        (*out_queue) = uart->evt_queue;
+
+    pthread_mutex_unlock(&uart->mutex);
+    return ESP_OK;
+}
+
+esp_err_t
+uart_driver_delete(
+    uart_port_t port
+)
+{
+    shim_uart_t* uart = shim_uart_get(port);
+
+    if (!uart)
+        return ESP_ERR_INVALID_ARG;
+
+    pthread_mutex_lock(&uart->mutex);
+
+    if (uart->installed)
+    {
+        if (uart->evt_queue)
+            vQueueDelete(uart->evt_queue);
+
+        free(uart->rx_buff);
+        uart->rx_buff   = NULL;
+        uart->evt_queue = NULL;
+        uart->installed = false;
+    }
+
+    pthread_mutex_unlock(&uart->mutex);
+    return ESP_OK;
+}
+
+esp_err_t
+uart_flush_input(
+    uart_port_t port
+)
+{
+    shim_uart_t* uart = shim_uart_get(port);
+
+    if (!uart)
+        return ESP_ERR_INVALID_ARG;
+
+    pthread_mutex_lock(&uart->mutex);
+    uart->rx_head = 0;
+    uart->rx_len  = 0;
+    pthread_mutex_unlock(&uart->mutex);
+
+    return ESP_OK;
+}
+
+esp_err_t
+uart_wait_tx_done(
+    uart_port_t port,
+    TickType_t  ticks
+)
+{
+    /* Writes go straight to the hook, nothing is ever pending */
+    return shim_uart_get(port) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+int
+uart_write_bytes(
+    uart_port_t port,
+    const char* data,
+    size_t      len
+)
+{
+    shim_uart_t* uart = shim_uart_get(port);
+
+    if (!uart || !uart->installed)
+        return -1;
+
+    pthread_mutex_lock(&uart->mutex);
+    esk8_shim_uart_hooks_t hooks = uart->hooks;
+    pthread_mutex_unlock(&uart->mutex);
+
+    if (hooks.on_tx)
+        hooks.on_tx(port, (const uint8_t*)data, len, hooks.ctx);
+
+    return len;
+}
+
+int
+uart_read_bytes(
+    uart_port_t port,
+    uint8_t*    buf,
+    uint32_t    len,
+    TickType_t  ticks
+)
+{
+    shim_uart_t* uart = shim_uart_get(port);
+
+    if (!uart || !uart->installed)
+        return -1;
+
+    /* Callers only read what an event announced, so never wait */
+    pthread_mutex_lock(&uart->mutex);
+
+    size_t n = len < uart->rx_len ? len : uart->rx_len;
+
+    for (size_t i = 0; i < n; i++)
+        buf[i] = uart->rx_buff[(uart->rx_head + i) % uart->rx_size];
+
+    uart->rx_head = (uart->rx_head + n) % uart->rx_size;
+    uart->rx_len -= n;
+
+    pthread_mutex_unlock(&uart->mutex);
+    return n;
+}
+
+
+void
+esk8_shim_uart_set_hooks(
+    int                             port,
+    const esk8_shim_uart_hooks_t*   hooks
+)
+{
+    shim_uart_t* uart = shim_uart_get(port);
+
+    if (!uart)
+        return;
+
+    pthread_mutex_lock(&uart->mutex);
+
+    if (hooks)
+        uart->hooks = *hooks;
+    else
+        memset(&uart->hooks, 0, sizeof(uart->hooks));
+
+    pthread_mutex_unlock(&uart->mutex);
+}
+
+void
+esk8_shim_uart_rx(
+    int             port,
+    const uint8_t*  data,
+    size_t          len
+)
+{
+    shim_uart_t* uart = shim_uart_get(port);
+
+    if (!uart || !len)
+        return;
+
+    pthread_mutex_lock(&uart->mutex);
+
+    if (!uart->installed)
+    {
+        pthread_mutex_unlock(&uart->mutex);
+        return;
+    }
+
+    /* Like the driver, bytes that do not fit are lost, and the reader is told */
+    uart_event_t evt = { .type = UART_DATA, .size = len };
+
+    if (uart->rx_len + len > uart->rx_size)
+    {
+        evt.type = UART_BUFFER_FULL;
+        len = uart->rx_size - uart->rx_len;
+    }
+
+    for (size_t i = 0; i < len; i++)
+        uart->rx_buff[(uart->rx_head + uart->rx_len + i) % uart->rx_size] = data[i];
+
+    uart->rx_len += len;
+
+    if (uart->evt_queue)
+        xQueueSend(uart->evt_queue, &evt, 0);
+
+    pthread_mutex_unlock(&uart->mutex);
+}
@@ -0,0 +1,75 @@
+#ifndef _ESK8_SHIM_ESP_GATTS_API_H
+#define _ESK8_SHIM_ESP_GATTS_API_H
+
+/**
+ * Just enough of the Bluedroid GATT server
+ * API for the BLE app helpers to build.
+ * Attribute writes and indications go nowhere.
+ **/
+
+#include <esp_err.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef uint8_t esp_gatt_if_t;
+
+typedef enum
+{
+    ESP_GATTS_REG_EVT,
+    ESP_GATTS_READ_EVT,
+    ESP_GATTS_WRITE_EVT,
+    ESP_GATTS_CONNECT_EVT,
+    ESP_GATTS_DISCONNECT_EVT,
+}
+esp_gatts_cb_event_t;
+
+typedef union
+{
+    struct { uint16_t conn_id; uint16_t handle; uint16_t len; uint8_t* value; } write;
+    struct { uint16_t conn_id; } connect;
+    struct { uint16_t conn_id; } disconnect;
+}
+esp_ble_gatts_cb_param_t;
+
+typedef struct
+{
+    uint8_t auto_rsp;
+}
+esp_attr_control_t;
+
+typedef struct
+{
+    uint16_t uuid_length;
+    uint8_t* uuid_p;
+    uint16_t perm;
+    uint16_t max_length;
+    uint16_t length;
+    uint8_t* value;
+}
+esp_attr_desc_t;
+
+typedef struct
+{
+    esp_attr_control_t attr_control;
+    esp_attr_desc_t    att_desc;
+}
+esp_gatts_attr_db_t;
+
+esp_err_t esp_ble_gatts_set_attr_value(
+    uint16_t       attr_handle,
+    uint16_t       length,
+    const uint8_t* value
+);
+
+esp_err_t esp_ble_gatts_send_indicate(
+    esp_gatt_if_t gatts_if,
+    uint16_t      conn_id,
+    uint16_t      attr_handle,
+    uint16_t      value_len,
+    uint8_t*      value,
+    bool          need_confirm
+);
+
+#endif /* _ESK8_SHIM_ESP_GATTS_API_H */
@@ -0,0 +1,12 @@
+#ifndef _ESK8_SHIM_ESP_LOG_H
+#define _ESK8_SHIM_ESP_LOG_H
+
+#include <stdio.h>
+
+/* The firmware logs through esk8_log, these are only here to build */
+#define ESP_LOGE(tag, fmt, ...) fprintf(stderr, "E (%s) " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) fprintf(stderr, "W (%s) " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) do { } while (0)
+#define ESP_LOGD(tag, fmt, ...) do { } while (0)
+
+#endif /* _ESK8_SHIM_ESP_LOG_H */
@@ -0,0 +1,47 @@
+#ifndef _ESK8_SHIM_FREERTOS_H
+#define _ESK8_SHIM_FREERTOS_H
+
+/**
+ * Host stand in for the bits of FreeRTOS the
+ * firmware uses, on top of pthreads.
+ * One tick is one millisecond.
+ **/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef int         BaseType_t;
+typedef unsigned    UBaseType_t;
+typedef uint32_t    TickType_t;
+
+typedef void*       QueueHandle_t;
+typedef void*       SemaphoreHandle_t;
+typedef void*       TaskHandle_t;
+typedef void*       QueueSetHandle_t;
+typedef void*       QueueSetMemberHandle_t;
+
+#define portTICK_PERIOD_MS  1
+#define portMAX_DELAY       ((TickType_t)0xffffffff)
+#define pdMS_TO_TICKS(ms)   ((TickType_t)(ms) / portTICK_PERIOD_MS)
+
+#define pdFALSE             0
+#define pdTRUE              1
+#define pdFAIL              0
+#define pdPASS              1
+
+#define IRAM_ATTR
+#define portYIELD_FROM_ISR() do { } while (0)
+
+/**
+ * Host only. Whatever runs as an ISR goes
+ * between these, so the tasks it wakes only
+ * run once it is done, as on the chip.
+ **/
+void esk8_shim_isr_enter(void);
+void esk8_shim_isr_exit(void);
+
+#endif /* _ESK8_SHIM_FREERTOS_H */
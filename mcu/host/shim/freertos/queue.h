@@ -0,0 +1,23 @@
+#ifndef _ESK8_SHIM_QUEUE_H
+#define _ESK8_SHIM_QUEUE_H
+
+#include <freertos/FreeRTOS.h>
+
+QueueHandle_t xQueueCreate(UBaseType_t len, UBaseType_t item_size);
+void          vQueueDelete(QueueHandle_t queue);
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks);
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void* item, BaseType_t* woken);
+BaseType_t xQueueReceive(QueueHandle_t queue, void* out_item, TickType_t ticks);
+BaseType_t xQueueReset(QueueHandle_t queue);
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+
+/* Queue sets, as with configUSE_QUEUE_SETS */
+QueueSetHandle_t       xQueueCreateSet(UBaseType_t len);
+BaseType_t             xQueueAddToSet(QueueSetMemberHandle_t member, QueueSetHandle_t set);
+QueueSetMemberHandle_t xQueueSelectFromSet(QueueSetHandle_t set, TickType_t ticks);
+
+#define xQueueSendToBack xQueueSend
+
+#endif /* _ESK8_SHIM_QUEUE_H */
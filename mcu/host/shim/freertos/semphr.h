@@ -0,0 +1,16 @@
+#ifndef _ESK8_SHIM_SEMPHR_H
+#define _ESK8_SHIM_SEMPHR_H
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
+/* Semaphores are queues of empty items, as in FreeRTOS */
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+
+#define xSemaphoreTake(sem, ticks)          xQueueReceive((sem), NULL, (ticks))
+#define xSemaphoreGive(sem)                 xQueueSend((sem), NULL, 0)
+#define xSemaphoreGiveFromISR(sem, woken)   xQueueSendFromISR((sem), NULL, (woken))
+#define vSemaphoreDelete(sem)               vQueueDelete(sem)
+
+#endif /* _ESK8_SHIM_SEMPHR_H */
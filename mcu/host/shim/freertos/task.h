@@ -0,0 +1,23 @@
+#ifndef _ESK8_SHIM_TASK_H
+#define _ESK8_SHIM_TASK_H
+
+#include <freertos/FreeRTOS.h>
+
+typedef void (*TaskFunction_t)(void* param);
+
+/* Stack size and priority are ignored, every task is a thread */
+BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stack,
+    void* param, UBaseType_t prio, TaskHandle_t* out_task);
+
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t* prev_wake, TickType_t period);
+
+TickType_t   xTaskGetTickCount(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+void       vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* woken);
+uint32_t   ulTaskNotifyTake(BaseType_t clear, TickType_t ticks);
+
+#endif /* _ESK8_SHIM_TASK_H */
@@ -1,5 +1,6 @@
 #include <esk8_log.h>
 #include <esk8_bms.h>
+#include <esk8_esc.h>
 #include <esk8_ble_apps.h>
 #include <esk8_ble_apps_util.h>
 
@@ -25,6 +26,14 @@ static uint16_t SRVC_STATUS_BMS_DEEP_UUID                   = 0xE8E3;
 static esk8_bms_deep_status_t SRVC_STATUS_BMS_DEEP_VAL[ESK8_UART_BMS_CONF_NUM]   = {0};
 static uint16_t SRVC_STATUS_BMS_DEEP_DESC                   = 0x0000;
 
+static uint16_t SRVC_STATUS_BMS_HEALTH_UUID                 = 0xE8E4;
+static esk8_bms_health_t SRVC_STATUS_BMS_HEALTH_VAL[ESK8_UART_BMS_CONF_NUM]      = {0};
+static uint16_t SRVC_STATUS_BMS_HEALTH_DESC                 = 0x0000;
+
+static uint16_t SRVC_STATUS_ESC_UUID                        = 0xE8E5;
+static esk8_esc_telemetry_t SRVC_STATUS_ESC_VAL             = {0};
+static uint16_t SRVC_STATUS_ESC_DESC                        = 0x0000;
+
 static uint16_t SRVC_UUID_PRIMARY                           = ESP_GATT_UUID_PRI_SERVICE;
 static uint16_t CHAR_UUID_DECLARE                           = ESP_GATT_UUID_CHAR_DECLARE;
 static uint16_t CHAR_UUID_CONFIG                            = ESP_GATT_UUID_CHAR_CLIENT_CONFIG;
@@ -46,6 +55,12 @@ enum
     SRVC_IDX_STATUS_BMS_DEEP_CHAR,
     SRVC_IDX_STATUS_BMS_DEEP_CHAR_VAL,
     SRVC_IDX_STATUS_BMS_DEEP_DESC, /* CCCD */
+    SRVC_IDX_STATUS_BMS_HEALTH_CHAR,
+    SRVC_IDX_STATUS_BMS_HEALTH_CHAR_VAL,
+    SRVC_IDX_STATUS_BMS_HEALTH_DESC, /* CCCD */
+    SRVC_IDX_STATUS_ESC_CHAR,
+    SRVC_IDX_STATUS_ESC_CHAR_VAL,
+    SRVC_IDX_STATUS_ESC_DESC, /* CCCD */
 
     SRVC_STATUS_NUM_ATTR
 };
@@ -130,6 +145,54 @@ static esp_gatts_attr_db_t srvc_status_attr_list[] =
             ESP_UUID_LEN_16, (uint8_t*)&CHAR_UUID_CONFIG, ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE,
             sizeof(SRVC_STATUS_BMS_DEEP_DESC), sizeof(SRVC_STATUS_BMS_DEEP_DESC), (uint8_t*)&SRVC_STATUS_BMS_DEEP_DESC
         },
+    },
+
+    [SRVC_IDX_STATUS_BMS_HEALTH_CHAR]  = {
+        {ESP_GATT_AUTO_RSP},
+        {
+            ESP_UUID_LEN_16, (uint8_t*)&CHAR_UUID_DECLARE, ESP_GATT_PERM_READ,
+            sizeof(uint8_t), sizeof(uint8_t), &CHAR_PROP_READ_NOTIFY
+        },
+    },
+
+    [SRVC_IDX_STATUS_BMS_HEALTH_CHAR_VAL]  = {
+        {ESP_GATT_AUTO_RSP},
+        {
+            ESP_UUID_LEN_16, (uint8_t*)&SRVC_STATUS_BMS_HEALTH_UUID, ESP_GATT_PERM_READ,
+            sizeof(SRVC_STATUS_BMS_HEALTH_VAL), sizeof(SRVC_STATUS_BMS_HEALTH_VAL), (uint8_t*)SRVC_STATUS_BMS_HEALTH_VAL
+        },
+    },
+
+    [SRVC_IDX_STATUS_BMS_HEALTH_DESC]  = {
+        {ESP_GATT_AUTO_RSP},
+        {
+            ESP_UUID_LEN_16, (uint8_t*)&CHAR_UUID_CONFIG, ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE,
+            sizeof(SRVC_STATUS_BMS_HEALTH_DESC), sizeof(SRVC_STATUS_BMS_HEALTH_DESC), (uint8_t*)&SRVC_STATUS_BMS_HEALTH_DESC
+        },
+    },
+
+    [SRVC_IDX_STATUS_ESC_CHAR]  = {
+        {ESP_GATT_AUTO_RSP},
+        {
+            ESP_UUID_LEN_16, (uint8_t*)&CHAR_UUID_DECLARE, ESP_GATT_PERM_READ,
+            sizeof(uint8_t), sizeof(uint8_t), &CHAR_PROP_READ_NOTIFY
+        },
+    },
+
+    [SRVC_IDX_STATUS_ESC_CHAR_VAL]  = {
+        {ESP_GATT_AUTO_RSP},
+        {
+            ESP_UUID_LEN_16, (uint8_t*)&SRVC_STATUS_ESC_UUID, ESP_GATT_PERM_READ,
+            sizeof(SRVC_STATUS_ESC_VAL), sizeof(SRVC_STATUS_ESC_VAL), (uint8_t*)&SRVC_STATUS_ESC_VAL
+        },
+    },
+
+    [SRVC_IDX_STATUS_ESC_DESC]  = {
+        {ESP_GATT_AUTO_RSP},
+        {
+            ESP_UUID_LEN_16, (uint8_t*)&CHAR_UUID_CONFIG, ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE,
+            sizeof(SRVC_STATUS_ESC_DESC), sizeof(SRVC_STATUS_ESC_DESC), (uint8_t*)&SRVC_STATUS_ESC_DESC
+        },
     }
 
 };
@@ -255,12 +318,77 @@ esk8_ble_app_status_bms_deep(
     return err_code;
 }
 
+esk8_err_t
+esk8_ble_app_status_bms_health(
+    esk8_bms_health_t* health,
+    esk8_err_t         bms_err_code,
+    int                bms_idx
+)
+{
+    SRVC_STATUS_BMS_HEALTH_VAL[bms_idx] = (*health);
+
+    esk8_ble_apps_update(
+        &esk8_app_srvc_status,
+        SRVC_IDX_STATUS_BMS_HEALTH_CHAR_VAL,
+        sizeof(SRVC_STATUS_BMS_HEALTH_VAL),
+        (uint8_t*)SRVC_STATUS_BMS_HEALTH_VAL
+    );
+
+    size_t msg_size = sizeof(esk8_err_t) + sizeof(int);
+    uint8_t* msg = malloc(msg_size);
+
+    if (!msg)
+        return ESK8_ERR_OOM;
+
+    *((esk8_err_t*)msg) = bms_err_code;
+    *((int*)&msg[sizeof(esk8_err_t)]) = bms_idx;
+
+    esk8_err_t err_code = esk8_ble_apps_notify_all(
+        &esk8_app_srvc_status,
+        SRVC_IDX_STATUS_BMS_HEALTH_CHAR_VAL,
+        msg_size, msg
+        );
+
+    free(msg);
+    return err_code;
+}
+
+esk8_err_t
+esk8_ble_app_status_esc(
+    const esk8_esc_telemetry_t* telemetry,
+    esk8_err_t                  esc_err_code
+)
+{
+    SRVC_STATUS_ESC_VAL = (*telemetry);
+
+    esk8_ble_apps_update(
+        &esk8_app_srvc_status,
+        SRVC_IDX_STATUS_ESC_CHAR_VAL,
+        sizeof(SRVC_STATUS_ESC_VAL),
+        (uint8_t*)&SRVC_STATUS_ESC_VAL
+    );
+
+    /* Sent many times a second, so the values ride along, no read needed */
+    uint8_t msg[sizeof(esk8_err_t) + sizeof(esk8_esc_telemetry_t)];
+
+    memcpy(msg, &esc_err_code, sizeof(esk8_err_t));
+    memcpy(&msg[sizeof(esk8_err_t)], telemetry, sizeof(esk8_esc_telemetry_t));
+
+    return esk8_ble_apps_notify_all(
+        &esk8_app_srvc_status,
+        SRVC_IDX_STATUS_ESC_CHAR_VAL,
+        sizeof(msg), msg
+    );
+}
+
 static void
 app_init()
 {
     esk8_log_D(ESK8_TAG_BLE, "app_init()\n");
     memset(SRVC_STATUS_BMS_SHALLOW_VAL, 0, sizeof(SRVC_STATUS_BMS_SHALLOW_VAL));
     memset(SRVC_STATUS_BMS_DEEP_VAL   , 0, sizeof(SRVC_STATUS_BMS_DEEP_VAL   ));
+    memset(SRVC_STATUS_BMS_HEALTH_VAL , 0, sizeof(SRVC_STATUS_BMS_HEALTH_VAL ));
+    memset(&SRVC_STATUS_ESC_VAL       , 0, sizeof(SRVC_STATUS_ESC_VAL       ));
 }
 
 static void
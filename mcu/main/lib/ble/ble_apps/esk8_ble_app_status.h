@@ -2,6 +2,8 @@
 #define _ESK8_BLE_APP_STATUS_H
 
 #include <esk8_err.h>
+#include <esk8_bms.h>
+#include <esk8_esc.h>
 
 
 esk8_err_t
@@ -23,4 +25,17 @@ esk8_ble_app_status_bms_deep(
     int                     bms_idx
 );
 
+esk8_err_t
+esk8_ble_app_status_bms_health(
+    esk8_bms_health_t* health,
+    esk8_err_t         bms_err_code,
+    int                bms_idx
+);
+
+esk8_err_t
+esk8_ble_app_status_esc(
+    const esk8_esc_telemetry_t* telemetry,
+    esk8_err_t                  esc_err_code
+);
+
 #endif /* _ESK8_BLE_APP_STATUS_H */
\ No newline at end of file
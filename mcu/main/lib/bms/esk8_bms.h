@@ -3,6 +3,7 @@
 
 #include <esk8_config.h>
 #include <esk8_uart.h>
+#include <esk8_uart_bus.h>
 #include <esk8_err.h>
 
 #include <driver/uart.h>
@@ -37,16 +38,78 @@ typedef struct __attribute__((__packed__))
 }
 esk8_bms_deep_status_t;
 
-typedef void (*esk8_bms_cb_t)(esk8_bms_status_t* status, uint8_t nStatus);
+/**
+ * Circuit breaker state of a pack's link.
+ * CLOSED packs are asked as usual. OPEN packs
+ * failed too often, and requests for them fail
+ * right away until the backoff ends. Then the
+ * pack is HALF_OPEN, and gets a single try.
+ **/
+typedef enum
+{
+    ESK8_BMS_LINK_CLOSED,
+    ESK8_BMS_LINK_OPEN,
+    ESK8_BMS_LINK_HALF_OPEN,
+}
+esk8_bms_link_state_t;
+
+/**
+ * Link health of a pack. Round trip times leave
+ * out the wire time of the reply, so reads of
+ * any size can be compared. Each read waits
+ * `rto_us` for its reply, plus its wire time.
+ **/
+typedef struct __attribute__((__packed__))
+{
+    uint8_t  state;         // esk8_bms_link_state_t
+    uint8_t  fails;         // Failed requests in a row
+    uint16_t backoff_ms;    // Current wait between probes
+    uint32_t fast_fails;    // Requests failed without using the bus
+    uint32_t srtt_us;       // Smoothed round trip time, 0 until measured
+    uint32_t rttvar_us;     // Round trip time variation
+    uint32_t rto_us;        // Current reply timeout
+}
+esk8_bms_health_t;
+
+typedef struct esk8_bms_req esk8_bms_req_t;
+
+/**
+ * Called by the BMS worker once `req` is done.
+ * `err` is `ESK8_OK` if every value asked for
+ * was read into the request's structs.
+ * Runs on the worker task, keep it short.
+ **/
+typedef void (*esk8_bms_cb_t)(const esk8_bms_req_t* req, esk8_err_t err);
+
+/**
+ * A read of some BMS values, for one pack.
+ * `fields` is a `esk8_bms_field_mask_t`, see
+ * `esk8_bms_fields.h`. Values land in `status`
+ * and `deep_status`, which must stay valid until
+ * `cb` is called. `ctx` is left for the caller.
+ * `bus_us` is set by the worker, to the time
+ * the request held the bus.
+ **/
+struct esk8_bms_req
+{
+    uint8_t                 pack;
+    uint32_t                fields;
+    esk8_bms_status_t*      status;
+    esk8_bms_deep_status_t* deep_status;
+    esk8_bms_cb_t           cb;
+    void*                   ctx;
+    uint32_t                bus_us;
+};
 
 typedef struct
 {
     int                 uart_port;
+    int*                uart_ports;     // UART of each pack, or NULL for all on `uart_port`
     uint8_t             bat_num;
     uint8_t*            rx_pins;
     uint8_t*            tx_pins;
-    uint8_t             tx_pin;
     uint32_t            bms_update_ms;
+    uint8_t             sniff;          // Another master polls the packs, serve what it reads
 }
 esk8_bms_config_t;
 
@@ -59,10 +122,17 @@ esk8_bms_init(
     esk8_bms_hndl_t* out_hndl
 );
 
+/**
+ * Stops the workers, once the requests in
+ * flight are done, and lets go of the UARTs.
+ * Requests still queued are called back with
+ * `ESK8_BMS_ERR_STOPPED`, so nothing calls
+ * back once this returns. Nothing may be
+ * submitted meanwhile. `hndl` is freed.
+ **/
 esk8_err_t
-esk8_bms_set_pin(
-    esk8_bms_hndl_t* hndl,
-    uint8_t pin
+esk8_bms_deinit(
+    esk8_bms_hndl_t hndl
 );
 
 /**
@@ -75,29 +145,81 @@ esk8_bms_init_from_config_h(
 );
 
 /**
- * Asks the active BMS for all the useful
- * registers, and updates `outStatus`.
+ * Queues `req` for the BMS worker, and returns
+ * right away. The request is copied.
+ * Returns `ESK8_BMS_ERR_QUEUE_FULL` if the
+ * worker is too far behind to take it.
+ **/
+esk8_err_t
+esk8_bms_submit(
+    esk8_bms_hndl_t hndl,
+    const esk8_bms_req_t* req
+);
+
+/**
+ * Copies the link health of `pack` into
+ * `out_health`.
+ **/
+esk8_err_t
+esk8_bms_get_health(
+    esk8_bms_hndl_t hndl,
+    uint8_t pack,
+    esk8_bms_health_t *out_health
+);
+
+/**
+ * Copies the bus use of the reads of `pack`,
+ * since init, into `out_stats`. Packs on a
+ * UART shared with the ESC show what each
+ * of them takes from it.
+ **/
+esk8_err_t
+esk8_bms_get_bus_stats(
+    esk8_bms_hndl_t hndl,
+    uint8_t pack,
+    esk8_uart_bus_stats_t *out_stats
+);
+
+/**
+ * Asks the BMS at `pack` for all the useful
+ * registers, and updates `out_status`.
  * This function waits for all the
- * responses.
- * Returns `ESK8_BMS_SUCCESS` on
- * success, anything else on error.
+ * responses. Do not call it from a
+ * `esk8_bms_cb_t`.
+ * Returns `ESK8_OK` on success,
+ * anything else on error.
  **/
 esk8_err_t
 esk8_bms_get_status(
     esk8_bms_hndl_t hndl,
+    uint8_t pack,
     esk8_bms_status_t *out_status
 );
 
 /**
- * Reads the pack's deep status.
+ * Reads the deep status of the BMS at `pack`.
  * Takes a while, and the result is stored
  * in `out_status`.
  **/
 esk8_err_t
 esk8_bms_get_deep_status(
     esk8_bms_hndl_t hndl,
+    uint8_t pack,
     esk8_bms_deep_status_t *out_status
 );
 
+/**
+ * Reads both the status and the deep status.
+ * Overlapping registers are read once, so this
+ * takes fewer requests than reading them apart.
+ **/
+esk8_err_t
+esk8_bms_get_full_status(
+    esk8_bms_hndl_t hndl,
+    uint8_t pack,
+    esk8_bms_status_t *out_status,
+    esk8_bms_deep_status_t *out_deep_status
+);
+
 
 #endif /* _ESK8_BMS_H */
@@ -0,0 +1,45 @@
+#include <esk8_config.h>
+#include <esk8_bms.h>
+#include <esk8_bms_fields.h>
+
+#include <stddef.h>
+
+
+#define FIELD_TYPE(dst)         ESK8_BMS_DST_TYPE_##dst
+#define FIELD_SIZE(dst, field)  sizeof(((FIELD_TYPE(dst)*)0)->field)
+
+/**
+ * A field must fit in its struct, must not split a
+ * member, and must fit in a single read.
+ */
+#define FIELD_CHECK(name, dst, field, reg, width, refresh, ...)                     \
+    _Static_assert(                                                                 \
+        offsetof(FIELD_TYPE(dst), field) + (width) <= sizeof(FIELD_TYPE(dst)),      \
+        "BMS field " #name " overruns its struct");                                 \
+    _Static_assert(                                                                 \
+        (width) > 0 && (width) % FIELD_SIZE(dst, field) == 0,                       \
+        "BMS field " #name " width does not match its member");                     \
+    _Static_assert(                                                                 \
+        (width) <= ESK8_UART_BMS_PLAN_MAX_READ,                                     \
+        "BMS field " #name " does not fit in one read");
+
+ESK8_BMS_FIELD_TABLE(FIELD_CHECK)
+
+_Static_assert(
+    ESK8_BMS_FIELD_MAX <= sizeof(esk8_bms_field_mask_t) * 8,
+    "Too many BMS fields for esk8_bms_field_mask_t");
+
+/* Parameters renamed, so they do not clash with the designators */
+#define FIELD_DESC(name, dst_, field_, reg_, width_, refresh_, ...)                \
+    [ESK8_BMS_FIELD_##name] = {                                                     \
+        .reg        = (reg_),                                                       \
+        .width      = (width_),                                                     \
+        .dst        = ESK8_BMS_DST_##dst_,                                          \
+        .offset     = offsetof(FIELD_TYPE(dst_), field_),                           \
+        .refresh    = ESK8_BMS_REFRESH_##refresh_,                                  \
+    },
+
+const esk8_bms_field_t
+esk8_bms_fields[ESK8_BMS_FIELD_MAX] = {
+    ESK8_BMS_FIELD_TABLE(FIELD_DESC)
+};
@@ -0,0 +1,127 @@
+#ifndef _ESK8_BMS_FIELDS_H
+#define _ESK8_BMS_FIELDS_H
+
+#include <esk8_uart.h>
+#include <esk8_bms.h>
+
+#include <stdint.h>
+#include <stddef.h>
+
+
+/**
+ * How often a value is worth reading.
+ * Values are bits, so classes can be
+ * combined into a mask.
+ */
+typedef enum
+{
+    ESK8_BMS_REFRESH_FAST   = 1 << 0,   /* Changes every ride second */
+    ESK8_BMS_REFRESH_MEDIUM = 1 << 1,   /* Changes over minutes */
+    ESK8_BMS_REFRESH_SLOW   = 1 << 2,   /* Changes over charge cycles */
+    ESK8_BMS_REFRESH_ONCE   = 1 << 3,   /* Identity, never changes */
+
+    ESK8_BMS_REFRESH_ALL    = 0x0F,
+}
+esk8_bms_refresh_t;
+
+/**
+ * Which struct a value lands in.
+ * Also bits, like the refresh classes.
+ */
+typedef enum
+{
+    ESK8_BMS_DST_STATUS     = 1 << 0,   /* esk8_bms_status_t */
+    ESK8_BMS_DST_DEEP       = 1 << 1,   /* esk8_bms_deep_status_t */
+
+    ESK8_BMS_DST_ALL        = 0x03,
+}
+esk8_bms_dst_t;
+
+#define ESK8_BMS_DST_TYPE_STATUS    esk8_bms_status_t
+#define ESK8_BMS_DST_TYPE_DEEP      esk8_bms_deep_status_t
+
+/**
+ * Every value read from the BMS, as
+ * X(name, dst, field, register, width, refresh, ...).
+ *
+ * `width` is in bytes, and may span several
+ * struct members when the BMS packs them in one
+ * register. Everything else (descriptors, field
+ * masks, read plans, size checks) is derived
+ * from this list. Order does not matter.
+ * Extra arguments are handed to every `X`.
+ */
+#define ESK8_BMS_FIELD_TABLE(X, ...)                                                                                    \
+    X(CAPACITY,         STATUS, capacity,               ESK8_REG_BMS_CAPACITY,              2,  MEDIUM, __VA_ARGS__)    \
+    X(VOLTAGE,          STATUS, voltage,                ESK8_REG_BMS_VOLTAGE,               2,  FAST,   __VA_ARGS__)    \
+    X(CURRENT,          STATUS, current,                ESK8_REG_BMS_CURRENT,               2,  FAST,   __VA_ARGS__)    \
+    X(TEMPRTR,          STATUS, temperature1,           ESK8_REG_BMS_TEMPRTR,               2,  MEDIUM, __VA_ARGS__)    \
+    X(SERIAL_NUMBER,    DEEP,   serialNumber,           ESK8_REG_BMS_SERIAL_NUMBER,         14, ONCE,   __VA_ARGS__)    \
+    X(FW_VERSION,       DEEP,   firmwareVersion,        ESK8_REG_BMS_FW_VERSION,            2,  ONCE,   __VA_ARGS__)    \
+    X(MANUFACTURE_DATE, DEEP,   manufactureDate,        ESK8_REG_BMS_MANUFACTURE_DATE,      2,  ONCE,   __VA_ARGS__)    \
+    X(FACTORY_CAPACITY, DEEP,   factoryCapacity_mAh,    ESK8_REG_BMS_FACTORY_CAPACITY,      2,  ONCE,   __VA_ARGS__)    \
+    X(ACTUAL_CAPACITY,  DEEP,   actualCapacity_mAh,     ESK8_REG_BMS_ACTUAL_CAPACITY,       2,  SLOW,   __VA_ARGS__)    \
+    X(REMAINING_PRC,    DEEP,   remainingCapacity_prc,  ESK8_REG_BMS_CAPACITY,              2,  MEDIUM, __VA_ARGS__)    \
+    X(REMAINING_MAH,    DEEP,   remainingCapacity_mAh,  ESK8_REG_BMS_CAPACITY_mAh,          2,  MEDIUM, __VA_ARGS__)    \
+    X(FULL_CYCLES,      DEEP,   chargeFullCycles,       ESK8_REG_BMS_CHARGE_FULL_CYCLES,    2,  SLOW,   __VA_ARGS__)    \
+    X(CHARGE_COUNT,     DEEP,   chargeCount,            ESK8_REG_BMS_CHARGE_COUNT,          2,  SLOW,   __VA_ARGS__)    \
+    X(HEALTH,           DEEP,   packHeath_prc,          ESK8_REG_BMS_HEALTH,                2,  SLOW,   __VA_ARGS__)    \
+    X(CELL_VOLTAGES,    DEEP,   cellVoltage_mV,         ESK8_REG_BMS_CELL0_V,               20, MEDIUM, __VA_ARGS__)
+
+typedef enum
+{
+#define ESK8_BMS_FIELD_ENUM(name, dst, field, reg, width, refresh, ...) \
+    ESK8_BMS_FIELD_##name,
+
+    ESK8_BMS_FIELD_TABLE(ESK8_BMS_FIELD_ENUM)
+
+#undef ESK8_BMS_FIELD_ENUM
+
+    ESK8_BMS_FIELD_MAX
+}
+esk8_bms_field_idx_t;
+
+/**
+ * Fields are selected with a bit mask,
+ * one bit per `esk8_bms_field_idx_t`.
+ */
+typedef uint32_t
+esk8_bms_field_mask_t;
+
+#define ESK8_BMS_FIELD_BIT(name) \
+    ((esk8_bms_field_mask_t)1 << ESK8_BMS_FIELD_##name)
+
+/**
+ * Constant mask of the fields landing in one of
+ * `dsts` (a `esk8_bms_dst_t` mask) with a refresh
+ * class in `refreshes` (a `esk8_bms_refresh_t` mask).
+ */
+#define ESK8_BMS_FIELD_MASK_SEL(name, dst, field, reg, width, refresh, dsts, refreshes) \
+    | (((ESK8_BMS_DST_##dst & (dsts)) && (ESK8_BMS_REFRESH_##refresh & (refreshes))) ?  \
+        ESK8_BMS_FIELD_BIT(name) : 0)
+
+#define ESK8_BMS_FIELD_MASK(dsts, refreshes) \
+    ((esk8_bms_field_mask_t)(0 ESK8_BMS_FIELD_TABLE(ESK8_BMS_FIELD_MASK_SEL, dsts, refreshes)))
+
+#define ESK8_BMS_FIELDS_STATUS  ESK8_BMS_FIELD_MASK(ESK8_BMS_DST_STATUS, ESK8_BMS_REFRESH_ALL)
+#define ESK8_BMS_FIELDS_DEEP    ESK8_BMS_FIELD_MASK(ESK8_BMS_DST_DEEP,   ESK8_BMS_REFRESH_ALL)
+#define ESK8_BMS_FIELDS_ALL     ESK8_BMS_FIELD_MASK(ESK8_BMS_DST_ALL,    ESK8_BMS_REFRESH_ALL)
+
+/**
+ * What the firmware knows about a field,
+ * generated from `ESK8_BMS_FIELD_TABLE`.
+ */
+typedef struct
+{
+    uint8_t     reg;
+    uint8_t     width;
+    uint8_t     dst;        /* esk8_bms_dst_t */
+    uint8_t     offset;     /* Byte offset into the dst struct */
+    uint8_t     refresh;    /* esk8_bms_refresh_t */
+}
+esk8_bms_field_t;
+
+extern const esk8_bms_field_t
+esk8_bms_fields[ESK8_BMS_FIELD_MAX];
+
+#endif /* _ESK8_BMS_FIELDS_H */
@@ -0,0 +1,23 @@
+#include <esk8_err.h>
+#include <esk8_bms.h>
+#include <esk8_bms_fields.h>
+#include <esk8_bms_utils.h>
+
+
+esk8_err_t
+esk8_bms_get_full_status(
+    esk8_bms_hndl_t hndl,
+    uint8_t pack,
+    esk8_bms_status_t *out_status,
+    esk8_bms_deep_status_t *out_deep_status
+)
+{
+    esk8_bms_req_t req = {
+        .pack        = pack,
+        .fields      = ESK8_BMS_FIELDS_ALL,
+        .status      = out_status,
+        .deep_status = out_deep_status,
+    };
+
+    return esk8_bms_submit_wait(hndl, &req);
+}
@@ -1,8 +1,103 @@
 #include <esk8_bms.h>
+#include <esk8_bms_priv.h>
+#include <esk8_uart_bus.h>
 
 #include <esp_err.h>
 #include <driver/uart.h>
 
+#include <stdio.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+
+
+/**
+ * Stops the worker of `port`, once the request
+ * in flight and the callbacks of those left
+ * are done.
+ */
+static void
+port_stop(
+    esk8_bms_port_t* port
+)
+{
+    if (!port->task_worker)
+        return;
+
+    /* Not deleted from here, it may be holding the bus */
+    esk8_bms_req_t wake = { 0 };
+
+    port->stop = true;
+    xQueueSend(port->req_queue, &wake, portMAX_DELAY);
+    xSemaphoreTake(port->stopped, portMAX_DELAY);
+    port->task_worker = NULL;
+}
+
+static void
+port_deinit(
+    esk8_bms_port_t* port
+)
+{
+    if (port->stopped)
+        vSemaphoreDelete(port->stopped);
+
+    if (port->req_queue)
+        vQueueDelete(port->req_queue);
+
+    if (port->bus)
+        esk8_uart_bus_close(port->bus);
+}
+
+/**
+ * Opens the bus of `port`, pointed at its
+ * first pack, and starts its worker.
+ */
+static esk8_err_t
+port_init(
+    esk8_bms_port_t* port,
+    int              uart_port,
+    uint8_t          first_pack
+)
+{
+    esk8_bms_config_t* bms_cnfg = &port->bms_hndl->bms_cnfg;
+
+    ESK8_ERRCHECK_THROW(esk8_uart_bus_open(
+        uart_port,
+        bms_cnfg->tx_pins[first_pack],
+        bms_cnfg->rx_pins[first_pack],
+        ESK8_UART_BMS_BUFF_SIZE,
+        ESK8_UART_BMS_EVT_QUEUE_LEN,
+        &port->bus
+    ));
+
+    port->uart_port = uart_port;
+
+    port->req_queue = xQueueCreate(
+        ESK8_UART_BMS_REQ_QUEUE_LEN,
+        sizeof(esk8_bms_req_t)
+    );
+
+    port->stopped = xSemaphoreCreateBinary();
+
+    if (!port->req_queue || !port->stopped)
+        return ESK8_ERR_OOM;
+
+    if  (
+            xTaskCreate(
+                esk8_bms_task_worker,
+                "ESK8_TASK_BMS_UART", 3072,
+                port, ESK8_UART_BMS_TASK_PRIORITY,
+                (TaskHandle_t*) &port->task_worker
+            ) != pdPASS
+        )
+    {
+        return ESK8_ERR_OOM;
+    }
+
+    return ESK8_OK;
+}
 
 esk8_err_t
 esk8_bms_init(
@@ -10,70 +105,115 @@ esk8_bms_init(
     esk8_bms_hndl_t* out_hndl
 )
 {
-    esp_err_t err;
     esk8_err_t esk8_err;
-    uart_config_t uart_cnfg = ESK8_UART_CONFIG_DEFAULT_ESP32();
 
-    *out_hndl = calloc(1, sizeof(esk8_bms_config_t));
-    if (!(*out_hndl))
+    if (bms_cnfg->bat_num > ESK8_UART_BMS_CONF_NUM)
+        return ESK8_ERR_INVALID_PARAM;
+
+    /* Two UARTs can not drive the same TX pin */
+    for (int a = 0; bms_cnfg->uart_ports && a < bms_cnfg->bat_num; a++)
+    {
+        for (int b = a + 1; b < bms_cnfg->bat_num; b++)
+        {
+            if  (
+                    bms_cnfg->uart_ports[a] != bms_cnfg->uart_ports[b] &&
+                    bms_cnfg->tx_pins[a] == bms_cnfg->tx_pins[b]
+                )
+                return ESK8_ERR_INVALID_PARAM;
+        }
+    }
+
+    esk8_bms_hndl_def_t* bms_hndl = calloc(1, sizeof(esk8_bms_hndl_def_t));
+    if (!bms_hndl)
         return ESK8_ERR_OOM;
 
-    **(esk8_bms_config_t**)out_hndl = *bms_cnfg;
+    bms_hndl->bms_cnfg = *bms_cnfg;
 
-    err = uart_param_config(
-        bms_cnfg->uart_port,
-        &uart_cnfg
-    );
+    for (int pack = 0; pack < ESK8_UART_BMS_CONF_NUM; pack++)
+        esk8_bms_link_init(&bms_hndl->links[pack]);
 
-    if (err)
+    /* Packs sharing a UART share its port, and its worker */
+    for (int pack = 0; pack < bms_cnfg->bat_num; pack++)
     {
-        return ESK8_ERR_INVALID_PARAM;
-        goto fail;
-    }
+        int uart_port = bms_cnfg->uart_ports ?
+            bms_cnfg->uart_ports[pack] : bms_cnfg->uart_port;
 
-    bms_cnfg->tx_pin = 0;
+        int p = 0;
+        for (; p < bms_hndl->port_num; p++)
+        {
+            if (bms_hndl->ports[p].uart_port == uart_port)
+                break;
+        }
 
-    err = uart_set_pin(
-        bms_cnfg->uart_port,
-        bms_cnfg->tx_pins[0],
-        bms_cnfg->rx_pins[0],
-        UART_PIN_NO_CHANGE,
-        UART_PIN_NO_CHANGE
-    );
+        if (p == bms_hndl->port_num)
+        {
+            if (p == ESK8_UART_BMS_MAX_PORTS)
+            {
+                esk8_err = ESK8_ERR_INVALID_PARAM;
+                goto fail;
+            }
 
-    if (err)
-    {
-        esk8_err = ESK8_ERR_INVALID_PARAM;
-        goto fail;
-    }
+            esk8_bms_port_t* port = &bms_hndl->ports[p];
+            port->bms_hndl = bms_hndl;
+            bms_hndl->port_num++;
 
-    err = uart_driver_install(
-        bms_cnfg->uart_port,
-        ESK8_UART_BMS_BUFF_SIZE,
-        0, 0, NULL, 0
-    );
+            esk8_err = port_init(port, uart_port, pack);
 
-    if (err)
-    {
-        esk8_err = ESK8_ERR_INVALID_PARAM;
-        goto fail;
-    }
+            if (esk8_err)
+                goto fail;
+        }
 
-    /**
-     * BLE (and others) communicate through UART,
-     * so this might already be installed. In that
-     * case it returns ESP_FAIL (Instead of a specific error),
-     * and we can ignore it.
-     */
-    if (err != ESP_OK && err != ESP_FAIL)
-    {
-        err = ESK8_ERR_INVALID_PARAM;
-        goto fail;
+        bms_hndl->pack_port[pack] = p;
+
+        /* Each pack waits for the bus on its own, and has its own stats */
+        static char client_names[ESK8_UART_BMS_CONF_NUM][8];
+        snprintf(client_names[pack], sizeof(client_names[pack]), "bms%d", pack);
+
+        esk8_err = esk8_uart_bus_client_add(
+            bms_hndl->ports[p].bus,
+            client_names[pack],
+            &bms_hndl->pack_client[pack]
+        );
+
+        if (esk8_err)
+            goto fail;
+
+        bms_hndl->client_num++;
     }
 
+    (*out_hndl) = bms_hndl;
     return ESK8_OK;
 
 fail:
-    free(*out_hndl);
+    esk8_bms_deinit(bms_hndl);
     return esk8_err;
 }
+
+esk8_err_t
+esk8_bms_deinit(
+    esk8_bms_hndl_t hndl
+)
+{
+    esk8_bms_hndl_def_t* bms_hndl = (esk8_bms_hndl_def_t*)hndl;
+
+    if (!bms_hndl)
+        return ESK8_ERR_INVALID_PARAM;
+
+    for (int p = 0; p < bms_hndl->port_num; p++)
+        port_stop(&bms_hndl->ports[p]);
+
+    /* The bus may outlive us, when the ESC shares it */
+    for (int pack = 0; pack < bms_hndl->client_num; pack++)
+    {
+        esk8_uart_bus_client_remove(
+            bms_hndl->ports[bms_hndl->pack_port[pack]].bus,
+            bms_hndl->pack_client[pack]
+        );
+    }
+
+    for (int p = 0; p < bms_hndl->port_num; p++)
+        port_deinit(&bms_hndl->ports[p]);
+
+    free(bms_hndl);
+    return ESK8_OK;
+}
@@ -13,19 +13,23 @@ esk8_bms_init_from_config_h(
 {
     static uint8_t rx_pins[] = ESK8_UART_BMS_RX_PINS;
     static uint8_t tx_pins[] = ESK8_UART_BMS_TX_PINS;
+    static int     ports[]   = ESK8_UART_BMS_PORTS;
 
     const uint8_t rx_num       = sizeof(rx_pins) / sizeof(uint8_t);
     const uint8_t tx_num       = sizeof(tx_pins) / sizeof(uint8_t);
+    const uint8_t port_num     = sizeof(ports) / sizeof(int);
 
-    if (rx_num != tx_num)
+    if (rx_num != tx_num || rx_num != port_num)
         return ESK8_ERR_INVALID_PARAM;
 
     esk8_bms_config_t bms_cnfg = {
         .uart_port = ESK8_UART_BMS_NUM,
+        .uart_ports = ports,
         .bat_num = rx_num,
         .tx_pins = tx_pins,
         .rx_pins = rx_pins,
-        .bms_update_ms = ESK8_UART_BMS_UPDATE_MS
+        .bms_update_ms = ESK8_UART_BMS_UPDATE_MS,
+        .sniff = ESK8_UART_BMS_SNIFF
     };
 
     return esk8_bms_init(&bms_cnfg, out_hndl);
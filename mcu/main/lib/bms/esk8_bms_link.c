@@ -0,0 +1,210 @@
+#include <esk8_config.h>
+#include <esk8_err.h>
+#include <esk8_bms.h>
+#include <esk8_bms_priv.h>
+#include <esk8_uart.h>
+
+#include <esp_timer.h>
+
+#include <string.h>
+#include <stdbool.h>
+
+#define RTO_MIN_US (ESK8_UART_BMS_RTO_MIN_MS * 1000)
+#define RTO_MAX_US (ESK8_UART_BMS_RTO_MAX_MS * 1000)
+
+/* Wire time of a reply frame with `size` payload bytes */
+#define REPLY_WIRE_US(size) ESK8_UART_WIRE_US(ESK8_MSG_SIZE(size))
+
+
+void
+esk8_bms_link_init(
+    esk8_bms_link_t* link
+)
+{
+    memset(link, 0, sizeof(esk8_bms_link_t));
+    link->health.rto_us = RTO_MAX_US;
+}
+
+uint32_t
+esk8_bms_link_timeout_us(
+    const esk8_bms_link_t* link,
+    size_t                 reply_size
+)
+{
+    return link->health.rto_us + REPLY_WIRE_US(reply_size);
+}
+
+void
+esk8_bms_link_rtt(
+    esk8_bms_link_t* link,
+    uint32_t         rtt_us,
+    size_t           reply_size
+)
+{
+    esk8_bms_health_t* health = &link->health;
+    uint32_t wire_us = REPLY_WIRE_US(reply_size);
+
+    /* Only the wait for the first byte, so reads of any size compare */
+    rtt_us = rtt_us > wire_us ? rtt_us - wire_us : 1;
+
+    /* Same estimator as TCP (RFC 6298) */
+    if (!health->srtt_us)
+    {
+        health->srtt_us   = rtt_us;
+        health->rttvar_us = rtt_us / 2;
+    }
+    else
+    {
+        uint32_t delta = health->srtt_us > rtt_us ?
+            health->srtt_us - rtt_us : rtt_us - health->srtt_us;
+
+        health->rttvar_us = health->rttvar_us - health->rttvar_us / 4 + delta / 4;
+        health->srtt_us   = health->srtt_us - health->srtt_us / 8 + rtt_us / 8;
+    }
+
+    uint32_t rto_us = health->srtt_us + 4 * health->rttvar_us;
+
+    health->rto_us = rto_us < RTO_MIN_US ? RTO_MIN_US :
+                     rto_us > RTO_MAX_US ? RTO_MAX_US : rto_us;
+}
+
+
+esk8_err_t
+esk8_bms_link_allow(
+    esk8_bms_hndl_def_t* bms_hndl,
+    uint8_t              pack,
+    int*                 out_tries
+)
+{
+    esk8_bms_link_t* link = &bms_hndl->links[pack];
+
+    (*out_tries) = ESK8_UART_BMS_MSG_UPDATE_RETRIES;
+
+    switch (link->health.state)
+    {
+        case ESK8_BMS_LINK_CLOSED:
+            return ESK8_OK;
+
+        case ESK8_BMS_LINK_OPEN:
+            if (esp_timer_get_time() < link->probe_us)
+            {
+                link->health.fast_fails++;
+                return ESK8_BMS_ERR_PACK_DOWN;
+            }
+
+            link->health.state = ESK8_BMS_LINK_HALF_OPEN;
+            /* fall through */
+
+        case ESK8_BMS_LINK_HALF_OPEN:
+        default:
+            /* A dead pack costs a single timeout per backoff */
+            (*out_tries) = 1;
+            return ESK8_OK;
+    }
+}
+
+/**
+ * Whether `err` says something about the pack:
+ * it did not answer, or answered wrong. Ours
+ * and the bus arbiter's own errors do not.
+ */
+static bool
+link_failed(
+    esk8_err_t err
+)
+{
+    switch (err)
+    {
+        case ESK8_BMS_ERR_NO_RESPONSE:
+        case ESK8_BMS_ERR_INVALID_LEN:
+        case ESK8_BMS_ERR_WRONG_RESPONSE:
+        case ESK8_BMS_ERR_WRONG_ADDRESS:
+        case ESK8_UART_MSG_ERR_INVALID_CHKSUM:
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+void
+esk8_bms_link_report(
+    esk8_bms_hndl_def_t* bms_hndl,
+    uint8_t              pack,
+    esk8_err_t           err
+)
+{
+    esk8_bms_link_t* link = &bms_hndl->links[pack];
+    esk8_bms_health_t* health = &link->health;
+
+    if (err && !link_failed(err))
+        return;
+
+    if (!err)
+    {
+        health->state      = ESK8_BMS_LINK_CLOSED;
+        health->fails      = 0;
+        health->backoff_ms = 0;
+        return;
+    }
+
+    if (health->fails < UINT8_MAX)
+        health->fails++;
+
+    /* Maybe the pack just got slower, wait longer until it is timed again */
+    health->rto_us = health->rto_us * 2 < RTO_MAX_US ? health->rto_us * 2 : RTO_MAX_US;
+
+    if (health->state == ESK8_BMS_LINK_HALF_OPEN)
+    {
+        uint32_t backoff_ms = health->backoff_ms * 2;
+
+        health->backoff_ms = backoff_ms < ESK8_UART_BMS_BACKOFF_MAX_MS ?
+            backoff_ms : ESK8_UART_BMS_BACKOFF_MAX_MS;
+    }
+    else if (health->fails >= ESK8_UART_BMS_BREAKER_FAILS)
+    {
+        health->backoff_ms = ESK8_UART_BMS_BACKOFF_MIN_MS;
+    }
+    else
+    {
+        return;
+    }
+
+    health->state  = ESK8_BMS_LINK_OPEN;
+    link->probe_us = esp_timer_get_time() + health->backoff_ms * 1000ll;
+}
+
+esk8_err_t
+esk8_bms_get_health(
+    esk8_bms_hndl_t hndl,
+    uint8_t pack,
+    esk8_bms_health_t *out_health
+)
+{
+    esk8_bms_hndl_def_t* bms_hndl = (esk8_bms_hndl_def_t*)hndl;
+
+    if (!bms_hndl || pack >= bms_hndl->bms_cnfg.bat_num)
+        return ESK8_ERR_INVALID_PARAM;
+
+    (*out_health) = bms_hndl->links[pack].health;
+    return ESK8_OK;
+}
+
+esk8_err_t
+esk8_bms_get_bus_stats(
+    esk8_bms_hndl_t hndl,
+    uint8_t pack,
+    esk8_uart_bus_stats_t *out_stats
+)
+{
+    esk8_bms_hndl_def_t* bms_hndl = (esk8_bms_hndl_def_t*)hndl;
+
+    if (!bms_hndl || pack >= bms_hndl->bms_cnfg.bat_num)
+        return ESK8_ERR_INVALID_PARAM;
+
+    return esk8_uart_bus_get_stats(
+        bms_hndl->ports[bms_hndl->pack_port[pack]].bus,
+        bms_hndl->pack_client[pack],
+        out_stats
+    );
+}
@@ -0,0 +1,133 @@
+#include <esk8_config.h>
+#include <esk8_err.h>
+#include <esk8_bms.h>
+#include <esk8_bms_fields.h>
+#include <esk8_bms_utils.h>
+#include <esk8_bms_priv.h>
+#include <esk8_uart_bus.h>
+
+#include <string.h>
+
+/* BMS registers are 16 bit words */
+#define REG_END(reg, size) ((reg) + ((size) + 1) / 2)
+
+
+void
+esk8_bms_plan_fields(
+    esk8_bms_field_mask_t mask,
+    esk8_bms_plan_t*      out_plan
+)
+{
+    uint8_t* fields = out_plan->fields;
+    int n_fields = 0;
+
+    /* The table is short, an insertion sort by register will do */
+    for (int f = 0; f < ESK8_BMS_FIELD_MAX; f++)
+    {
+        if (!(mask & ((esk8_bms_field_mask_t)1 << f)))
+            continue;
+
+        int j = n_fields++ - 1;
+
+        for (; j >= 0 && esk8_bms_fields[fields[j]].reg > esk8_bms_fields[f].reg; j--)
+            fields[j + 1] = fields[j];
+
+        fields[j + 1] = f;
+    }
+
+    int n_ranges = 0;
+    esk8_bms_range_t* range = NULL;
+
+    for (int i = 0; i < n_fields; i++)
+    {
+        const esk8_bms_field_t* field = &esk8_bms_fields[fields[i]];
+        int field_end = REG_END(field->reg, field->width);
+
+        if (range)
+        {
+            int range_end = REG_END(range->reg, range->size);
+            int new_end   = field_end > range_end ? field_end : range_end;
+            int new_size  = (new_end - range->reg) * 2;
+
+            if  (
+                    field->reg <= range_end + ESK8_UART_BMS_PLAN_MAX_GAP &&
+                    new_size <= ESK8_UART_BMS_PLAN_MAX_READ
+                )
+            {
+                range->size = new_size;
+                range->num++;
+                continue;
+            }
+        }
+
+        range = &out_plan->ranges[n_ranges++];
+        range->reg   = field->reg;
+        range->size  = field->width;
+        range->first = i;
+        range->num   = 1;
+    }
+
+    out_plan->mask     = mask;
+    out_plan->n_ranges = n_ranges;
+}
+
+esk8_err_t
+esk8_bms_read_plan(
+    esk8_bms_port_t*        port,
+    uint8_t                 pack,
+    const esk8_bms_plan_t*  plan,
+    esk8_bms_status_t*      status,
+    esk8_bms_deep_status_t* deep,
+    esk8_bms_link_t*        link,
+    int                     tries
+)
+{
+    esk8_bms_hndl_def_t* bms_hndl = port->bms_hndl;
+    esk8_bms_config_t* bms_cnfg = &bms_hndl->bms_cnfg;
+
+    esk8_uart_trx_t trx = {
+        .prio     = plan->mask & ~ESK8_BMS_FIELD_MASK(ESK8_BMS_DST_ALL, ESK8_BMS_REFRESH_FAST) ?
+                        ESK8_UART_PRIO_BULK : ESK8_UART_PRIO_TELEMETRY,
+        .tx_pin   = bms_cnfg->tx_pins[pack],
+        .rx_pin   = bms_cnfg->rx_pins[pack],
+        .dst_addr = ESK8_ADDR_BMS,
+        .tries    = tries,
+    };
+
+    for (int i = 0; i < plan->n_ranges; i++)
+    {
+        uint32_t rtt_us;
+        uint8_t rsp[ESK8_UART_BMS_PLAN_MAX_READ];
+        const esk8_bms_range_t* range = &plan->ranges[i];
+
+        trx.reg        = range->reg;
+        trx.reg_size   = range->size;
+        trx.timeout_us = esk8_bms_link_timeout_us(link, range->size);
+
+        ESK8_ERRCHECK_THROW(esk8_uart_bus_regread(
+            port->bus, bms_hndl->pack_client[pack],
+            &trx, rsp, &rtt_us
+        ));
+
+        if (rtt_us)
+            esk8_bms_link_rtt(link, rtt_us, range->size);
+
+        for (int j = range->first; j < range->first + range->num; j++)
+        {
+            const esk8_bms_field_t* field = &esk8_bms_fields[plan->fields[j]];
+            uint8_t* dst = field->dst == ESK8_BMS_DST_STATUS ?
+                (uint8_t*) status : (uint8_t*) deep;
+
+            if (!dst)
+                continue;
+
+            memcpy(
+                dst + field->offset,
+                rsp + (field->reg - range->reg) * 2,
+                field->width
+            );
+        }
+    }
+
+    return ESK8_OK;
+}
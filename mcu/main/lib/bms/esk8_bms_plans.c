@@ -0,0 +1,498 @@
+/* Generated by mcu/host/bms_plan/esk8_bms_plan_gen.c, do not edit. */
+/* Run the `bms_plans` host target once the field table or the plan limits change. */
+#include <esk8_config.h>
+#include <esk8_bms_fields.h>
+#include <esk8_bms_utils.h>
+
+
+#if ESK8_UART_BMS_PLAN_MAX_GAP != 8 || ESK8_UART_BMS_PLAN_MAX_READ != 64
+#error "BMS read plans were made with other limits, run the bms_plans host target"
+#endif
+
+_Static_assert(
+    ESK8_BMS_FIELD_MAX == 15,
+    "BMS read plans were made from another field table, run the bms_plans host target");
+
+/* Every field as planned, by register, width, destination and refresh class */
+#define PLAN_CHECK(name, dst, field, reg, width, refresh, ...) \
+    _Static_assert( \
+        (reg) == PLAN_REG_##name && (width) == PLAN_WIDTH_##name && \
+        ESK8_BMS_DST_##dst == PLAN_DST_##name && ESK8_BMS_REFRESH_##refresh == PLAN_REFRESH_##name, \
+        "BMS field " #name " changed since the read plans were made, run the bms_plans host target");
+
+#define PLAN_REG_CAPACITY 0x32
+#define PLAN_WIDTH_CAPACITY 2
+#define PLAN_DST_CAPACITY 1
+#define PLAN_REFRESH_CAPACITY 2
+#define PLAN_REG_VOLTAGE 0x34
+#define PLAN_WIDTH_VOLTAGE 2
+#define PLAN_DST_VOLTAGE 1
+#define PLAN_REFRESH_VOLTAGE 1
+#define PLAN_REG_CURRENT 0x33
+#define PLAN_WIDTH_CURRENT 2
+#define PLAN_DST_CURRENT 1
+#define PLAN_REFRESH_CURRENT 1
+#define PLAN_REG_TEMPRTR 0x35
+#define PLAN_WIDTH_TEMPRTR 2
+#define PLAN_DST_TEMPRTR 1
+#define PLAN_REFRESH_TEMPRTR 2
+#define PLAN_REG_SERIAL_NUMBER 0x10
+#define PLAN_WIDTH_SERIAL_NUMBER 14
+#define PLAN_DST_SERIAL_NUMBER 2
+#define PLAN_REFRESH_SERIAL_NUMBER 8
+#define PLAN_REG_FW_VERSION 0x17
+#define PLAN_WIDTH_FW_VERSION 2
+#define PLAN_DST_FW_VERSION 2
+#define PLAN_REFRESH_FW_VERSION 8
+#define PLAN_REG_MANUFACTURE_DATE 0x20
+#define PLAN_WIDTH_MANUFACTURE_DATE 2
+#define PLAN_DST_MANUFACTURE_DATE 2
+#define PLAN_REFRESH_MANUFACTURE_DATE 8
+#define PLAN_REG_FACTORY_CAPACITY 0x18
+#define PLAN_WIDTH_FACTORY_CAPACITY 2
+#define PLAN_DST_FACTORY_CAPACITY 2
+#define PLAN_REFRESH_FACTORY_CAPACITY 8
+#define PLAN_REG_ACTUAL_CAPACITY 0x19
+#define PLAN_WIDTH_ACTUAL_CAPACITY 2
+#define PLAN_DST_ACTUAL_CAPACITY 2
+#define PLAN_REFRESH_ACTUAL_CAPACITY 4
+#define PLAN_REG_REMAINING_PRC 0x32
+#define PLAN_WIDTH_REMAINING_PRC 2
+#define PLAN_DST_REMAINING_PRC 2
+#define PLAN_REFRESH_REMAINING_PRC 2
+#define PLAN_REG_REMAINING_MAH 0x31
+#define PLAN_WIDTH_REMAINING_MAH 2
+#define PLAN_DST_REMAINING_MAH 2
+#define PLAN_REFRESH_REMAINING_MAH 2
+#define PLAN_REG_FULL_CYCLES 0x1B
+#define PLAN_WIDTH_FULL_CYCLES 2
+#define PLAN_DST_FULL_CYCLES 2
+#define PLAN_REFRESH_FULL_CYCLES 4
+#define PLAN_REG_CHARGE_COUNT 0x1C
+#define PLAN_WIDTH_CHARGE_COUNT 2
+#define PLAN_DST_CHARGE_COUNT 2
+#define PLAN_REFRESH_CHARGE_COUNT 4
+#define PLAN_REG_HEALTH 0x3B
+#define PLAN_WIDTH_HEALTH 2
+#define PLAN_DST_HEALTH 2
+#define PLAN_REFRESH_HEALTH 4
+#define PLAN_REG_CELL_VOLTAGES 0x40
+#define PLAN_WIDTH_CELL_VOLTAGES 20
+#define PLAN_DST_CELL_VOLTAGES 2
+#define PLAN_REFRESH_CELL_VOLTAGES 2
+
+ESK8_BMS_FIELD_TABLE(PLAN_CHECK)
+
+
+const esk8_bms_plan_t
+esk8_bms_plans[] = {
+    /* ESK8_BMS_DST_STATUS, ESK8_BMS_REFRESH_FAST */
+    {
+        .mask     = 0x00000006,
+        .n_ranges = 1,
+        .fields   = {
+            ESK8_BMS_FIELD_CURRENT,
+            ESK8_BMS_FIELD_VOLTAGE
+        },
+        .ranges   = {
+            { .reg = 0x33, .size =  4, .first =  0, .num =  2 },
+        },
+    },
+    /* ESK8_BMS_DST_STATUS, ESK8_BMS_REFRESH_MEDIUM */
+    {
+        .mask     = 0x00000009,
+        .n_ranges = 1,
+        .fields   = {
+            ESK8_BMS_FIELD_CAPACITY,
+            ESK8_BMS_FIELD_TEMPRTR
+        },
+        .ranges   = {
+            { .reg = 0x32, .size =  8, .first =  0, .num =  2 },
+        },
+    },
+    /* ESK8_BMS_DST_STATUS, ESK8_BMS_REFRESH_FAST | ESK8_BMS_REFRESH_MEDIUM */
+    {
+        .mask     = 0x0000000F,
+        .n_ranges = 1,
+        .fields   = {
+            ESK8_BMS_FIELD_CAPACITY,
+            ESK8_BMS_FIELD_CURRENT,
+            ESK8_BMS_FIELD_VOLTAGE,
+            ESK8_BMS_FIELD_TEMPRTR
+        },
+        .ranges   = {
+            { .reg = 0x32, .size =  8, .first =  0, .num =  4 },
+        },
+    },
+    /* ESK8_BMS_DST_DEEP, ESK8_BMS_REFRESH_ONCE */
+    {
+        .mask     = 0x000000F0,
+        .n_ranges = 1,
+        .fields   = {
+            ESK8_BMS_FIELD_SERIAL_NUMBER,
+            ESK8_BMS_FIELD_FW_VERSION,
+            ESK8_BMS_FIELD_FACTORY_CAPACITY,
+            ESK8_BMS_FIELD_MANUFACTURE_DATE
+        },
+        .ranges   = {
+            { .reg = 0x10, .size = 34, .first =  0, .num =  4 },
+        },
+    },
+    /* ESK8_BMS_DST_ALL, ESK8_BMS_REFRESH_FAST | ESK8_BMS_REFRESH_ONCE */
+    {
+        .mask     = 0x000000F6,
+        .n_ranges = 2,
+        .fields   = {
+            ESK8_BMS_FIELD_SERIAL_NUMBER,
+            ESK8_BMS_FIELD_FW_VERSION,
+            ESK8_BMS_FIELD_FACTORY_CAPACITY,
+            ESK8_BMS_FIELD_MANUFACTURE_DATE,
+            ESK8_BMS_FIELD_CURRENT,
+            ESK8_BMS_FIELD_VOLTAGE
+        },
+        .ranges   = {
+            { .reg = 0x10, .size = 34, .first =  0, .num =  4 },
+            { .reg = 0x33, .size =  4, .first =  4, .num =  2 },
+        },
+    },
+    /* ESK8_BMS_DST_DEEP, ESK8_BMS_REFRESH_SLOW */
+    {
+        .mask     = 0x00003900,
+        .n_ranges = 2,
+        .fields   = {
+            ESK8_BMS_FIELD_ACTUAL_CAPACITY,
+            ESK8_BMS_FIELD_FULL_CYCLES,
+            ESK8_BMS_FIELD_CHARGE_COUNT,
+            ESK8_BMS_FIELD_HEALTH
+        },
+        .ranges   = {
+            { .reg = 0x19, .size =  8, .first =  0, .num =  3 },
+            { .reg = 0x3B, .size =  2, .first =  3, .num =  1 },
+        },
+    },
+    /* ESK8_BMS_DST_ALL, ESK8_BMS_REFRESH_FAST | ESK8_BMS_REFRESH_SLOW */
+    {
+        .mask     = 0x00003906,
+        .n_ranges = 2,
+        .fields   = {
+            ESK8_BMS_FIELD_ACTUAL_CAPACITY,
+            ESK8_BMS_FIELD_FULL_CYCLES,
+            ESK8_BMS_FIELD_CHARGE_COUNT,
+            ESK8_BMS_FIELD_CURRENT,
+            ESK8_BMS_FIELD_VOLTAGE,
+            ESK8_BMS_FIELD_HEALTH
+        },
+        .ranges   = {
+            { .reg = 0x19, .size =  8, .first =  0, .num =  3 },
+            { .reg = 0x33, .size = 18, .first =  3, .num =  3 },
+        },
+    },
+    /* ESK8_BMS_DST_DEEP, ESK8_BMS_REFRESH_SLOW | ESK8_BMS_REFRESH_ONCE */
+    {
+        .mask     = 0x000039F0,
+        .n_ranges = 2,
+        .fields   = {
+            ESK8_BMS_FIELD_SERIAL_NUMBER,
+            ESK8_BMS_FIELD_FW_VERSION,
+            ESK8_BMS_FIELD_FACTORY_CAPACITY,
+            ESK8_BMS_FIELD_ACTUAL_CAPACITY,
+            ESK8_BMS_FIELD_FULL_CYCLES,
+            ESK8_BMS_FIELD_CHARGE_COUNT,
+            ESK8_BMS_FIELD_MANUFACTURE_DATE,
+            ESK8_BMS_FIELD_HEALTH
+        },
+        .ranges   = {
+            { .reg = 0x10, .size = 34, .first =  0, .num =  7 },
+            { .reg = 0x3B, .size =  2, .first =  7, .num =  1 },
+        },
+    },
+    /* ESK8_BMS_DST_ALL, ESK8_BMS_REFRESH_FAST | ESK8_BMS_REFRESH_SLOW | ESK8_BMS_REFRESH_ONCE */
+    {
+        .mask     = 0x000039F6,
+        .n_ranges = 2,
+        .fields   = {
+            ESK8_BMS_FIELD_SERIAL_NUMBER,
+            ESK8_BMS_FIELD_FW_VERSION,
+            ESK8_BMS_FIELD_FACTORY_CAPACITY,
+            ESK8_BMS_FIELD_ACTUAL_CAPACITY,
+            ESK8_BMS_FIELD_FULL_CYCLES,
+            ESK8_BMS_FIELD_CHARGE_COUNT,
+            ESK8_BMS_FIELD_MANUFACTURE_DATE,
+            ESK8_BMS_FIELD_CURRENT,
+            ESK8_BMS_FIELD_VOLTAGE,
+            ESK8_BMS_FIELD_HEALTH
+        },
+        .ranges   = {
+            { .reg = 0x10, .size = 34, .first =  0, .num =  7 },
+            { .reg = 0x33, .size = 18, .first =  7, .num =  3 },
+        },
+    },
+    /* ESK8_BMS_DST_DEEP, ESK8_BMS_REFRESH_MEDIUM */
+    {
+        .mask     = 0x00004600,
+        .n_ranges = 2,
+        .fields   = {
+            ESK8_BMS_FIELD_REMAINING_MAH,
+            ESK8_BMS_FIELD_REMAINING_PRC,
+            ESK8_BMS_FIELD_CELL_VOLTAGES
+        },
+        .ranges   = {
+            { .reg = 0x31, .size =  4, .first =  0, .num =  2 },
+            { .reg = 0x40, .size = 20, .first =  2, .num =  1 },
+        },
+    },
+    /* ESK8_BMS_DST_ALL, ESK8_BMS_REFRESH_MEDIUM */
+    {
+        .mask     = 0x00004609,
+        .n_ranges = 2,
+        .fields   = {
+            ESK8_BMS_FIELD_REMAINING_MAH,
+            ESK8_BMS_FIELD_CAPACITY,
+            ESK8_BMS_FIELD_REMAINING_PRC,
+            ESK8_BMS_FIELD_TEMPRTR,
+            ESK8_BMS_FIELD_CELL_VOLTAGES
+        },
+        .ranges   = {
+            { .reg = 0x31, .size = 10, .first =  0, .num =  4 },
+            { .reg = 0x40, .size = 20, .first =  4, .num =  1 },
+        },
+    },
+    /* ESK8_BMS_DST_ALL, ESK8_BMS_REFRESH_FAST | ESK8_BMS_REFRESH_MEDIUM */
+    {
+        .mask     = 0x0000460F,
+        .n_ranges = 2,
+        .fields   = {
+            ESK8_BMS_FIELD_REMAINING_MAH,
+            ESK8_BMS_FIELD_CAPACITY,
+            ESK8_BMS_FIELD_REMAINING_PRC,
+            ESK8_BMS_FIELD_CURRENT,
+            ESK8_BMS_FIELD_VOLTAGE,
+            ESK8_BMS_FIELD_TEMPRTR,
+            ESK8_BMS_FIELD_CELL_VOLTAGES
+        },
+        .ranges   = {
+            { .reg = 0x31, .size = 10, .first =  0, .num =  6 },
+            { .reg = 0x40, .size = 20, .first =  6, .num =  1 },
+        },
+    },
+    /* ESK8_BMS_DST_DEEP, ESK8_BMS_REFRESH_MEDIUM | ESK8_BMS_REFRESH_ONCE */
+    {
+        .mask     = 0x000046F0,
+        .n_ranges = 3,
+        .fields   = {
+            ESK8_BMS_FIELD_SERIAL_NUMBER,
+            ESK8_BMS_FIELD_FW_VERSION,
+            ESK8_BMS_FIELD_FACTORY_CAPACITY,
+            ESK8_BMS_FIELD_MANUFACTURE_DATE,
+            ESK8_BMS_FIELD_REMAINING_MAH,
+            ESK8_BMS_FIELD_REMAINING_PRC,
+            ESK8_BMS_FIELD_CELL_VOLTAGES
+        },
+        .ranges   = {
+            { .reg = 0x10, .size = 34, .first =  0, .num =  4 },
+            { .reg = 0x31, .size =  4, .first =  4, .num =  2 },
+            { .reg = 0x40, .size = 20, .first =  6, .num =  1 },
+        },
+    },
+    /* ESK8_BMS_DST_ALL, ESK8_BMS_REFRESH_MEDIUM | ESK8_BMS_REFRESH_ONCE */
+    {
+        .mask     = 0x000046F9,
+        .n_ranges = 3,
+        .fields   = {
+            ESK8_BMS_FIELD_SERIAL_NUMBER,
+            ESK8_BMS_FIELD_FW_VERSION,
+            ESK8_BMS_FIELD_FACTORY_CAPACITY,
+            ESK8_BMS_FIELD_MANUFACTURE_DATE,
+            ESK8_BMS_FIELD_REMAINING_MAH,
+            ESK8_BMS_FIELD_CAPACITY,
+            ESK8_BMS_FIELD_REMAINING_PRC,
+            ESK8_BMS_FIELD_TEMPRTR,
+            ESK8_BMS_FIELD_CELL_VOLTAGES
+        },
+        .ranges   = {
+            { .reg = 0x10, .size = 34, .first =  0, .num =  4 },
+            { .reg = 0x31, .size = 10, .first =  4, .num =  4 },
+            { .reg = 0x40, .size = 20, .first =  8, .num =  1 },
+        },
+    },
+    /* ESK8_BMS_DST_ALL, ESK8_BMS_REFRESH_FAST | ESK8_BMS_REFRESH_MEDIUM | ESK8_BMS_REFRESH_ONCE */
+    {
+        .mask     = 0x000046FF,
+        .n_ranges = 3,
+        .fields   = {
+            ESK8_BMS_FIELD_SERIAL_NUMBER,
+            ESK8_BMS_FIELD_FW_VERSION,
+            ESK8_BMS_FIELD_FACTORY_CAPACITY,
+            ESK8_BMS_FIELD_MANUFACTURE_DATE,
+            ESK8_BMS_FIELD_REMAINING_MAH,
+            ESK8_BMS_FIELD_CAPACITY,
+            ESK8_BMS_FIELD_REMAINING_PRC,
+            ESK8_BMS_FIELD_CURRENT,
+            ESK8_BMS_FIELD_VOLTAGE,
+            ESK8_BMS_FIELD_TEMPRTR,
+            ESK8_BMS_FIELD_CELL_VOLTAGES
+        },
+        .ranges   = {
+            { .reg = 0x10, .size = 34, .first =  0, .num =  4 },
+            { .reg = 0x31, .size = 10, .first =  4, .num =  6 },
+            { .reg = 0x40, .size = 20, .first = 10, .num =  1 },
+        },
+    },
+    /* ESK8_BMS_DST_DEEP, ESK8_BMS_REFRESH_MEDIUM | ESK8_BMS_REFRESH_SLOW */
+    {
+        .mask     = 0x00007F00,
+        .n_ranges = 2,
+        .fields   = {
+            ESK8_BMS_FIELD_ACTUAL_CAPACITY,
+            ESK8_BMS_FIELD_FULL_CYCLES,
+            ESK8_BMS_FIELD_CHARGE_COUNT,
+            ESK8_BMS_FIELD_REMAINING_MAH,
+            ESK8_BMS_FIELD_REMAINING_PRC,
+            ESK8_BMS_FIELD_HEALTH,
+            ESK8_BMS_FIELD_CELL_VOLTAGES
+        },
+        .ranges   = {
+            { .reg = 0x19, .size =  8, .first =  0, .num =  3 },
+            { .reg = 0x31, .size = 50, .first =  3, .num =  4 },
+        },
+    },
+    /* ESK8_BMS_DST_ALL, ESK8_BMS_REFRESH_MEDIUM | ESK8_BMS_REFRESH_SLOW */
+    {
+        .mask     = 0x00007F09,
+        .n_ranges = 2,
+        .fields   = {
+            ESK8_BMS_FIELD_ACTUAL_CAPACITY,
+            ESK8_BMS_FIELD_FULL_CYCLES,
+            ESK8_BMS_FIELD_CHARGE_COUNT,
+            ESK8_BMS_FIELD_REMAINING_MAH,
+            ESK8_BMS_FIELD_CAPACITY,
+            ESK8_BMS_FIELD_REMAINING_PRC,
+            ESK8_BMS_FIELD_TEMPRTR,
+            ESK8_BMS_FIELD_HEALTH,
+            ESK8_BMS_FIELD_CELL_VOLTAGES
+        },
+        .ranges   = {
+            { .reg = 0x19, .size =  8, .first =  0, .num =  3 },
+            { .reg = 0x31, .size = 50, .first =  3, .num =  6 },
+        },
+    },
+    /* ESK8_BMS_DST_ALL, ESK8_BMS_REFRESH_FAST | ESK8_BMS_REFRESH_MEDIUM | ESK8_BMS_REFRESH_SLOW */
+    {
+        .mask     = 0x00007F0F,
+        .n_ranges = 2,
+        .fields   = {
+            ESK8_BMS_FIELD_ACTUAL_CAPACITY,
+            ESK8_BMS_FIELD_FULL_CYCLES,
+            ESK8_BMS_FIELD_CHARGE_COUNT,
+            ESK8_BMS_FIELD_REMAINING_MAH,
+            ESK8_BMS_FIELD_CAPACITY,
+            ESK8_BMS_FIELD_REMAINING_PRC,
+            ESK8_BMS_FIELD_CURRENT,
+            ESK8_BMS_FIELD_VOLTAGE,
+            ESK8_BMS_FIELD_TEMPRTR,
+            ESK8_BMS_FIELD_HEALTH,
+            ESK8_BMS_FIELD_CELL_VOLTAGES
+        },
+        .ranges   = {
+            { .reg = 0x19, .size =  8, .first =  0, .num =  3 },
+            { .reg = 0x31, .size = 50, .first =  3, .num =  8 },
+        },
+    },
+    /* ESK8_BMS_DST_DEEP, ESK8_BMS_REFRESH_MEDIUM | ESK8_BMS_REFRESH_SLOW | ESK8_BMS_REFRESH_ONCE */
+    {
+        .mask     = 0x00007FF0,
+        .n_ranges = 2,
+        .fields   = {
+            ESK8_BMS_FIELD_SERIAL_NUMBER,
+            ESK8_BMS_FIELD_FW_VERSION,
+            ESK8_BMS_FIELD_FACTORY_CAPACITY,
+            ESK8_BMS_FIELD_ACTUAL_CAPACITY,
+            ESK8_BMS_FIELD_FULL_CYCLES,
+            ESK8_BMS_FIELD_CHARGE_COUNT,
+            ESK8_BMS_FIELD_MANUFACTURE_DATE,
+            ESK8_BMS_FIELD_REMAINING_MAH,
+            ESK8_BMS_FIELD_REMAINING_PRC,
+            ESK8_BMS_FIELD_HEALTH,
+            ESK8_BMS_FIELD_CELL_VOLTAGES
+        },
+        .ranges   = {
+            { .reg = 0x10, .size = 34, .first =  0, .num =  7 },
+            { .reg = 0x31, .size = 50, .first =  7, .num =  4 },
+        },
+    },
+    /* ESK8_BMS_DST_ALL, ESK8_BMS_REFRESH_MEDIUM | ESK8_BMS_REFRESH_SLOW | ESK8_BMS_REFRESH_ONCE */
+    {
+        .mask     = 0x00007FF9,
+        .n_ranges = 2,
+        .fields   = {
+            ESK8_BMS_FIELD_SERIAL_NUMBER,
+            ESK8_BMS_FIELD_FW_VERSION,
+            ESK8_BMS_FIELD_FACTORY_CAPACITY,
+            ESK8_BMS_FIELD_ACTUAL_CAPACITY,
+            ESK8_BMS_FIELD_FULL_CYCLES,
+            ESK8_BMS_FIELD_CHARGE_COUNT,
+            ESK8_BMS_FIELD_MANUFACTURE_DATE,
+            ESK8_BMS_FIELD_REMAINING_MAH,
+            ESK8_BMS_FIELD_CAPACITY,
+            ESK8_BMS_FIELD_REMAINING_PRC,
+            ESK8_BMS_FIELD_TEMPRTR,
+            ESK8_BMS_FIELD_HEALTH,
+            ESK8_BMS_FIELD_CELL_VOLTAGES
+        },
+        .ranges   = {
+            { .reg = 0x10, .size = 34, .first =  0, .num =  7 },
+            { .reg = 0x31, .size = 50, .first =  7, .num =  6 },
+        },
+    },
+    /* ESK8_BMS_DST_ALL, ESK8_BMS_REFRESH_FAST | ESK8_BMS_REFRESH_MEDIUM | ESK8_BMS_REFRESH_SLOW | ESK8_BMS_REFRESH_ONCE */
+    {
+        .mask     = 0x00007FFF,
+        .n_ranges = 2,
+        .fields   = {
+            ESK8_BMS_FIELD_SERIAL_NUMBER,
+            ESK8_BMS_FIELD_FW_VERSION,
+            ESK8_BMS_FIELD_FACTORY_CAPACITY,
+            ESK8_BMS_FIELD_ACTUAL_CAPACITY,
+            ESK8_BMS_FIELD_FULL_CYCLES,
+            ESK8_BMS_FIELD_CHARGE_COUNT,
+            ESK8_BMS_FIELD_MANUFACTURE_DATE,
+            ESK8_BMS_FIELD_REMAINING_MAH,
+            ESK8_BMS_FIELD_CAPACITY,
+            ESK8_BMS_FIELD_REMAINING_PRC,
+            ESK8_BMS_FIELD_CURRENT,
+            ESK8_BMS_FIELD_VOLTAGE,
+            ESK8_BMS_FIELD_TEMPRTR,
+            ESK8_BMS_FIELD_HEALTH,
+            ESK8_BMS_FIELD_CELL_VOLTAGES
+        },
+        .ranges   = {
+            { .reg = 0x10, .size = 34, .first =  0, .num =  7 },
+            { .reg = 0x31, .size = 50, .first =  7, .num =  8 },
+        },
+    },
+};
+
+const uint8_t
+esk8_bms_plans_num = sizeof(esk8_bms_plans) / sizeof(esk8_bms_plans[0]);
+
+_Static_assert(ESK8_BMS_FIELD_MASK(ESK8_BMS_DST_STATUS, ESK8_BMS_REFRESH_FAST) == 0x00000006, "Stale BMS read plan");
+_Static_assert(ESK8_BMS_FIELD_MASK(ESK8_BMS_DST_STATUS, ESK8_BMS_REFRESH_MEDIUM) == 0x00000009, "Stale BMS read plan");
+_Static_assert(ESK8_BMS_FIELD_MASK(ESK8_BMS_DST_STATUS, ESK8_BMS_REFRESH_FAST | ESK8_BMS_REFRESH_MEDIUM) == 0x0000000F, "Stale BMS read plan");
+_Static_assert(ESK8_BMS_FIELD_MASK(ESK8_BMS_DST_DEEP, ESK8_BMS_REFRESH_ONCE) == 0x000000F0, "Stale BMS read plan");
+_Static_assert(ESK8_BMS_FIELD_MASK(ESK8_BMS_DST_ALL, ESK8_BMS_REFRESH_FAST | ESK8_BMS_REFRESH_ONCE) == 0x000000F6, "Stale BMS read plan");
+_Static_assert(ESK8_BMS_FIELD_MASK(ESK8_BMS_DST_DEEP, ESK8_BMS_REFRESH_SLOW) == 0x00003900, "Stale BMS read plan");
+_Static_assert(ESK8_BMS_FIELD_MASK(ESK8_BMS_DST_ALL, ESK8_BMS_REFRESH_FAST | ESK8_BMS_REFRESH_SLOW) == 0x00003906, "Stale BMS read plan");
+_Static_assert(ESK8_BMS_FIELD_MASK(ESK8_BMS_DST_DEEP, ESK8_BMS_REFRESH_SLOW | ESK8_BMS_REFRESH_ONCE) == 0x000039F0, "Stale BMS read plan");
+_Static_assert(ESK8_BMS_FIELD_MASK(ESK8_BMS_DST_ALL, ESK8_BMS_REFRESH_FAST | ESK8_BMS_REFRESH_SLOW | ESK8_BMS_REFRESH_ONCE) == 0x000039F6, "Stale BMS read plan");
+_Static_assert(ESK8_BMS_FIELD_MASK(ESK8_BMS_DST_DEEP, ESK8_BMS_REFRESH_MEDIUM) == 0x00004600, "Stale BMS read plan");
+_Static_assert(ESK8_BMS_FIELD_MASK(ESK8_BMS_DST_ALL, ESK8_BMS_REFRESH_MEDIUM) == 0x00004609, "Stale BMS read plan");
+_Static_assert(ESK8_BMS_FIELD_MASK(ESK8_BMS_DST_ALL, ESK8_BMS_REFRESH_FAST | ESK8_BMS_REFRESH_MEDIUM) == 0x0000460F, "Stale BMS read plan");
+_Static_assert(ESK8_BMS_FIELD_MASK(ESK8_BMS_DST_DEEP, ESK8_BMS_REFRESH_MEDIUM | ESK8_BMS_REFRESH_ONCE) == 0x000046F0, "Stale BMS read plan");
+_Static_assert(ESK8_BMS_FIELD_MASK(ESK8_BMS_DST_ALL, ESK8_BMS_REFRESH_MEDIUM | ESK8_BMS_REFRESH_ONCE) == 0x000046F9, "Stale BMS read plan");
+_Static_assert(ESK8_BMS_FIELD_MASK(ESK8_BMS_DST_ALL, ESK8_BMS_REFRESH_FAST | ESK8_BMS_REFRESH_MEDIUM | ESK8_BMS_REFRESH_ONCE) == 0x000046FF, "Stale BMS read plan");
+_Static_assert(ESK8_BMS_FIELD_MASK(ESK8_BMS_DST_DEEP, ESK8_BMS_REFRESH_MEDIUM | ESK8_BMS_REFRESH_SLOW) == 0x00007F00, "Stale BMS read plan");
+_Static_assert(ESK8_BMS_FIELD_MASK(ESK8_BMS_DST_ALL, ESK8_BMS_REFRESH_MEDIUM | ESK8_BMS_REFRESH_SLOW) == 0x00007F09, "Stale BMS read plan");
+_Static_assert(ESK8_BMS_FIELD_MASK(ESK8_BMS_DST_ALL, ESK8_BMS_REFRESH_FAST | ESK8_BMS_REFRESH_MEDIUM | ESK8_BMS_REFRESH_SLOW) == 0x00007F0F, "Stale BMS read plan");
+_Static_assert(ESK8_BMS_FIELD_MASK(ESK8_BMS_DST_DEEP, ESK8_BMS_REFRESH_MEDIUM | ESK8_BMS_REFRESH_SLOW | ESK8_BMS_REFRESH_ONCE) == 0x00007FF0, "Stale BMS read plan");
+_Static_assert(ESK8_BMS_FIELD_MASK(ESK8_BMS_DST_ALL, ESK8_BMS_REFRESH_MEDIUM | ESK8_BMS_REFRESH_SLOW | ESK8_BMS_REFRESH_ONCE) == 0x00007FF9, "Stale BMS read plan");
+_Static_assert(ESK8_BMS_FIELD_MASK(ESK8_BMS_DST_ALL, ESK8_BMS_REFRESH_FAST | ESK8_BMS_REFRESH_MEDIUM | ESK8_BMS_REFRESH_SLOW | ESK8_BMS_REFRESH_ONCE) == 0x00007FFF, "Stale BMS read plan");
@@ -0,0 +1,198 @@
+#ifndef _ESK8_BMS_PRIV_H
+#define _ESK8_BMS_PRIV_H
+
+#include <esk8_config.h>
+#include <esk8_bms.h>
+#include <esk8_bms_fields.h>
+#include <esk8_bms_utils.h>
+#include <esk8_uart.h>
+#include <esk8_uart_bus.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+typedef struct
+{
+    esk8_bms_health_t   health;
+    int64_t             probe_us;   /* When an OPEN link may be tried again */
+}
+esk8_bms_link_t;
+
+
+/**
+ * What another master read from a pack,
+ * as heard on the wire.
+ */
+typedef struct
+{
+    esk8_bms_status_t       status;
+    esk8_bms_deep_status_t  deep;
+    int64_t                 seen_us[ESK8_BMS_FIELD_MAX];   /* 0 until heard */
+}
+esk8_bms_sniff_t;
+
+
+typedef struct esk8_bms_hndl_def esk8_bms_hndl_def_t;
+
+/**
+ * One UART, and the packs wired to it.
+ * Each port has its own worker, so packs
+ * on different ports are read at once.
+ * The UART itself is a bus, which others
+ * like the ESC may share.
+ */
+typedef struct
+{
+    esk8_bms_hndl_def_t*    bms_hndl;
+    int                     uart_port;
+    esk8_uart_bus_hndl_t    bus;
+
+    void*                   req_queue;
+    void*                   task_worker;
+    volatile bool           stop;       /* Set by `esk8_bms_deinit()` */
+    void*                   stopped;    /* Given by the worker once it is done */
+    uint8_t                 sniff_next; /* Pack to listen to next */
+
+    /* Plans for the other field masks seen lately */
+    esk8_bms_plan_t         plans[ESK8_UART_BMS_PLAN_CACHE_LEN];
+    uint8_t                 plan_next;
+}
+esk8_bms_port_t;
+
+struct esk8_bms_hndl_def
+{
+    esk8_bms_config_t   bms_cnfg;
+
+    esk8_bms_port_t     ports[ESK8_UART_BMS_MAX_PORTS];
+    uint8_t             port_num;
+    uint8_t             pack_port[ESK8_UART_BMS_CONF_NUM];  /* Index into `ports` */
+    uint8_t             pack_client[ESK8_UART_BMS_CONF_NUM];/* Bus client of each pack */
+    uint8_t             client_num;                         /* Packs given one so far */
+
+    esk8_bms_link_t     links[ESK8_UART_BMS_CONF_NUM];
+
+    /* Each pack is only touched by the worker of its port */
+    esk8_bms_sniff_t    sniffed[ESK8_UART_BMS_CONF_NUM];
+};
+
+/**
+ * Reads every range of `plan` from `pack` on
+ * `port`, and scatters the replies into `status`
+ * and `deep`. Either may be NULL when the plan
+ * has no field landing there. Each range gets up
+ * to `tries` requests, and the first range that
+ * fails them all stops the read. Replies are
+ * timed against `link`, and feed its RTT.
+ * Plans of fast fields only go ahead of
+ * others on the bus.
+ */
+esk8_err_t
+esk8_bms_read_plan(
+    esk8_bms_port_t*        port,
+    uint8_t                 pack,
+    const esk8_bms_plan_t*  plan,
+    esk8_bms_status_t*      status,
+    esk8_bms_deep_status_t* deep,
+    esk8_bms_link_t*        link,
+    int                     tries
+);
+
+/**
+ * Whether `pack` may use the bus now.
+ * Returns `ESK8_BMS_ERR_PACK_DOWN` while its
+ * link is OPEN. Sets `out_tries` to the number
+ * of tries per register the request gets.
+ */
+esk8_err_t
+esk8_bms_link_allow(
+    esk8_bms_hndl_def_t* bms_hndl,
+    uint8_t              pack,
+    int*                 out_tries
+);
+
+/**
+ * Updates the link of `pack` with the
+ * outcome of a request that used the bus.
+ * A request the pack did not answer, or
+ * answered wrong, doubles the timeout.
+ * Other errors, like the bus deadline,
+ * leave the link as it is.
+ */
+void
+esk8_bms_link_report(
+    esk8_bms_hndl_def_t* bms_hndl,
+    uint8_t              pack,
+    esk8_err_t           err
+);
+
+/**
+ * Sets `link` up for a pack never heard from,
+ * with the longest timeout.
+ */
+void
+esk8_bms_link_init(
+    esk8_bms_link_t* link
+);
+
+/**
+ * How long to wait for a reply of
+ * `reply_size` payload bytes on `link`.
+ */
+uint32_t
+esk8_bms_link_timeout_us(
+    const esk8_bms_link_t* link,
+    size_t                 reply_size
+);
+
+/**
+ * Feeds a measured round trip of a reply
+ * with `reply_size` payload bytes into
+ * the RTT estimate of `link`.
+ */
+void
+esk8_bms_link_rtt(
+    esk8_bms_link_t* link,
+    uint32_t         rtt_us,
+    size_t           reply_size
+);
+
+/**
+ * Listens to the next pack of `port` for
+ * a while, keeping what another master
+ * reads from it.
+ */
+esk8_err_t
+esk8_bms_sniff_listen(
+    esk8_bms_port_t* port
+);
+
+/**
+ * Copies the `fields` of `pack` heard lately
+ * into `status` and `deep`, which may be NULL
+ * like for `esk8_bms_read_plan()`. Returns
+ * the fields left to read.
+ */
+esk8_bms_field_mask_t
+esk8_bms_sniff_serve(
+    esk8_bms_hndl_def_t*    bms_hndl,
+    uint8_t                 pack,
+    esk8_bms_field_mask_t   fields,
+    esk8_bms_status_t*      status,
+    esk8_bms_deep_status_t* deep
+);
+
+/**
+ * Runs every `esk8_bms_req_t` queued on the
+ * `esk8_bms_port_t` in `param`, one after
+ * the other. Once asked to stop, fails the
+ * requests left with `ESK8_BMS_ERR_STOPPED`,
+ * gives `stopped`, and deletes itself.
+ */
+void
+esk8_bms_task_worker(
+    void* param
+);
+
+
+#endif /* _ESK8_BMS_PRIV_H */
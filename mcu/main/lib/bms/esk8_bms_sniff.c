@@ -0,0 +1,118 @@
+#include <esk8_config.h>
+#include <esk8_err.h>
+#include <esk8_bms.h>
+#include <esk8_bms_fields.h>
+#include <esk8_bms_priv.h>
+#include <esk8_uart_bus.h>
+
+#include <esp_timer.h>
+
+#include <string.h>
+
+
+/**
+ * Keeps every field a reply from the BMS
+ * carries, whoever asked for it.
+ */
+static void
+sniff_frame(
+    const esk8_uart_msg_t* msg,
+    void*                  ctx
+)
+{
+    esk8_bms_sniff_t* sniff = (esk8_bms_sniff_t*)ctx;
+
+    if  (
+            msg->src_address != ESK8_ADDR_BMS ||
+            msg->cmd_command != ESK8_MSG_CMD_READ_RSP
+        )
+        return;
+
+    int64_t now_us = esp_timer_get_time();
+
+    for (int f = 0; f < ESK8_BMS_FIELD_MAX; f++)
+    {
+        const esk8_bms_field_t* field = &esk8_bms_fields[f];
+        int off = (field->reg - msg->cmd_argment) * 2;
+
+        if (off < 0 || off + field->width > msg->pld_length)
+            continue;
+
+        uint8_t* dst = field->dst == ESK8_BMS_DST_STATUS ?
+            (uint8_t*) &sniff->status : (uint8_t*) &sniff->deep;
+
+        memcpy(dst + field->offset, msg->payload + off, field->width);
+        sniff->seen_us[f] = now_us;
+    }
+}
+
+esk8_err_t
+esk8_bms_sniff_listen(
+    esk8_bms_port_t* port
+)
+{
+    esk8_bms_hndl_def_t* bms_hndl = port->bms_hndl;
+    esk8_bms_config_t* bms_cnfg = &bms_hndl->bms_cnfg;
+    uint8_t port_idx = port - bms_hndl->ports;
+
+    /* Packs of this port take turns, the mux only hears one at a time */
+    uint8_t pack = port->sniff_next;
+
+    for (int i = 0; i < bms_cnfg->bat_num; i++)
+    {
+        pack = (pack + 1) % bms_cnfg->bat_num;
+
+        if (bms_hndl->pack_port[pack] == port_idx)
+            break;
+    }
+
+    port->sniff_next = pack;
+
+    return esk8_uart_bus_listen(
+        port->bus,
+        bms_hndl->pack_client[pack],
+        bms_cnfg->tx_pins[pack],
+        bms_cnfg->rx_pins[pack],
+        ESK8_UART_BMS_SNIFF_LISTEN_MS * 1000,
+        sniff_frame, &bms_hndl->sniffed[pack]
+    );
+}
+
+esk8_bms_field_mask_t
+esk8_bms_sniff_serve(
+    esk8_bms_hndl_def_t*    bms_hndl,
+    uint8_t                 pack,
+    esk8_bms_field_mask_t   fields,
+    esk8_bms_status_t*      status,
+    esk8_bms_deep_status_t* deep
+)
+{
+    esk8_bms_sniff_t* sniff = &bms_hndl->sniffed[pack];
+    int64_t now_us = esp_timer_get_time();
+
+    for (int f = 0; f < ESK8_BMS_FIELD_MAX; f++)
+    {
+        const esk8_bms_field_t* field = &esk8_bms_fields[f];
+        esk8_bms_field_mask_t bit = (esk8_bms_field_mask_t)1 << f;
+
+        /* Fields the other master does not read are left to us */
+        if  (
+                !(fields & bit) ||
+                !sniff->seen_us[f] ||
+                now_us - sniff->seen_us[f] > ESK8_UART_BMS_SNIFF_HOLD_MS * 1000ll
+            )
+            continue;
+
+        const uint8_t* src = field->dst == ESK8_BMS_DST_STATUS ?
+            (const uint8_t*) &sniff->status : (const uint8_t*) &sniff->deep;
+        uint8_t* dst = field->dst == ESK8_BMS_DST_STATUS ?
+            (uint8_t*) status : (uint8_t*) deep;
+
+        if (dst)
+            memcpy(dst + field->offset, src + field->offset, field->width);
+
+        fields &= ~bit;
+    }
+
+    return fields;
+}
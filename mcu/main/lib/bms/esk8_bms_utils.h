@@ -3,14 +3,71 @@
 
 #include <esk8_err.h>
 #include <esk8_bms.h>
+#include <esk8_bms_fields.h>
 
+
+/**
+ * One register range read, serving `num`
+ * fields of a plan, starting at `first`.
+ */
+typedef struct
+{
+    uint8_t     reg;
+    uint8_t     size;
+    uint8_t     first;
+    uint8_t     num;
+}
+esk8_bms_range_t;
+
+/**
+ * The requests needed to read a set of fields.
+ * `fields` holds the field indexes, sorted by
+ * register, that `ranges` serve.
+ */
+typedef struct
+{
+    esk8_bms_field_mask_t   mask;
+    uint8_t                 n_ranges;
+    uint8_t                 fields[ESK8_BMS_FIELD_MAX];
+    esk8_bms_range_t        ranges[ESK8_BMS_FIELD_MAX];
+}
+esk8_bms_plan_t;
+
+/**
+ * The plans of every mask `ESK8_BMS_FIELD_MASK()`
+ * can make, sorted by mask, const so they stay
+ * in flash. Generated from the field table into
+ * esk8_bms_plans.c, by mcu/host.
+ */
+extern const esk8_bms_plan_t
+esk8_bms_plans[];
+
+extern const uint8_t
+esk8_bms_plans_num;
+
+/**
+ * Merges the fields in `mask` into the fewest
+ * contiguous range reads. Small gaps between
+ * fields are read through.
+ */
+void
+esk8_bms_plan_fields(
+    esk8_bms_field_mask_t mask,
+    esk8_bms_plan_t*      out_plan
+);
+
+/**
+ * Submits a copy of `req` and blocks until the
+ * worker is done with it, for up to
+ * `ESK8_UART_BMS_WAIT_MS`. `req` is left as is,
+ * its `cb` and `ctx` are not used. On
+ * `ESK8_BMS_ERR_WAIT_TIMEOUT` the values are
+ * not touched, not even later.
+ */
 esk8_err_t
-get_data_with_response(
-    esk8_bms_hndl_t  hndl,
-    esk8_uart_addr_t dst_addr,
-    esk8_uart_reg_t  reg,
-    size_t           reg_size,
-    void             *out_val
+esk8_bms_submit_wait(
+    esk8_bms_hndl_t hndl,
+    esk8_bms_req_t* req
 );
 
 #endif /* _ESK8_BMS_UTILS_H */
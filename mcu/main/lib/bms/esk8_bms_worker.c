@@ -0,0 +1,281 @@
+#include <esk8_config.h>
+#include <esk8_err.h>
+#include <esk8_bms.h>
+#include <esk8_bms_priv.h>
+#include <esk8_bms_utils.h>
+
+#include <esp_timer.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+
+#include <stdlib.h>
+
+
+/**
+ * Returns the plan for `mask`. The fixed masks
+ * have theirs in flash, others are planned here,
+ * only if they were not among the last few.
+ */
+static const esk8_bms_plan_t*
+get_plan(
+    esk8_bms_port_t*      port,
+    esk8_bms_field_mask_t mask
+)
+{
+    int lo = 0;
+    int hi = esk8_bms_plans_num;
+
+    while (lo < hi)
+    {
+        int mid = (lo + hi) / 2;
+
+        if (esk8_bms_plans[mid].mask == mask)
+            return &esk8_bms_plans[mid];
+
+        if (esk8_bms_plans[mid].mask < mask)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    for (int i = 0; i < ESK8_UART_BMS_PLAN_CACHE_LEN; i++)
+    {
+        if (port->plans[i].mask == mask)
+            return &port->plans[i];
+    }
+
+    esk8_bms_plan_t* plan = &port->plans[port->plan_next];
+    port->plan_next = (port->plan_next + 1) % ESK8_UART_BMS_PLAN_CACHE_LEN;
+
+    esk8_bms_plan_fields(mask, plan);
+    return plan;
+}
+
+void
+esk8_bms_task_worker(
+    void* param
+)
+{
+    esk8_bms_port_t* port = (esk8_bms_port_t*)param;
+    esk8_bms_hndl_def_t* bms_hndl = port->bms_hndl;
+
+    esk8_bms_config_t* bms_cnfg = &bms_hndl->bms_cnfg;
+
+    esk8_bms_req_t req;
+
+    while (1)
+    {
+        /* When sniffing, the worker listens whenever it has nothing to do */
+        if (xQueueReceive(port->req_queue, &req, bms_cnfg->sniff ? 0 : portMAX_DELAY) != pdTRUE)
+        {
+            if (port->stop)
+                break;
+
+            if (bms_cnfg->sniff && esk8_bms_sniff_listen(port))
+                vTaskDelay(ESK8_UART_BMS_SNIFF_LISTEN_MS / portTICK_PERIOD_MS);
+
+            continue;
+        }
+
+        if (port->stop)
+        {
+            if (req.cb)
+                req.cb(&req, ESK8_BMS_ERR_STOPPED);
+
+            break;
+        }
+
+        int tries;
+        int64_t start_us = esp_timer_get_time();
+        esk8_bms_field_mask_t fields = req.fields;
+        esk8_err_t err = ESK8_OK;
+
+        if (bms_cnfg->sniff)
+            fields = esk8_bms_sniff_serve(bms_hndl, req.pack, fields, req.status, req.deep_status);
+
+        /* Heard values need no bus, even from a pack we fail to reach */
+        if (fields || !req.fields)
+            err = esk8_bms_link_allow(bms_hndl, req.pack, &tries);
+
+        if (err == ESK8_OK && fields)
+        {
+            err = esk8_bms_read_plan(
+                port,
+                req.pack,
+                get_plan(port, fields),
+                req.status,
+                req.deep_status,
+                &bms_hndl->links[req.pack],
+                tries
+            );
+
+            esk8_bms_link_report(bms_hndl, req.pack, err);
+        }
+
+        req.bus_us = esp_timer_get_time() - start_us;
+
+        if (req.cb)
+            req.cb(&req, err);
+    }
+
+    /* Callers may still be waiting on these */
+    while (xQueueReceive(port->req_queue, &req, 0) == pdTRUE)
+    {
+        if (req.cb)
+            req.cb(&req, ESK8_BMS_ERR_STOPPED);
+    }
+
+    xSemaphoreGive(port->stopped);
+    vTaskDelete(NULL);
+}
+
+esk8_err_t
+esk8_bms_submit(
+    esk8_bms_hndl_t hndl,
+    const esk8_bms_req_t* req
+)
+{
+    esk8_bms_hndl_def_t* bms_hndl = (esk8_bms_hndl_def_t*)hndl;
+
+    if (!bms_hndl || !req)
+        return ESK8_ERR_INVALID_PARAM;
+
+    if (req->pack >= bms_hndl->bms_cnfg.bat_num)
+        return ESK8_ERR_INVALID_PARAM;
+
+    esk8_bms_port_t* port = &bms_hndl->ports[bms_hndl->pack_port[req->pack]];
+
+    if (xQueueSend(port->req_queue, req, 0) != pdTRUE)
+        return ESK8_BMS_ERR_QUEUE_FULL;
+
+    return ESK8_OK;
+}
+
+
+/**
+ * A blocking read, on the heap, so the worker
+ * can still finish it after the caller gave up.
+ * Whoever of the two gets there last frees it.
+ * The values are read into it, and only copied
+ * out if the caller is still waiting.
+ */
+typedef enum
+{
+    ESK8_BMS_WAIT_PENDING,
+    ESK8_BMS_WAIT_DONE,
+    ESK8_BMS_WAIT_ABANDONED,
+}
+esk8_bms_wait_state_t;
+
+typedef struct
+{
+    SemaphoreHandle_t       done;
+    uint32_t                state;
+    esk8_err_t              err;
+    uint32_t                bus_us;
+    esk8_bms_status_t       status;
+    esk8_bms_deep_status_t  deep;
+}
+esk8_bms_wait_t;
+
+static void
+wait_free(
+    esk8_bms_wait_t* wait
+)
+{
+    vSemaphoreDelete(wait->done);
+    free(wait);
+}
+
+static void
+wait_cb(
+    const esk8_bms_req_t* req,
+    esk8_err_t err
+)
+{
+    esk8_bms_wait_t* wait = (esk8_bms_wait_t*)req->ctx;
+
+    wait->err    = err;
+    wait->bus_us = req->bus_us;
+
+    if  (
+            __atomic_exchange_n(&wait->state, ESK8_BMS_WAIT_DONE, __ATOMIC_ACQ_REL) ==
+            ESK8_BMS_WAIT_ABANDONED
+        )
+    {
+        wait_free(wait);
+        return;
+    }
+
+    xSemaphoreGive(wait->done);
+}
+
+esk8_err_t
+esk8_bms_submit_wait(
+    esk8_bms_hndl_t hndl,
+    esk8_bms_req_t* req
+)
+{
+    esk8_bms_wait_t* wait = calloc(1, sizeof(esk8_bms_wait_t));
+    if (!wait)
+        return ESK8_ERR_OOM;
+
+    wait->done = xSemaphoreCreateBinary();
+    if (!wait->done)
+    {
+        free(wait);
+        return ESK8_ERR_OOM;
+    }
+
+    wait->state = ESK8_BMS_WAIT_PENDING;
+    wait->err   = ESK8_BMS_ERR_NO_RESPONSE;
+
+    /* Fields that aren't read keep what the caller had */
+    if (req->status)
+        wait->status = *req->status;
+
+    if (req->deep_status)
+        wait->deep = *req->deep_status;
+
+    esk8_bms_req_t sub = *req;
+    sub.status      = req->status      ? &wait->status : NULL;
+    sub.deep_status = req->deep_status ? &wait->deep   : NULL;
+    sub.cb          = wait_cb;
+    sub.ctx         = wait;
+
+    esk8_err_t err = esk8_bms_submit(hndl, &sub);
+    if (err)
+    {
+        wait_free(wait);
+        return err;
+    }
+
+    if  (
+            xSemaphoreTake(wait->done, ESK8_UART_BMS_WAIT_MS / portTICK_PERIOD_MS) != pdTRUE &&
+            __atomic_exchange_n(&wait->state, ESK8_BMS_WAIT_ABANDONED, __ATOMIC_ACQ_REL) ==
+            ESK8_BMS_WAIT_PENDING
+        )
+    {
+        /* The worker frees it once it gets to it */
+        return ESK8_BMS_ERR_WAIT_TIMEOUT;
+    }
+
+    /* Done just as we gave up, its give is on the way */
+    if (wait->state == ESK8_BMS_WAIT_ABANDONED)
+        xSemaphoreTake(wait->done, portMAX_DELAY);
+
+    if (req->status)
+        *req->status = wait->status;
+
+    if (req->deep_status)
+        *req->deep_status = wait->deep;
+
+    req->bus_us = wait->bus_us;
+    err = wait->err;
+
+    wait_free(wait);
+    return err;
+}
@@ -8,15 +8,54 @@
 #define ESK8_UART_BMS_NUM                         UART_NUM_1
 #define ESK8_UART_BMS_TX_PINS                     { GPIO_NUM_14, GPIO_NUM_14, GPIO_NUM_14, GPIO_NUM_14 }
 #define ESK8_UART_BMS_RX_PINS                     { GPIO_NUM_27, GPIO_NUM_26, GPIO_NUM_25, GPIO_NUM_33 }
+#define ESK8_UART_BMS_PORTS                       { UART_NUM_1, UART_NUM_1, UART_NUM_1, UART_NUM_1 }  /* UART of each BMS. Packs on other UARTs need their own TX pins */
+#define ESK8_UART_BMS_MAX_PORTS                   2               /* Number of UARTs the BMSs may be spread over                              */
 #define ESK8_UART_BMS_CONF_NUM                    4               /* Number of BMS configured                                                 */
 #define ESK8_UART_BMS_BUFF_SIZE                   1000
+#define ESK8_UART_BMS_PLAN_MAX_GAP                8               /* Registers nobody asked for that may be read to merge two reads           */
+#define ESK8_UART_BMS_PLAN_MAX_READ               0x40            /* Max bytes read in a single request                                       */
+#define ESK8_UART_BMS_EVT_QUEUE_LEN               20              /* Number of UART driver events that can be queued                          */
+#define ESK8_UART_BMS_REQ_QUEUE_LEN               8               /* Number of BMS requests that can wait for the worker                      */
+#define ESK8_UART_BMS_PLAN_CACHE_LEN              4               /* Read plans the worker keeps for masks with no plan in flash              */
+#define ESK8_UART_BMS_TASK_PRIORITY               2
+#define ESK8_UART_BMS_WAIT_MS                     2000            /* Longest a blocking read waits for the worker, queue included             */
+#define ESK8_UART_BMS_BREAKER_FAILS               3               /* Failed requests in a row before a pack is taken as down                  */
+#define ESK8_UART_BMS_BACKOFF_MIN_MS              500             /* Wait before probing a pack that just went down                           */
+#define ESK8_UART_BMS_BACKOFF_MAX_MS              30000           /* Longest wait between probes of a pack that stays down                    */
+#define ESK8_UART_BMS_RTO_MIN_MS                  5               /* Shortest wait for a reply, on top of its wire time                       */
+#define ESK8_UART_BMS_RTO_MAX_MS                  50              /* Longest wait for a reply, also used before a pack was timed              */
+#define ESK8_UART_BMS_SNIFF                       0               /* Another master, like a stock controller, polls the packs. Listen to it   */
+#define ESK8_UART_BMS_SNIFF_LISTEN_MS             20              /* Listening time per go, new requests wait for it to end                   */
+#define ESK8_UART_BMS_SNIFF_HOLD_MS               5000            /* Heard values are served this long, then read by us again                 */
+
+
+/* ========================================== ESC Configurations ========================================= */
+#define ESK8_UART_ESC_NUM                         UART_NUM_2      /* May share a BMS UART, the bus puts the ESC first                         */
+#define ESK8_UART_ESC_TX_PIN                      GPIO_NUM_17
+#define ESK8_UART_ESC_RX_PIN                      GPIO_NUM_16
+#define ESK8_UART_ESC_POLL_MS                     50              /* Telemetry poll period, 20 Hz                                             */
+#define ESK8_UART_ESC_TIMEOUT_MS                  10              /* Wait for each reply, on top of its wire time                             */
+#define ESK8_UART_ESC_BUFF_SIZE                   256
+#define ESK8_UART_ESC_EVT_QUEUE_LEN               10
+#define ESK8_UART_ESC_TASK_PRIORITY               3               /* Above the BMS workers, telemetry goes stale fast                        */
+#define ESK8_ESC_WHEEL_MM                         678             /* Wheel circumference, for the RPM                                         */
+
+
+/* ========================================== Onboard Configurations ===================================== */
+#define ESK8_OBRD_BMS_TICK_MS                     50              /* How often the BMS scheduler looks for due reads                          */
+#define ESK8_OBRD_BMS_FAST_MS                     200             /* Refresh period of current and voltage                                    */
+#define ESK8_OBRD_BMS_SLOW_MS                     60000           /* Refresh period of capacity, cycles and health                            */
+#define ESK8_OBRD_BMS_BUS_BUDGET_PRC              50              /* Share of the BMS bus time the scheduler may use                          */
+#define ESK8_OBRD_BUS_STATS_MS                    10000           /* How often the bus use of each BMS pack and of the ESC is logged          */
 
 
 /* ========================================== PS2 Trackpad Configrations ================================= */
 #define ESK8_PS2_DATA_PIN                         GPIO_NUM_22
 #define ESK8_PS2_CLOCK_PIN                        GPIO_NUM_23
 #define ESK8_PS2_MOVEMENT_TIMEOUT_MS              5000            /* Timeout, in mS, between movement pkt sequences.                       */
-#define ESK8_PS2_QUEUE_LENGTH                     1024            /* Number of bytes a queue can handle. These are uint8_t's.               */
+#define ESK8_PS2_QUEUE_LENGTH                     16              /* Command response frames. Movement packets go through a ring.           */
+#define ESK8_PS2_SMPL_RATE                        200             /* Reports per second asked of relative devices.                          */
+#define ESK8_PS2_ABS_DIV                          16              /* Absolute position units per relative count, in absolute mode.          */
 #define ESK8_PS2_TASK_PRIORITY                    2
 
 
@@ -41,6 +80,10 @@
 
 /* ========================================== RMT Configurations ========================================= */
 #define ESK8_RMT_PS2_CMD_TIMEOUT_ms               200
+#define ESK8_RMT_CTRL_MS                          10              /* Output update period. Movement is summed up in between.                */
+#define ESK8_RMT_PS2_POLL                         0               /* Poll the trackpad once per control tick, instead of streaming.         */
+#define ESK8_RMT_PS2_POLL_MARGIN_US               1000            /* Polls start this long ahead of the tick, on top of what they took.     */
+#define ESK8_RMT_PS2_PROBE_MS                     30000           /* Ask a silent trackpad again after this long. 0 waits for it to plug.   */
 
 
 #endif  /* _ESK8_CONTROLLER_CONFIG_H */
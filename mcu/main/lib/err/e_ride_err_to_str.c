@@ -53,6 +53,14 @@ const char* esk8_err_to_str(
         case ESK8_ERR_REMT_NOINIT: return "ESK8_ERR_REMT_NOINIT";
         case ESK8_ERR_REMT_REINIT: return "ESK8_ERR_REMT_REINIT";
         case ESK8_ERR_REMT_BAD_STATE: return "ESK8_ERR_REMT_BAD_STATE";
+        case ESK8_UART_MSG_ERR_INCOMPLETE: return "ESK8_UART_MSG_ERR_INCOMPLETE";
+        case ESK8_BMS_ERR_QUEUE_FULL: return "ESK8_BMS_ERR_QUEUE_FULL";
+        case ESK8_BMS_ERR_PACK_DOWN: return "ESK8_BMS_ERR_PACK_DOWN";
+        case ESK8_UART_ERR_DEADLINE: return "ESK8_UART_ERR_DEADLINE";
+        case ESK8_PS2_ERR_DEV_RESET: return "ESK8_PS2_ERR_DEV_RESET";
+        case ESK8_BMS_ERR_WAIT_TIMEOUT: return "ESK8_BMS_ERR_WAIT_TIMEOUT";
+        case ESK8_ERR_REMT_TMR: return "ESK8_ERR_REMT_TMR";
+        case ESK8_BMS_ERR_STOPPED: return "ESK8_BMS_ERR_STOPPED";
 
         default:
             return "unknown_error";
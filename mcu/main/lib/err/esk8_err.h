@@ -56,6 +56,14 @@ typedef enum esk8_err_t
     ESK8_ERR_REMT_NOINIT,
     ESK8_ERR_REMT_REINIT,
     ESK8_ERR_REMT_BAD_STATE,
+    ESK8_UART_MSG_ERR_INCOMPLETE,         /* Not enough bytes yet for a full message */
+    ESK8_BMS_ERR_QUEUE_FULL,              /* Too many BMS requests pending */
+    ESK8_BMS_ERR_PACK_DOWN,               /* Pack stopped answering, not asked again until its backoff ends */
+    ESK8_UART_ERR_DEADLINE,               /* Could not get the UART bus before the deadline */
+    ESK8_PS2_ERR_DEV_RESET,               /* Device announced it powered up again, it has to be set up again */
+    ESK8_BMS_ERR_WAIT_TIMEOUT,            /* The BMS worker did not finish a blocking read in time */
+    ESK8_ERR_REMT_TMR,                    /* The control loop timer could not be started */
+    ESK8_BMS_ERR_STOPPED,                 /* The BMS lib was stopped before the request ran */
 }
 esk8_err_t;
 
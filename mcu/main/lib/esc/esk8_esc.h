@@ -0,0 +1,105 @@
+#ifndef _ESK8_ESC_H
+#define _ESK8_ESC_H
+
+#include <esk8_config.h>
+#include <esk8_uart.h>
+#include <esk8_uart_bus.h>
+#include <esk8_err.h>
+
+#include <driver/uart.h>
+
+
+typedef struct __attribute__((__packed__))
+{
+    int16_t  speed;         // m/h, negative when rolling backwards
+    uint16_t wheel_rpm;     // From `speed` and ESK8_ESC_WHEEL_MM
+    int16_t  current;       // Motor current, in 10 mA
+    int16_t  temperature;   // ESC temperature, in 0.1 C
+    uint16_t error;         // Error code, 0 if none
+    uint16_t warning;       // Warning code, 0 if none
+    uint16_t flags;         // Status bits, as the ESC sends them
+}
+esk8_esc_telemetry_t;
+
+/**
+ * Called by the ESC worker after every poll.
+ * `telemetry` holds the values of the last poll
+ * that worked, `err` is the outcome of this one.
+ * Runs on the worker task, keep it short.
+ **/
+typedef void (*esk8_esc_cb_t)(
+    const esk8_esc_telemetry_t* telemetry,
+    esk8_err_t err,
+    void* ctx
+);
+
+typedef struct
+{
+    int                 uart_port;
+    uint8_t             tx_pin;
+    uint8_t             rx_pin;
+    uint32_t            poll_ms;
+    uint32_t            timeout_ms;     // Wait for each reply
+    uint16_t            wheel_mm;       // Wheel circumference
+    esk8_esc_cb_t       cb;
+    void*               ctx;
+}
+esk8_esc_config_t;
+
+typedef void*
+esk8_esc_hndl_t;
+
+/**
+ * Installs the ESC UART, and starts polling
+ * its telemetry every `poll_ms`.
+ **/
+esk8_err_t
+esk8_esc_init(
+    esk8_esc_config_t* esc_cnfg,
+    esk8_esc_hndl_t* out_hndl
+);
+
+/**
+ * Same as `esk8_esc_init()`, but uses
+ * values from `esk8_config.h`.
+ **/
+esk8_err_t
+esk8_esc_init_from_config_h(
+    esk8_esc_cb_t cb,
+    void* ctx,
+    esk8_esc_hndl_t* out_hndl
+);
+
+/**
+ * Stops polling, once the poll in flight
+ * and its callback are done, and lets go of
+ * the UART. `hndl` is freed.
+ **/
+esk8_err_t
+esk8_esc_deinit(
+    esk8_esc_hndl_t hndl
+);
+
+/**
+ * Copies the last telemetry read into
+ * `out_telemetry`. Returns the error of
+ * the last poll, the copy is made anyway.
+ **/
+esk8_err_t
+esk8_esc_get_telemetry(
+    esk8_esc_hndl_t hndl,
+    esk8_esc_telemetry_t* out_telemetry
+);
+
+/**
+ * Copies the bus use of the ESC polls,
+ * since init, into `out_stats`.
+ **/
+esk8_err_t
+esk8_esc_get_bus_stats(
+    esk8_esc_hndl_t hndl,
+    esk8_uart_bus_stats_t* out_stats
+);
+
+
+#endif /* _ESK8_ESC_H */
@@ -0,0 +1,111 @@
+#include <esk8_esc.h>
+#include <esk8_esc_priv.h>
+#include <esk8_uart_bus.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+
+
+esk8_err_t
+esk8_esc_init(
+    esk8_esc_config_t* esc_cnfg,
+    esk8_esc_hndl_t* out_hndl
+)
+{
+    esk8_err_t esk8_err;
+    bool has_client = false;
+
+    if (!esc_cnfg->poll_ms || !esc_cnfg->wheel_mm)
+        return ESK8_ERR_INVALID_PARAM;
+
+    esk8_esc_hndl_def_t* esc_hndl = calloc(1, sizeof(esk8_esc_hndl_def_t));
+    if (!esc_hndl)
+        return ESK8_ERR_OOM;
+
+    esc_hndl->esc_cnfg = *esc_cnfg;
+    esc_hndl->err      = ESK8_BMS_ERR_NO_RESPONSE;
+
+    esk8_err = esk8_uart_bus_open(
+        esc_cnfg->uart_port,
+        esc_cnfg->tx_pin,
+        esc_cnfg->rx_pin,
+        ESK8_UART_ESC_BUFF_SIZE,
+        ESK8_UART_ESC_EVT_QUEUE_LEN,
+        &esc_hndl->bus
+    );
+
+    if (esk8_err)
+        goto fail;
+
+    esk8_err = esk8_uart_bus_client_add(esc_hndl->bus, "esc", &esc_hndl->client);
+
+    if (esk8_err)
+        goto fail;
+
+    has_client = true;
+    esc_hndl->lock    = xSemaphoreCreateMutex();
+    esc_hndl->stopped = xSemaphoreCreateBinary();
+
+    if (!esc_hndl->lock || !esc_hndl->stopped)
+    {
+        esk8_err = ESK8_ERR_OOM;
+        goto fail;
+    }
+
+    if  (
+            xTaskCreate(
+                esk8_esc_task_worker,
+                "ESK8_TASK_ESC_UART", 3072,
+                esc_hndl, ESK8_UART_ESC_TASK_PRIORITY,
+                (TaskHandle_t*) &esc_hndl->task_worker
+            ) != pdPASS
+        )
+    {
+        esk8_err = ESK8_ERR_OOM;
+        goto fail;
+    }
+
+    (*out_hndl) = esc_hndl;
+    return ESK8_OK;
+
+fail:
+    if (esc_hndl->lock)
+        vSemaphoreDelete(esc_hndl->lock);
+
+    if (esc_hndl->stopped)
+        vSemaphoreDelete(esc_hndl->stopped);
+
+    if (has_client)
+        esk8_uart_bus_client_remove(esc_hndl->bus, esc_hndl->client);
+
+    if (esc_hndl->bus)
+        esk8_uart_bus_close(esc_hndl->bus);
+
+    free(esc_hndl);
+    return esk8_err;
+}
+
+esk8_err_t
+esk8_esc_deinit(
+    esk8_esc_hndl_t hndl
+)
+{
+    esk8_esc_hndl_def_t* esc_hndl = (esk8_esc_hndl_def_t*)hndl;
+
+    if (!esc_hndl)
+        return ESK8_ERR_INVALID_PARAM;
+
+    /* Not deleted from here, it may be holding the bus or the lock */
+    esc_hndl->stop = true;
+    xSemaphoreTake(esc_hndl->stopped, portMAX_DELAY);
+
+    esk8_uart_bus_client_remove(esc_hndl->bus, esc_hndl->client);
+    esk8_uart_bus_close(esc_hndl->bus);
+
+    vSemaphoreDelete(esc_hndl->lock);
+    vSemaphoreDelete(esc_hndl->stopped);
+    free(esc_hndl);
+
+    return ESK8_OK;
+}
@@ -0,0 +1,28 @@
+#include <esk8_config.h>
+#include <esk8_uart.h>
+#include <esk8_esc.h>
+
+#include <driver/uart.h>
+#include <driver/gpio.h>
+
+
+esk8_err_t
+esk8_esc_init_from_config_h(
+    esk8_esc_cb_t cb,
+    void* ctx,
+    esk8_esc_hndl_t* out_hndl
+)
+{
+    esk8_esc_config_t esc_cnfg = {
+        .uart_port  = ESK8_UART_ESC_NUM,
+        .tx_pin     = ESK8_UART_ESC_TX_PIN,
+        .rx_pin     = ESK8_UART_ESC_RX_PIN,
+        .poll_ms    = ESK8_UART_ESC_POLL_MS,
+        .timeout_ms = ESK8_UART_ESC_TIMEOUT_MS,
+        .wheel_mm   = ESK8_ESC_WHEEL_MM,
+        .cb         = cb,
+        .ctx        = ctx,
+    };
+
+    return esk8_esc_init(&esc_cnfg, out_hndl);
+}
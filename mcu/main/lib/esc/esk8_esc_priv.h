@@ -0,0 +1,39 @@
+#ifndef _ESK8_ESC_PRIV_H
+#define _ESK8_ESC_PRIV_H
+
+#include <esk8_config.h>
+#include <esk8_esc.h>
+#include <esk8_uart.h>
+#include <esk8_uart_bus.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+typedef struct
+{
+    esk8_esc_config_t       esc_cnfg;
+    esk8_uart_bus_hndl_t    bus;
+    uint8_t                 client;
+    void*                   task_worker;
+    volatile bool           stop;       /* Asks the worker to quit */
+    void*                   stopped;    /* Given by the worker as it quits */
+
+    /* Written by the worker only, `lock` keeps copies whole */
+    void*                   lock;
+    esk8_esc_telemetry_t    telemetry;
+    esk8_err_t              err;
+}
+esk8_esc_hndl_def_t;
+
+/**
+ * Polls the ESC telemetry of the
+ * `esk8_esc_hndl_def_t` in `param`.
+ */
+void
+esk8_esc_task_worker(
+    void* param
+);
+
+
+#endif /* _ESK8_ESC_PRIV_H */
@@ -0,0 +1,157 @@
+#include <esk8_config.h>
+#include <esk8_err.h>
+#include <esk8_esc.h>
+#include <esk8_esc_priv.h>
+#include <esk8_uart_bus.h>
+
+#include <esp_timer.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+
+/* Registers from the status block to the temperature, in one read */
+#define ESC_BLOCK_FIRST     ESK8_REG_ESC_ERROR
+#define ESC_BLOCK_LAST      ESK8_REG_ESC_TEMPRTR
+#define ESC_BLOCK_SIZE      ((ESC_BLOCK_LAST - ESC_BLOCK_FIRST + 1) * 2)
+
+#define ESC_BLOCK_WORD(block, reg) \
+    ((uint16_t)(block)[((reg) - ESC_BLOCK_FIRST) * 2] | ((uint16_t)(block)[((reg) - ESC_BLOCK_FIRST) * 2 + 1] << 8))
+
+
+/**
+ * Reads one round of telemetry into `out`.
+ * Values are only written once all of
+ * them were read. Reads still waiting for
+ * the bus at `deadline_us` are given up,
+ * the next poll is due by then.
+ */
+static esk8_err_t
+esc_poll(
+    esk8_esc_hndl_def_t*  esc_hndl,
+    int64_t               deadline_us,
+    esk8_esc_telemetry_t* out
+)
+{
+    uint8_t block[ESC_BLOCK_SIZE];
+    int16_t current;
+    uint32_t timeout_us = esc_hndl->esc_cnfg.timeout_ms * 1000;
+
+    /* Telemetry goes stale fast, a new poll beats a retry */
+    esk8_uart_trx_t trx = {
+        .prio        = ESK8_UART_PRIO_CONTROL,
+        .deadline_us = deadline_us,
+        .tx_pin      = esc_hndl->esc_cnfg.tx_pin,
+        .rx_pin      = esc_hndl->esc_cnfg.rx_pin,
+        .dst_addr    = ESK8_ADDR_ESC,
+        .reg         = ESC_BLOCK_FIRST,
+        .reg_size    = sizeof(block),
+        .tries       = 1,
+        .timeout_us  = timeout_us + ESK8_UART_WIRE_US(ESK8_MSG_SIZE(sizeof(block))),
+    };
+
+    ESK8_ERRCHECK_THROW(esk8_uart_bus_regread(
+        esc_hndl->bus, esc_hndl->client,
+        &trx, block, NULL
+    ));
+
+    trx.reg        = ESK8_REG_ESC_CURRENT;
+    trx.reg_size   = sizeof(current);
+    trx.timeout_us = timeout_us + ESK8_UART_WIRE_US(ESK8_MSG_SIZE(sizeof(current)));
+
+    ESK8_ERRCHECK_THROW(esk8_uart_bus_regread(
+        esc_hndl->bus, esc_hndl->client,
+        &trx, &current, NULL
+    ));
+
+    int16_t speed = ESC_BLOCK_WORD(block, ESK8_REG_ESC_SPEED);
+    uint32_t abs_speed = speed < 0 ? -speed : speed;
+
+    out->speed       = speed;
+    out->wheel_rpm   = abs_speed * 1000 / 60 / esc_hndl->esc_cnfg.wheel_mm;
+    out->current     = current;
+    out->temperature = ESC_BLOCK_WORD(block, ESK8_REG_ESC_TEMPRTR);
+    out->error       = ESC_BLOCK_WORD(block, ESK8_REG_ESC_ERROR);
+    out->warning     = ESC_BLOCK_WORD(block, ESK8_REG_ESC_WARNING);
+    out->flags       = ESC_BLOCK_WORD(block, ESK8_REG_ESC_FLAGS);
+
+    return ESK8_OK;
+}
+
+void
+esk8_esc_task_worker(
+    void* param
+)
+{
+    esk8_esc_hndl_def_t* esc_hndl = (esk8_esc_hndl_def_t*)param;
+    esk8_esc_config_t* esc_cnfg = &esc_hndl->esc_cnfg;
+
+    TickType_t period = esc_cnfg->poll_ms / portTICK_PERIOD_MS;
+    TickType_t last_wake = xTaskGetTickCount();
+
+    if (!period)
+        period = 1;
+
+    while (!esc_hndl->stop)
+    {
+        esk8_esc_telemetry_t telemetry;
+        esk8_err_t err = esc_poll(
+            esc_hndl,
+            esp_timer_get_time() + esc_cnfg->poll_ms * 1000,
+            &telemetry
+        );
+
+        xSemaphoreTake(esc_hndl->lock, portMAX_DELAY);
+
+        if (!err)
+            esc_hndl->telemetry = telemetry;
+
+        esc_hndl->err = err;
+        telemetry = esc_hndl->telemetry;
+
+        xSemaphoreGive(esc_hndl->lock);
+
+        if (esc_cnfg->cb)
+            esc_cnfg->cb(&telemetry, err, esc_cnfg->ctx);
+
+        /* A fixed rate, however long the poll took */
+        vTaskDelayUntil(&last_wake, period);
+    }
+
+    xSemaphoreGive(esc_hndl->stopped);
+    vTaskDelete(NULL);
+}
+
+esk8_err_t
+esk8_esc_get_telemetry(
+    esk8_esc_hndl_t hndl,
+    esk8_esc_telemetry_t* out_telemetry
+)
+{
+    esk8_esc_hndl_def_t* esc_hndl = (esk8_esc_hndl_def_t*)hndl;
+
+    if (!esc_hndl)
+        return ESK8_ERR_INVALID_PARAM;
+
+    xSemaphoreTake(esc_hndl->lock, portMAX_DELAY);
+
+    esk8_err_t err = esc_hndl->err;
+    (*out_telemetry) = esc_hndl->telemetry;
+
+    xSemaphoreGive(esc_hndl->lock);
+    return err;
+}
+
+esk8_err_t
+esk8_esc_get_bus_stats(
+    esk8_esc_hndl_t hndl,
+    esk8_uart_bus_stats_t* out_stats
+)
+{
+    esk8_esc_hndl_def_t* esc_hndl = (esk8_esc_hndl_def_t*)hndl;
+
+    if (!esc_hndl)
+        return ESK8_ERR_INVALID_PARAM;
+
+    return esk8_uart_bus_get_stats(esc_hndl->bus, esc_hndl->client, out_stats);
+}
@@ -0,0 +1,100 @@
+#include <esk8_hist.h>
+#include <esk8_log.h>
+
+#include <stdbool.h>
+#include <stdio.h>
+
+
+/* Longest bucket entry: " >=4194304:4294967295" */
+#define ESK8_HIST_ENTRY_LEN 22
+#define ESK8_HIST_LINE_LEN  (4 * ESK8_HIST_ENTRY_LEN)
+
+
+void
+esk8_hist_add(
+    esk8_hist_t* hist,
+    int64_t      us
+)
+{
+    uint32_t v = us < 0 ? 0 : us > UINT32_MAX ? UINT32_MAX : (uint32_t)us;
+    int i = v ? 32 - __builtin_clz(v) : 0;
+
+    if (i >= ESK8_HIST_BUCKETS)
+        i = ESK8_HIST_BUCKETS - 1;
+
+    hist->buckets[i]++;
+    hist->sum_us += v;
+    hist->n++;
+
+    if (v > hist->max_us)
+        hist->max_us = v;
+}
+
+
+uint32_t
+esk8_hist_pct(
+    const esk8_hist_t* hist,
+    int                pct
+)
+{
+    if (!hist->n)
+        return 0;
+
+    uint64_t want = ((uint64_t)hist->n * pct + 99) / 100;
+    uint64_t seen = 0;
+
+    for (int i = 0; i < ESK8_HIST_BUCKETS; i++)
+    {
+        seen += hist->buckets[i];
+        if (seen >= want)
+            return i < ESK8_HIST_BUCKETS - 1 ? 1u << i : hist->max_us;
+    }
+
+    return hist->max_us;
+}
+
+
+void
+esk8_hist_print(
+    esk8_log_tag_t     tag,
+    const char*        name,
+    const esk8_hist_t* hist
+)
+{
+    esk8_log_I(tag,
+        "%s: n %u, mean %u us, p50 < %u us, p99 < %u us, max %u us\n",
+        name,
+        hist->n,
+        hist->n ? (uint32_t)(hist->sum_us / hist->n) : 0,
+        esk8_hist_pct(hist, 50),
+        esk8_hist_pct(hist, 99),
+        hist->max_us
+    );
+
+    /* A few buckets per line, so it fits on a small task stack */
+    char line[ESK8_HIST_LINE_LEN];
+    int len = 0;
+
+    for (int i = 0; i < ESK8_HIST_BUCKETS; i++)
+    {
+        if (!hist->buckets[i])
+            continue;
+
+        if (len > sizeof(line) - ESK8_HIST_ENTRY_LEN)
+        {
+            esk8_log_I(tag, "%s:%s\n", name, line);
+            len = 0;
+        }
+
+        bool last = i == ESK8_HIST_BUCKETS - 1;
+
+        len += snprintf(line + len, sizeof(line) - len,
+            " %s%u:%u",
+            last ? ">=" : "<",
+            last ? 1u << (i - 1) : 1u << i,
+            hist->buckets[i]);
+    }
+
+    if (len)
+        esk8_log_I(tag, "%s:%s\n", name, line);
+}
@@ -0,0 +1,56 @@
+#ifndef _ESK8_HIST_H
+#define _ESK8_HIST_H
+
+#include <esk8_log.h>
+
+#include <stdint.h>
+
+
+/* Power of two buckets, the last one takes everything from 4 s up */
+#define ESK8_HIST_BUCKETS 24
+
+/**
+ * Fixed size histogram of durations, in us.
+ * Bucket `i` counts the ones under 2^i us,
+ * and from 2^(i-1) us up. Only one task may
+ * add to it, readers may see it mid update.
+ **/
+typedef struct
+{
+    uint32_t n;
+    uint32_t max_us;
+    uint64_t sum_us;
+    uint32_t buckets[ESK8_HIST_BUCKETS];
+}
+esk8_hist_t;
+
+void
+esk8_hist_add(
+    esk8_hist_t* hist,
+    int64_t      us
+);
+
+/**
+ * Upper bound, in us, of the bucket the
+ * `pct` percentile falls in. 0 if empty.
+ **/
+uint32_t
+esk8_hist_pct(
+    const esk8_hist_t* hist,
+    int                pct
+);
+
+/**
+ * Logs `n`, mean, p50, p99 and max, then
+ * the buckets that aren't empty, a few
+ * per line. Uses little stack.
+ **/
+void
+esk8_hist_print(
+    esk8_log_tag_t     tag,
+    const char*        name,
+    const esk8_hist_t* hist
+);
+
+
+#endif /* _ESK8_HIST_H */
@@ -3,6 +3,7 @@
 
 #define ESK8_NVS_STORAGE_NAME "esk8"
 
+#include <esk8_config.h>
 #include <esk8_err.h>
 
 #include <stdint.h>
@@ -15,15 +16,20 @@ typedef enum
     ESK8_NVS_AUTH_HASH,
     ESK8_NVS_AUTH_HASH_N,
     ESK8_NVS_CONN_ADDR,
+    ESK8_NVS_BMS_IDENT,
     ESK8_NVS_IDX_MAX,
 }
 esk8_nvs_val_idx_t;
 
+/* Serial number, firmware version, manufacture date and factory capacity */
+#define ESK8_NVS_BMS_IDENT_LEN 20
+
 typedef union
 {
     uint32_t  auth_hash_n;
     uint8_t   auth_hash[32];
     uint8_t   conn_addr[6];
+    uint8_t   bms_ident[ESK8_UART_BMS_CONF_NUM][ESK8_NVS_BMS_IDENT_LEN];
 }
 esk8_nvs_val_t;
 
@@ -5,9 +5,14 @@
 #include <esk8_config.h>
 #include <esk8_log.h>
 #include <esk8_bms.h>
+#include <esk8_esc.h>
 #include <esk8_btn.h>
 #include <esk8_pwm.h>
 
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+
 
 esk8_onboard_t esk8_onboard = { 0 };
 
@@ -47,6 +52,17 @@ esk8_onboard_start(
         return err;
     }
 
+    err = esk8_esc_init_from_config_h(
+        esk8_onboard_esc_telemetry, NULL,
+        &esk8_onboard.hndl_esc
+    );
+
+    if (err)
+    {
+        esk8_onboard_stop();
+        return err;
+    }
+
     err = esk8_pwm_sgnl_init_from_config_h(
         &esk8_onboard.hndl_pwm
     );
@@ -57,6 +73,25 @@ esk8_onboard_start(
         return err;
     }
 
+    err = esk8_onboard_sched_init(
+        &esk8_onboard.bms_sched, cnfg->bms_update_ms,
+        xTaskGetTickCount() * portTICK_PERIOD_MS
+    );
+
+    if (err)
+    {
+        esk8_onboard_stop();
+        return err;
+    }
+
+    esk8_onboard.bms_stopped = xSemaphoreCreateBinary();
+
+    if (!esk8_onboard.bms_stopped)
+    {
+        esk8_onboard_stop();
+        return ESK8_ERR_OOM;
+    }
+
     if  (
             xTaskCreate(
                 esk8_onboard_task_bms,
@@ -124,8 +159,24 @@ esk8_onboard_stop(
     if (esk8_onboard.task_btn)
         vTaskDelete(esk8_onboard.task_btn);
 
-    if (esk8_onboard.task_btn)
-        vTaskDelete(esk8_onboard.task_btn);
+    /* Not deleted from here, it may be saving identities under their lock */
+    if (esk8_onboard.task_bms)
+    {
+        esk8_onboard.bms_stop = true;
+        xSemaphoreTake(esk8_onboard.bms_stopped, portMAX_DELAY);
+    }
+
+    if (esk8_onboard.bms_stopped)
+        vSemaphoreDelete(esk8_onboard.bms_stopped);
+
+    /* Calls back every request left, before what the callbacks touch goes */
+    if (esk8_onboard.hndl_bms)
+        esk8_bms_deinit(esk8_onboard.hndl_bms);
+
+    if (esk8_onboard.hndl_esc)
+        esk8_esc_deinit(esk8_onboard.hndl_esc);
+
+    esk8_onboard_sched_deinit(&esk8_onboard.bms_sched);
 
     if (esk8_onboard.bms_stat)
         free(esk8_onboard.bms_stat);
@@ -4,6 +4,7 @@
 #include <esk8_config.h>
 #include <esk8_err.h>
 #include <esk8_bms.h>
+#include <esk8_esc.h>
 #include <esk8_btn.h>
 #include <esk8_pwm.h>
 #include <esk8_auth.h>
@@ -22,7 +23,7 @@ esk8_onboard_state_t;
 
 typedef struct
 {
-    int bms_update_ms;
+    int bms_update_ms;      /* Refresh period of the medium class (temperatures, cells) */
     int btn_timeout_ms;
     int ps2_timeout_ms;
 }
@@ -1,4 +1,6 @@
 #include <esk8_bms.h>
+#include <esk8_bms_fields.h>
+#include <esk8_esc.h>
 #include <esk8_btn.h>
 #include <esk8_log.h>
 
@@ -6,66 +8,239 @@
 #include <esk8_onboard.h>
 #include <esk8_onboard_priv.h>
 
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
 
-void
-esk8_onboard_task_bms(
-    void* param
+#include <esp_timer.h>
+
+
+#define NOW_MS() (xTaskGetTickCount() * portTICK_PERIOD_MS)
+
+
+/**
+ * Publishes a pack's values once the
+ * BMS worker is done reading them.
+ */
+static void
+esk8_onboard_bms_done(
+    const esk8_bms_req_t* req,
+    esk8_err_t bms_err
 )
 {
-    if (!esk8_onboard.state)
-        return;
-
     esk8_err_t err;
-    esk8_onboard_cnfg_t* cnfg = (esk8_onboard_cnfg_t*)param;
 
-    while (1)
+    esk8_onboard_sched_done(
+        &esk8_onboard.bms_sched,
+        req->pack, req->fields,
+        req->deep_status,
+        bms_err, req->bus_us
+    );
+
+    if  (
+            bms_err &&
+            bms_err != ESK8_BMS_ERR_PACK_DOWN &&
+            bms_err != ESK8_BMS_ERR_STOPPED
+        )
     {
-        for (int i=0; i<ESK8_UART_BMS_CONF_NUM; i++)
-        {
+        esk8_log_I(ESK8_TAG_ONB,
+            "Got: %s reading BMS status at index: %d.\n",
+            esk8_err_to_str(bms_err), req->pack
+        );
+    }
 
-            esk8_bms_set_pin(esk8_onboard.hndl_bms, i);
-            err = esk8_bms_get_status(
-                esk8_onboard.hndl_bms,
-                &esk8_onboard.bms_stat[i]
-            );
+    esk8_bms_health_t health;
+    esk8_bms_health_t* last = &esk8_onboard.bms_health[req->pack];
+
+    /**
+     * Only state changes are worth a notification, not every
+     * fast fail, nor every RTT sample. The timeout is sent again
+     * once it moved by a quarter.
+     */
+    if  (
+            esk8_bms_get_health(esk8_onboard.hndl_bms, req->pack, &health) == ESK8_OK &&
+            (
+                health.state != last->state ||
+                health.backoff_ms != last->backoff_ms ||
+                health.rto_us > last->rto_us + last->rto_us / 4 ||
+                health.rto_us < last->rto_us - last->rto_us / 4
+            )
+        )
+    {
+        (*last) = health;
+
+        err = esk8_ble_app_status_bms_health(
+            &health,
+            bms_err, req->pack
+        );
 
+        if (err)
+        {
             esk8_log_I(ESK8_TAG_ONB,
-                "Got: %s reading BMS status at index: %d.\n",
-                esk8_err_to_str(err), i
+                "Got: %s updating BMS health.\n",
+                esk8_err_to_str(err)
             );
+        }
+    }
 
-            err = esk8_ble_app_status_bms_shallow(
-                &esk8_onboard.bms_stat[i],
-                err, i
-            );
+    /* Nothing new was read */
+    if (bms_err == ESK8_BMS_ERR_PACK_DOWN || bms_err == ESK8_BMS_ERR_STOPPED)
+        return;
+
+    if (req->fields & ESK8_BMS_FIELDS_STATUS)
+    {
+        err = esk8_ble_app_status_bms_shallow(
+            req->status,
+            bms_err, req->pack
+        );
 
+        if (err)
+        {
             esk8_log_I(ESK8_TAG_ONB,
                 "Got: %s updating shallow BMS.\n",
                 esk8_err_to_str(err)
             );
+        }
+    }
 
-            err = esk8_bms_get_deep_status(
-                esk8_onboard.hndl_bms,
-                &esk8_onboard.bms_deep_stat[i]
-            );
+    if (req->fields & ESK8_BMS_FIELDS_DEEP)
+    {
+        err = esk8_ble_app_status_bms_deep(
+            req->deep_status,
+            bms_err, req->pack
+        );
 
+        if (err)
+        {
             esk8_log_I(ESK8_TAG_ONB,
-                "Got: %s reading BMS deep status at index: %d.\n",
-                esk8_err_to_str(err), i
+                "Got: %s updating deep BMS.\n",
+                esk8_err_to_str(err)
             );
+        }
+    }
+}
 
-            err = esk8_ble_app_status_bms_deep(
-                &esk8_onboard.bms_deep_stat[i],
-                err, i
-            );
+/**
+ * Logs the share of the bus each BMS pack and
+ * the ESC took since the last call, so whoever
+ * eats bus time shows up on the console.
+ */
+static void
+esk8_onboard_bus_log(
+)
+{
+    int64_t now_us  = esp_timer_get_time();
+    int64_t span_us = now_us - esk8_onboard.bus_stats_us;
 
-            esk8_log_I(ESK8_TAG_ONB,
-                "Got: %s updating deep BMS.\n",
+    if (span_us <= 0)
+        return;
+
+    for (int i = 0; i <= ESK8_UART_BMS_CONF_NUM; i++)
+    {
+        esk8_uart_bus_stats_t stats;
+        esk8_uart_bus_stats_t* last = &esk8_onboard.bus_stats[i];
+
+        esk8_err_t err = i < ESK8_UART_BMS_CONF_NUM ?
+            esk8_bms_get_bus_stats(esk8_onboard.hndl_bms, i, &stats) :
+            esk8_esc_get_bus_stats(esk8_onboard.hndl_esc, &stats);
+
+        if (err)
+            continue;
+
+        uint32_t n_trx   = stats.n_trx - last->n_trx;
+        uint32_t busy    = (stats.busy_us - last->busy_us) * 1000 / span_us;
+        uint32_t listen  = (stats.listen_us - last->listen_us) * 1000 / span_us;
+        uint32_t wait_us = n_trx ? (stats.wait_us - last->wait_us) / n_trx : 0;
+
+        esk8_log_I(ESK8_TAG_ONB,
+            "Bus use of %s: %u.%u%% busy, %u.%u%% listen, %u trx, "
+            "wait avg %u us, max %u us, %u missed.\n",
+            stats.name,
+            busy / 10, busy % 10,
+            listen / 10, listen % 10,
+            n_trx, wait_us,
+            stats.wait_max_us,
+            stats.n_missed - last->n_missed
+        );
+
+        (*last) = stats;
+    }
+
+    esk8_onboard.bus_stats_us = now_us;
+}
+
+void
+esk8_onboard_task_bms(
+    void* param
+)
+{
+    esk8_onboard_cnfg_t* cnfg = (esk8_onboard_cnfg_t*)param;
+    esk8_onboard_sched_t* sched = &esk8_onboard.bms_sched;
+    uint32_t stats_ms = NOW_MS();
+
+    esk8_onboard.bus_stats_us = esp_timer_get_time();
+
+    while (esk8_onboard.state && !esk8_onboard.bms_stop)
+    {
+        uint32_t now_ms = NOW_MS();
+        esk8_onboard_sched_refill(sched, now_ms);
+
+        if (now_ms - stats_ms >= ESK8_OBRD_BUS_STATS_MS)
+        {
+            esk8_onboard_bus_log();
+            stats_ms = now_ms;
+        }
+
+        esk8_err_t err = esk8_onboard_sched_save(sched);
+
+        if (err)
+        {
+            esk8_log_W(ESK8_TAG_ONB,
+                "Got: %s saving BMS identities.\n",
                 esk8_err_to_str(err)
             );
+        }
+
+        /* Start at a different pack every tick, so none is starved */
+        for (int n=0; n<ESK8_UART_BMS_CONF_NUM; n++)
+        {
+            int i = (sched->next_pack + n) % ESK8_UART_BMS_CONF_NUM;
+
+            esk8_bms_field_mask_t fields = esk8_onboard_sched_take(
+                sched, i, now_ms
+            );
+
+            if (!fields)
+                continue;
+
+            esk8_bms_req_t req = {
+                .pack        = i,
+                .fields      = fields,
+                .status      = &esk8_onboard.bms_stat[i],
+                .deep_status = &esk8_onboard.bms_deep_stat[i],
+                .cb          = esk8_onboard_bms_done,
+            };
+
+            err = esk8_bms_submit(
+                esk8_onboard.hndl_bms, &req
+            );
+
+            if (err)
+            {
+                esk8_log_W(ESK8_TAG_ONB,
+                    "Got: %s queueing BMS status at index: %d.\n",
+                    esk8_err_to_str(err), i
+                );
 
-            /* We might wait quite a long time here */
-            vTaskDelay(cnfg->bms_update_ms / portTICK_PERIOD_MS);
+                /* Not the pack's fault, nothing about it changed */
+                esk8_onboard_sched_cancel(sched, i, fields, now_ms);
+            }
         }
+
+        sched->next_pack = (sched->next_pack + 1) % ESK8_UART_BMS_CONF_NUM;
+        vTaskDelay(ESK8_OBRD_BMS_TICK_MS / portTICK_PERIOD_MS);
     }
+
+    xSemaphoreGive(esk8_onboard.bms_stopped);
+    vTaskDelete(NULL);
 }
@@ -0,0 +1,38 @@
+#include <esk8_esc.h>
+#include <esk8_log.h>
+
+#include <ble_apps/esk8_ble_app_status.h>
+#include <esk8_onboard.h>
+#include <esk8_onboard_priv.h>
+
+
+void
+esk8_onboard_esc_telemetry(
+    const esk8_esc_telemetry_t* telemetry,
+    esk8_err_t esc_err,
+    void* ctx
+)
+{
+    /* Polled 20 times a second, only log when things change */
+    if (esc_err != esk8_onboard.esc_err)
+    {
+        esk8_log_I(ESK8_TAG_ONB,
+            "Got: %s polling ESC telemetry.\n",
+            esk8_err_to_str(esc_err)
+        );
+
+        esk8_onboard.esc_err = esc_err;
+    }
+
+    esk8_err_t err = esk8_ble_app_status_esc(
+        telemetry, esc_err
+    );
+
+    if (err)
+    {
+        esk8_log_D(ESK8_TAG_ONB,
+            "Got: %s updating ESC telemetry.\n",
+            esk8_err_to_str(err)
+        );
+    }
+}
@@ -1,10 +1,54 @@
 #ifndef _ESK8_ONBOARD_PRIV_H
 #define _ESK8_ONBOARD_PRIV_H
 
+#include <esk8_config.h>
 #include <esk8_err.h>
 #include <esk8_bms.h>
+#include <esk8_bms_fields.h>
+#include <esk8_uart_bus.h>
+#include <esk8_nvs.h>
 #include <esk8_onboard.h>
 
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/* One entry per `esk8_bms_refresh_t` bit */
+#define ESK8_OBRD_BMS_NUM_CLASSES 4
+
+typedef struct
+{
+    uint32_t            next_ms[ESK8_OBRD_BMS_NUM_CLASSES];
+    volatile uint32_t   spent_us;   /* Bus time reported by the BMS worker */
+    volatile uint8_t    busy;       /* A request is with the BMS worker */
+    uint8_t             has_ident;  /* ONCE fields are in the deep status */
+    uint8_t             new_ident;  /* The probe found another pack, read it all */
+}
+esk8_onboard_bms_pack_t;
+
+/**
+ * Decides which BMS fields to read, and when.
+ * Each refresh class has its own period per pack,
+ * and reads are held back when the bus time used
+ * goes over `ESK8_OBRD_BMS_BUS_BUDGET_PRC`.
+ */
+typedef struct
+{
+    esk8_onboard_bms_pack_t packs[ESK8_UART_BMS_CONF_NUM];
+    uint32_t                period_ms[ESK8_OBRD_BMS_NUM_CLASSES];
+
+    int32_t                 budget_us;
+    uint32_t                budget_ms;  /* When the budget was last refilled */
+    uint32_t                spent_seen_us;
+    uint8_t                 next_pack;
+
+    /* Pack identities, as stored in NVS. Written by the BMS workers, under the lock */
+    void*                   ident_lock;
+    esk8_nvs_val_t          ident;
+    uint32_t                ident_gen;      /* Bumped on every change */
+    uint32_t                ident_saved_gen;
+}
+esk8_onboard_sched_t;
 
 typedef struct
 {
@@ -15,18 +59,35 @@ typedef struct
     uint8_t                 now_speed;
     esk8_bms_status_t*      bms_stat;
     esk8_bms_deep_status_t* bms_deep_stat;
+    esk8_onboard_sched_t    bms_sched;
+    esk8_bms_health_t       bms_health[ESK8_UART_BMS_CONF_NUM];  /* As last published */
+    esk8_err_t              esc_err;    /* Outcome of the last ESC poll */
+
+    /* Bus use of each pack, then of the ESC, as last logged */
+    esk8_uart_bus_stats_t   bus_stats[ESK8_UART_BMS_CONF_NUM + 1];
+    int64_t                 bus_stats_us;
 
     void* hndl_bms;
+    void* hndl_esc;
     void* hndl_pwm;
     void* hndl_btn;
     void* task_bms;
     void* task_btn;
+
+    volatile bool bms_stop;     /* Set by `esk8_onboard_stop()` */
+    void*         bms_stopped;  /* Given by `task_bms` once it is done */
 }
 esk8_onboard_t;
 
 extern esk8_onboard_t
 esk8_onboard;
 
+/**
+ * Hands due BMS reads to the BMS workers, every
+ * `ESK8_OBRD_BMS_TICK_MS`, until `bms_stop` is
+ * set. Then gives `bms_stopped`, and deletes
+ * itself.
+ */
 void
 esk8_onboard_task_bms(
     void* param
@@ -37,10 +98,105 @@ esk8_onboard_task_btn(
     void* param
 );
 
+/**
+ * Publishes each ESC telemetry poll.
+ * Called from the ESC worker.
+ */
+void
+esk8_onboard_esc_telemetry(
+    const esk8_esc_telemetry_t* telemetry,
+    esk8_err_t err,
+    void* ctx
+);
+
 esk8_err_t
 esk8_onboard_set_speed(
     uint8_t speed
 );
 
+/**
+ * Sets up `sched`, with everything due now.
+ * `medium_ms` is the refresh period of the
+ * medium class. Pack identities are loaded
+ * from NVS, if stored.
+ */
+esk8_err_t
+esk8_onboard_sched_init(
+    esk8_onboard_sched_t* sched,
+    uint32_t medium_ms,
+    uint32_t now_ms
+);
+
+/**
+ * Frees what `esk8_onboard_sched_init` took.
+ * No BMS read may still be on its way.
+ */
+void
+esk8_onboard_sched_deinit(
+    esk8_onboard_sched_t* sched
+);
+
+/**
+ * Adds the bus time earned since the last call,
+ * and takes off what the worker reported spent.
+ */
+void
+esk8_onboard_sched_refill(
+    esk8_onboard_sched_t* sched,
+    uint32_t now_ms
+);
+
+/**
+ * Returns the fields due for `pack`, and marks
+ * them as taken. Returns 0 if nothing is due,
+ * if the pack is busy, or if the budget is spent.
+ * With little budget left only the fast class
+ * is handed out.
+ */
+esk8_bms_field_mask_t
+esk8_onboard_sched_take(
+    esk8_onboard_sched_t* sched,
+    uint8_t pack,
+    uint32_t now_ms
+);
+
+/**
+ * Gives back `fields` taken for `pack` at
+ * `now_ms`, when the read never got to the
+ * BMS worker. They are due again at once,
+ * and the pack is left as it was.
+ */
+void
+esk8_onboard_sched_cancel(
+    esk8_onboard_sched_t* sched,
+    uint8_t pack,
+    esk8_bms_field_mask_t fields,
+    uint32_t now_ms
+);
+
+/**
+ * Reports a read of `fields` for `pack` done,
+ * into `deep`. Called from the BMS worker.
+ */
+void
+esk8_onboard_sched_done(
+    esk8_onboard_sched_t* sched,
+    uint8_t pack,
+    esk8_bms_field_mask_t fields,
+    esk8_bms_deep_status_t* deep,
+    esk8_err_t err,
+    uint32_t bus_us
+);
+
+/**
+ * Writes the pack identities to NVS, if any
+ * changed since they were last saved. A failed
+ * write is tried again on the next call.
+ */
+esk8_err_t
+esk8_onboard_sched_save(
+    esk8_onboard_sched_t* sched
+);
+
 
 #endif /* _ESK8_ONBOARD_PRIV_H */
@@ -0,0 +1,289 @@
+#include <esk8_config.h>
+#include <esk8_err.h>
+#include <esk8_bms_fields.h>
+#include <esk8_nvs.h>
+#include <esk8_log.h>
+
+#include <esk8_onboard_priv.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#include <string.h>
+#include <stddef.h>
+
+/* Bus time earned per ms of wall time */
+#define BUDGET_US_PER_MS    (1000 * ESK8_OBRD_BMS_BUS_BUDGET_PRC / 100)
+
+/* Never save up more than a second worth of bus time */
+#define BUDGET_MAX_US       (1000 * BUDGET_US_PER_MS)
+
+/* Below this, only the fast class gets the bus */
+#define BUDGET_LOW_US       (ESK8_OBRD_BMS_TICK_MS * BUDGET_US_PER_MS)
+
+#define IS_DUE(now, next)   ((int32_t)((now) - (next)) >= 0)
+
+#define ONCE_FIELDS         ESK8_BMS_FIELD_MASK(ESK8_BMS_DST_ALL, ESK8_BMS_REFRESH_ONCE)
+#define PROBE_FIELDS        ESK8_BMS_FIELD_BIT(SERIAL_NUMBER)
+
+/* The identity is the head of the deep status */
+_Static_assert(
+    offsetof(esk8_bms_deep_status_t, actualCapacity_mAh) == ESK8_NVS_BMS_IDENT_LEN,
+    "Pack identity does not match the deep status layout");
+_Static_assert(
+    (ONCE_FIELDS & PROBE_FIELDS) == PROBE_FIELDS,
+    "The identity probe must be part of the identity");
+
+
+/* Index of the ONCE class in the tables below */
+#define CLASS_ONCE          3
+
+static const esk8_bms_refresh_t
+sched_classes[ESK8_OBRD_BMS_NUM_CLASSES] = {
+    ESK8_BMS_REFRESH_FAST,
+    ESK8_BMS_REFRESH_MEDIUM,
+    ESK8_BMS_REFRESH_SLOW,
+    ESK8_BMS_REFRESH_ONCE,
+};
+
+static const esk8_bms_field_mask_t
+sched_fields[ESK8_OBRD_BMS_NUM_CLASSES] = {
+    ESK8_BMS_FIELD_MASK(ESK8_BMS_DST_ALL, ESK8_BMS_REFRESH_FAST),
+    ESK8_BMS_FIELD_MASK(ESK8_BMS_DST_ALL, ESK8_BMS_REFRESH_MEDIUM),
+    ESK8_BMS_FIELD_MASK(ESK8_BMS_DST_ALL, ESK8_BMS_REFRESH_SLOW),
+    ESK8_BMS_FIELD_MASK(ESK8_BMS_DST_ALL, ESK8_BMS_REFRESH_ONCE),
+};
+
+
+esk8_err_t
+esk8_onboard_sched_init(
+    esk8_onboard_sched_t* sched,
+    uint32_t medium_ms,
+    uint32_t now_ms
+)
+{
+    memset(sched, 0, sizeof(esk8_onboard_sched_t));
+
+    sched->ident_lock = xSemaphoreCreateMutex();
+    if (!sched->ident_lock)
+        return ESK8_ERR_OOM;
+
+    sched->period_ms[0] = ESK8_OBRD_BMS_FAST_MS;
+    sched->period_ms[1] = medium_ms;
+    sched->period_ms[2] = ESK8_OBRD_BMS_SLOW_MS;
+    sched->period_ms[CLASS_ONCE] = ESK8_OBRD_BMS_SLOW_MS; /* Retry period, until it is read */
+
+    for (int p = 0; p < ESK8_UART_BMS_CONF_NUM; p++)
+    {
+        for (int c = 0; c < ESK8_OBRD_BMS_NUM_CLASSES; c++)
+            sched->packs[p].next_ms[c] = now_ms;
+    }
+
+    sched->budget_us = BUDGET_MAX_US;
+    sched->budget_ms = now_ms;
+
+    esk8_nvs_settings_get(ESK8_NVS_BMS_IDENT, &sched->ident);
+    return ESK8_OK;
+}
+
+void
+esk8_onboard_sched_deinit(
+    esk8_onboard_sched_t* sched
+)
+{
+    if (sched->ident_lock)
+        vSemaphoreDelete(sched->ident_lock);
+
+    sched->ident_lock = NULL;
+}
+
+/**
+ * Whether an identity was ever stored for `pack`.
+ * A serial number is never all zeros.
+ */
+static int
+ident_known(
+    esk8_onboard_sched_t* sched,
+    uint8_t pack
+)
+{
+    for (int i = 0; i < sizeof(((esk8_bms_deep_status_t*)0)->serialNumber); i++)
+    {
+        if (sched->ident.bms_ident[pack][i])
+            return 1;
+    }
+
+    return 0;
+}
+
+void
+esk8_onboard_sched_refill(
+    esk8_onboard_sched_t* sched,
+    uint32_t now_ms
+)
+{
+    uint32_t spent_us = 0;
+    int64_t budget_us = sched->budget_us;
+
+    /* Each pack is only written by the worker of its own UART */
+    for (int p = 0; p < ESK8_UART_BMS_CONF_NUM; p++)
+        spent_us += sched->packs[p].spent_us;
+
+    budget_us += (int64_t)(now_ms - sched->budget_ms) * BUDGET_US_PER_MS;
+    budget_us -= spent_us - sched->spent_seen_us;
+
+    if (budget_us > BUDGET_MAX_US)
+        budget_us = BUDGET_MAX_US;
+
+    /* A slow pack may put us in debt, but not forever */
+    if (budget_us < -BUDGET_MAX_US)
+        budget_us = -BUDGET_MAX_US;
+
+    sched->budget_us = budget_us;
+    sched->budget_ms = now_ms;
+    sched->spent_seen_us = spent_us;
+}
+
+esk8_bms_field_mask_t
+esk8_onboard_sched_take(
+    esk8_onboard_sched_t* sched,
+    uint8_t pack,
+    uint32_t now_ms
+)
+{
+    esk8_onboard_bms_pack_t* bms_pack = &sched->packs[pack];
+    esk8_bms_field_mask_t fields = 0;
+
+    if (bms_pack->busy || sched->budget_us <= 0)
+        return 0;
+
+    for (int c = 0; c < ESK8_OBRD_BMS_NUM_CLASSES; c++)
+    {
+        if (c > 0 && sched->budget_us < BUDGET_LOW_US)
+            break;
+
+        if (sched_classes[c] == ESK8_BMS_REFRESH_ONCE && bms_pack->has_ident)
+            continue;
+
+        if (!IS_DUE(now_ms, bms_pack->next_ms[c]))
+            continue;
+
+        /* The serial number alone tells if the stored identity still holds */
+        if  (
+                sched_classes[c] == ESK8_BMS_REFRESH_ONCE &&
+                !bms_pack->new_ident &&
+                ident_known(sched, pack)
+            )
+            fields |= PROBE_FIELDS;
+        else
+            fields |= sched_fields[c];
+
+        bms_pack->next_ms[c] = now_ms + sched->period_ms[c];
+    }
+
+    if (fields)
+        bms_pack->busy = 1;
+
+    return fields;
+}
+
+void
+esk8_onboard_sched_cancel(
+    esk8_onboard_sched_t* sched,
+    uint8_t pack,
+    esk8_bms_field_mask_t fields,
+    uint32_t now_ms
+)
+{
+    esk8_onboard_bms_pack_t* bms_pack = &sched->packs[pack];
+
+    /* The classes are disjoint, and the probe is part of the ONCE one */
+    for (int c = 0; c < ESK8_OBRD_BMS_NUM_CLASSES; c++)
+    {
+        if (fields & sched_fields[c])
+            bms_pack->next_ms[c] = now_ms;
+    }
+
+    bms_pack->busy = 0;
+}
+
+void
+esk8_onboard_sched_done(
+    esk8_onboard_sched_t* sched,
+    uint8_t pack,
+    esk8_bms_field_mask_t fields,
+    esk8_bms_deep_status_t* deep,
+    esk8_err_t err,
+    uint32_t bus_us
+)
+{
+    esk8_onboard_bms_pack_t* bms_pack = &sched->packs[pack];
+    uint8_t* ident = sched->ident.bms_ident[pack];
+
+    if (err)
+    {
+        /* The pack may come back as another one, probe it on the first read that works */
+        bms_pack->has_ident = 0;
+        bms_pack->next_ms[CLASS_ONCE] = sched->budget_ms;
+    }
+    else if ((fields & ONCE_FIELDS) == ONCE_FIELDS)
+    {
+        /* Only this worker writes the row, but the onboard task may be saving it */
+        if (memcmp(ident, deep, ESK8_NVS_BMS_IDENT_LEN))
+        {
+            xSemaphoreTake(sched->ident_lock, portMAX_DELAY);
+            memcpy(ident, deep, ESK8_NVS_BMS_IDENT_LEN);
+            sched->ident_gen++;
+            xSemaphoreGive(sched->ident_lock);
+        }
+
+        bms_pack->has_ident = 1;
+        bms_pack->new_ident = 0;
+    }
+    else if (fields & PROBE_FIELDS)
+    {
+        if (memcmp(ident, deep->serialNumber, sizeof(deep->serialNumber)))
+        {
+            esk8_log_I(ESK8_TAG_ONB,
+                "BMS at index: %d was swapped.\n", pack
+            );
+
+            bms_pack->new_ident = 1;
+            bms_pack->next_ms[CLASS_ONCE] = sched->budget_ms;
+        }
+        else
+        {
+            memcpy(deep, ident, ESK8_NVS_BMS_IDENT_LEN);
+            bms_pack->has_ident = 1;
+        }
+    }
+
+    bms_pack->spent_us += bus_us;
+    bms_pack->busy = 0;
+}
+
+esk8_err_t
+esk8_onboard_sched_save(
+    esk8_onboard_sched_t* sched
+)
+{
+    esk8_nvs_val_t ident;
+
+    xSemaphoreTake(sched->ident_lock, portMAX_DELAY);
+
+    uint32_t gen = sched->ident_gen;
+    if (gen != sched->ident_saved_gen)
+        ident = sched->ident;
+
+    xSemaphoreGive(sched->ident_lock);
+
+    if (gen == sched->ident_saved_gen)
+        return ESK8_OK;
+
+    ESK8_ERRCHECK_THROW(esk8_nvs_settings_set(ESK8_NVS_BMS_IDENT, &ident));
+    ESK8_ERRCHECK_THROW(esk8_nvs_commit(ESK8_NVS_BMS_IDENT));
+
+    /* Changes made meanwhile are saved on the next call */
+    sched->ident_saved_gen = gen;
+    return ESK8_OK;
+}
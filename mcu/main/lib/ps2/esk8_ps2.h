@@ -3,6 +3,7 @@
 
 #include <esk8_err.h>
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 
@@ -29,16 +30,48 @@ typedef enum
     ESK8_PS2_RES_ACK                      = 0xFA,
     ESK8_PS2_RES_ERROR                    = 0xFC,
     ESK8_PS2_RES_RESEND                   = 0xFE,
+    ESK8_PS2_RES_BAT_OK                   = 0xAA,   /* Power on self test passed, followed by the device id */
 }
 esk8_ps2_cmd_t;
 
+/**
+ * Packet formats a device can be talked into.
+ **/
+typedef enum
+{
+    ESK8_PS2_PROTO_NONE = 0,              /* Not negotiated yet                     */
+    ESK8_PS2_PROTO_STD,                   /* 3 byte relative packets                */
+    ESK8_PS2_PROTO_IMPS,                  /* IntelliMouse, 4 bytes with a wheel     */
+    ESK8_PS2_PROTO_SYNAPTICS,             /* Synaptics absolute, 6 bytes            */
+    ESK8_PS2_PROTO_MAX,
+}
+esk8_ps2_proto_t;
+
+/**
+ * `x` and `y` are always relative counts, so
+ * consumers don't care about the protocol.
+ * In absolute mode they are worked out from
+ * the finger position, which is in `abs_x`
+ * and `abs_y`, while `z` is the finger pressure.
+ * Otherwise `z` is the wheel, if any.
+ * `t_us` is the `esp_timer_get_time` at which
+ * the ISR got the last byte of the packet.
+ **/
 typedef struct
 {
     esk8_err_t err;
  
     int x;
     int y;
+    int z;
     int lft_btn;
+    int rgt_btn;
+    int mdl_btn;
+
+    int abs_x;
+    int abs_y;
+    esk8_ps2_proto_t proto;
+    int64_t t_us;
 }
 esk8_ps2_mvmt_t;
 
@@ -51,6 +84,34 @@ typedef struct
 }
 esk8_ps2_cnfg_t;
 
+/**
+ * Movement stream counters, since init.
+ **/
+typedef struct
+{
+    uint32_t n_resync;      /* Times the stream was realigned in place          */
+    uint32_t n_fallback;    /* Realigns that gave up, and restarted the stream  */
+    uint32_t n_dropped;     /* Packets lost because the task fell behind        */
+    uint32_t n_plugs;       /* Devices that showed up, or announced a reset     */
+}
+esk8_ps2_stats_t;
+
+/**
+ * One command of a script: `cmd`, its argument
+ * if `has_arg`, as for SET_SMPL_RATE and
+ * SET_RESOLUTION, and room for the `rsp_len`
+ * bytes it answers with after the ACK.
+ **/
+typedef struct
+{
+    esk8_ps2_cmd_t cmd;
+    bool           has_arg;
+    uint8_t        arg;
+    uint8_t*       rsp;
+    size_t         rsp_len;
+}
+esk8_ps2_step_t;
+
 typedef void*
 esk8_ps2_hndl_t;
 
@@ -82,6 +143,56 @@ esk8_ps2_send_cmd(
     esk8_ps2_cmd_t  cmd
 );
 
+/**
+ * Sends `cmd` followed by its argument byte,
+ * as for SET_SMPL_RATE and SET_RESOLUTION.
+ * Both have to be acknowledged.
+ **/
+esk8_err_t
+esk8_ps2_send_cmd_arg(
+    esk8_ps2_hndl_t hndl,
+    esk8_ps2_cmd_t  cmd,
+    uint8_t         arg
+);
+
+/**
+ * Sends `cmd`, and reads the `rsp_len` bytes
+ * the device answers with after the ACK, as
+ * for GET_DEV_ID and GET_STATUS.
+ **/
+esk8_err_t
+esk8_ps2_send_cmd_rsp(
+    esk8_ps2_hndl_t hndl,
+    esk8_ps2_cmd_t  cmd,
+    uint8_t*        rsp,
+    size_t          rsp_len
+);
+
+/**
+ * Sends `n_steps` commands back to back, as a
+ * single transaction nothing else can send in
+ * the middle of. Stops at the first one that
+ * fails.
+ **/
+esk8_err_t
+esk8_ps2_send_script(
+    esk8_ps2_hndl_t        hndl,
+    const esk8_ps2_step_t* steps,
+    size_t                 n_steps
+);
+
+/**
+ * Puts the device in the best mode it supports:
+ * Synaptics absolute, else IntelliMouse, else the
+ * standard protocol, at the highest sample rate.
+ * Data reporting must be disabled.
+ * Falls back to the standard protocol on errors.
+ **/
+esk8_err_t
+esk8_ps2_negotiate(
+    esk8_ps2_hndl_t hndl
+);
+
 esk8_err_t
 esk8_ps2_await_rsp(
     esk8_ps2_hndl_t hndl,
@@ -99,5 +210,48 @@ esk8_ps2_mvmt_sync(
     esk8_ps2_hndl_t hndl
 );
 
+/**
+ * Like `esk8_ps2_mvmt_sync`, but leaves the
+ * device in remote mode, where it only sends
+ * a packet when asked with `esk8_ps2_poll_mvmt`.
+ **/
+esk8_err_t
+esk8_ps2_mvmt_sync_remote(
+    esk8_ps2_hndl_t hndl
+);
+
+/**
+ * Asks a device in remote mode for its
+ * movement since the last poll, and waits
+ * for it.
+ **/
+esk8_err_t
+esk8_ps2_poll_mvmt(
+    esk8_ps2_hndl_t  hndl,
+    esk8_ps2_mvmt_t* out_mvmt
+);
+
+/**
+ * Waits for a device to show up, without
+ * sending it anything: either its power on
+ * announcement, or any clock activity while
+ * nothing was talking to the host. Call it
+ * when a device stopped answering, and set it
+ * up again once it returns. `timeout_ms` 0
+ * waits forever.
+ * Returns `ESK8_PS2_ERR_TIMEOUT` if none did.
+ **/
+esk8_err_t
+esk8_ps2_await_plug(
+    esk8_ps2_hndl_t hndl,
+    uint32_t        timeout_ms
+);
+
+void
+esk8_ps2_get_stats(
+    esk8_ps2_hndl_t   hndl,
+    esk8_ps2_stats_t* out_stats
+);
+
 
 #endif /* _ESK8_PS2_H */
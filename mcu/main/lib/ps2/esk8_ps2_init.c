@@ -6,10 +6,196 @@
 
 #include <driver/gpio.h>
 #include <esp_log.h>
+#include <esp_timer.h>
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/queue.h>
 #include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#include <stdbool.h>
+
+
+/**
+ * Hands a packet to the task through the ring.
+ * Returns true if the task was woken.
+ **/
+static bool IRAM_ATTR
+esk8_ps2_isr_push(
+    esk8_ps2_hndl_def_t*   ps2_hndl,
+    esk8_ps2_sqnc_frame_t* sqnc
+)
+{
+    esk8_ps2_ring_t* ring = &ps2_hndl->mv_ring;
+
+    uint32_t head = ring->head;
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+
+    /* Every frame that ends in the ring went through `esk8_ps2_isr_plug` first */
+    sqnc->t_us = ps2_hndl->last_frame_us;
+
+    if (head - tail < ESK8_PS2_MVMT_RING_LEN)
+    {
+        ring->pkts[head & (ESK8_PS2_MVMT_RING_LEN - 1)] = *sqnc;
+        __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+    }
+    else
+    {
+        ps2_hndl->stats.n_dropped++;
+    }
+
+    BaseType_t woken = pdFALSE;
+    if (ps2_hndl->mv_task)
+        vTaskNotifyGiveFromISR(ps2_hndl->mv_task, &woken);
+
+    return woken == pdTRUE;
+}
+
+/**
+ * Adds a byte of a movement packet, and pushes
+ * the packet once it is complete.
+ * Every protocol marks its packets with a few
+ * fixed bits, bit 3 of the first byte for the
+ * relative ones. On a byte that doesn't match, the
+ * bytes held are checked again from the next one on,
+ * so a header already in them is kept. Packets broken
+ * by a bad frame are dropped whole. Either way the
+ * stream never has to be stopped. Only after `ESK8_PS2_RESYNC_MAX_BYTES`
+ * bytes without a good packet does the task get
+ * an `ESK8_PS2_ERR_BAD_MVMT`, to restart it.
+ * Returns true if the task was woken.
+ **/
+static bool IRAM_ATTR
+esk8_ps2_isr_mvmt(
+    esk8_ps2_hndl_def_t* ps2_hndl,
+    esk8_ps2_frame_t*    frame
+)
+{
+    esk8_ps2_sqnc_frame_t* sqnc = &ps2_hndl->sqnc_frame;
+
+    esk8_ps2_pkt_def_t* def = &ps2_hndl->pkt_def;
+
+    bool bad =  frame->err ||
+                (frame->byte & def->hdr_mask[sqnc->idx]) != def->hdr_val[sqnc->idx];
+
+    if (!bad)
+    {
+        sqnc->mvmt[sqnc->idx++] = frame->byte;
+
+        if (sqnc->idx < def->len)
+            return false;
+
+        sqnc->err = ESK8_OK;
+        sqnc->idx = 0;
+        ps2_hndl->resync_bytes = 0;
+
+        return esk8_ps2_isr_push(ps2_hndl, sqnc);
+    }
+
+    /**
+     * Slide over as few bytes as it takes for the rest,
+     * this one included, to line up as the start of a
+     * packet. A broken frame takes everything with it.
+     **/
+    uint8_t drop = sqnc->idx + 1;
+
+    for (uint8_t s = 1; !frame->err && s <= sqnc->idx; s++)
+    {
+        uint8_t keep = sqnc->idx - s;
+        bool fits = (frame->byte & def->hdr_mask[keep]) == def->hdr_val[keep];
+
+        for (uint8_t i = 0; fits && i < keep; i++)
+            fits = (sqnc->mvmt[s + i] & def->hdr_mask[i]) == def->hdr_val[i];
+
+        if (fits)
+        {
+            drop = s;
+            break;
+        }
+    }
+
+    if (!ps2_hndl->resync_bytes)
+        ps2_hndl->stats.n_resync++;
+
+    ps2_hndl->resync_bytes += drop;
+
+    uint8_t keep = sqnc->idx + 1 - drop;
+
+    for (uint8_t i = 0; i + 1 < keep; i++)
+        sqnc->mvmt[i] = sqnc->mvmt[drop + i];
+
+    if (keep)
+        sqnc->mvmt[keep - 1] = frame->byte;
+
+    sqnc->idx = keep;
+
+    if (ps2_hndl->resync_bytes <= ESK8_PS2_RESYNC_MAX_BYTES)
+        return false;
+
+    ps2_hndl->stats.n_fallback++;
+    ps2_hndl->resync_bytes = 0;
+
+    sqnc->err = ESK8_PS2_ERR_BAD_MVMT;
+    return esk8_ps2_isr_push(ps2_hndl, sqnc);
+}
+
+/**
+ * Whether `frame` shows a device that just
+ * showed up. With nothing talking to the host,
+ * any byte does. Otherwise it takes the 0xAA
+ * 0x00 a device sends once powered up, after
+ * a quiet spell, as after a replug or a brown
+ * out.
+ **/
+static bool IRAM_ATTR
+esk8_ps2_isr_plug(
+    esk8_ps2_hndl_def_t* ps2_hndl,
+    esk8_ps2_frame_t*    frame
+)
+{
+    int64_t now_us = esp_timer_get_time();
+    int64_t quiet_us = now_us - ps2_hndl->last_frame_us;
+
+    ps2_hndl->last_frame_us = now_us;
+
+    if (ps2_hndl->ps2_state == ESK8_PS2_STATE_NONE)
+        return true;
+
+    bool bat = ps2_hndl->bat_seen && !frame->err && frame->byte == 0x00;
+
+    ps2_hndl->bat_seen =    !frame->err &&
+                            frame->byte == ESK8_PS2_RES_BAT_OK &&
+                            quiet_us >= ESK8_PS2_BAT_QUIET_US;
+
+    return bat;
+}
+
+/**
+ * Tells whoever waits for a device, and a
+ * movement waiter that its stream is gone.
+ * Returns true if a task was woken.
+ **/
+static bool IRAM_ATTR
+esk8_ps2_isr_plugged(
+    esk8_ps2_hndl_def_t* ps2_hndl
+)
+{
+    BaseType_t woken = pdFALSE;
+
+    ps2_hndl->stats.n_plugs++;
+    xSemaphoreGiveFromISR(ps2_hndl->plug_sem, &woken);
+
+    if (ps2_hndl->ps2_state != ESK8_PS2_STATE_MVMT)
+        return woken == pdTRUE;
+
+    esk8_ps2_sqnc_frame_t* sqnc = &ps2_hndl->sqnc_frame;
+
+    sqnc->err = ESK8_PS2_ERR_DEV_RESET;
+    sqnc->idx = 0;
+    ps2_hndl->resync_bytes = 0;
+
+    return esk8_ps2_isr_push(ps2_hndl, sqnc) || woken == pdTRUE;
+}
 
 
 void IRAM_ATTR
@@ -23,8 +209,14 @@ esk8_ps2_isr(
 
     int* idx = &frame->idx;
 
+    ps2_hndl->n_edges++;
+
+    if (ps2_hndl->ps2_state != ESK8_PS2_STATE_SEND)
+        ps2_hndl->n_rx_edges++;
+
     switch(ps2_hndl->ps2_state)
     {
+    case ESK8_PS2_STATE_NONE:
     case ESK8_PS2_STATE_RECV:
     case ESK8_PS2_STATE_MVMT:
     {
@@ -89,14 +281,27 @@ esk8_ps2_isr(
         )
         return;
 
+    bool plugged =  ps2_hndl->ps2_state != ESK8_PS2_STATE_SEND &&
+                    esk8_ps2_isr_plug(ps2_hndl, frame);
+
+    bool woken = plugged && esk8_ps2_isr_plugged(ps2_hndl);
+
     switch (ps2_hndl->ps2_state)
     {
     case ESK8_PS2_STATE_RECV:
         xQueueSendFromISR(ps2_hndl->rx_queue, frame, NULL);
+        if (ps2_hndl->rx_expect > 1)
+        {
+            ps2_hndl->rx_expect--;
+            break;
+        }
+        ps2_hndl->rx_expect = 0;
         ps2_hndl->ps2_state = ESK8_PS2_STATE_MVMT;
         break;
     case ESK8_PS2_STATE_MVMT:
-        xQueueSendFromISR(ps2_hndl->mv_queue, frame, NULL);
+        /* A replugged device's 0x00 is not movement */
+        if (!plugged)
+            woken |= esk8_ps2_isr_mvmt(ps2_hndl, frame);
         break;
     case ESK8_PS2_STATE_SEND:
         gpio_set_direction(ps2_cnfg->data_pin, GPIO_MODE_INPUT);
@@ -110,6 +315,9 @@ esk8_ps2_isr(
     }
 
     esk8_ps2_reset_frame(frame);
+
+    if (woken)
+        portYIELD_FROM_ISR();
 }
 
 
@@ -138,17 +346,13 @@ esk8_ps2_init(
         sizeof(esk8_ps2_frame_t)
     );
 
-    ps2_hndl_def->mv_queue = xQueueCreate(
-        ps2_config->rx_queue_len,
-        sizeof(esk8_ps2_frame_t)
-    );
-
     ps2_hndl_def->tx_lock = xSemaphoreCreateBinary();
+    ps2_hndl_def->plug_sem = xSemaphoreCreateBinary();
 
     if  (
             !ps2_hndl_def->rx_queue ||
-            !ps2_hndl_def->mv_queue ||
-            !ps2_hndl_def->tx_lock
+            !ps2_hndl_def->tx_lock ||
+            !ps2_hndl_def->plug_sem
         )
     {
         esk8_ps2_deinit(*ps2_hndl);
@@ -156,6 +360,7 @@ esk8_ps2_init(
     }
 
     ps2_hndl_def->ps2_cnfg = *ps2_config;
+    esk8_ps2_set_proto(ps2_hndl_def, ESK8_PS2_PROTO_STD);
 
     gpio_num_t c_pin = ps2_config->clock_pin;
     gpio_num_t d_pin = ps2_config->data_pin;
@@ -187,12 +392,12 @@ esk8_ps2_deinit(
     if (ps2_hndl_def->rx_queue)
         vQueueDelete(ps2_hndl_def->rx_queue);
 
-    if (ps2_hndl_def->mv_queue)
-        vQueueDelete(ps2_hndl_def->mv_queue);
-
     if (ps2_hndl_def->tx_lock)
         vSemaphoreDelete(ps2_hndl_def->tx_lock);
 
+    if (ps2_hndl_def->plug_sem)
+        vSemaphoreDelete(ps2_hndl_def->plug_sem);
+
     free(ps2_hndl);
 
     return ESK8_OK;
@@ -7,6 +7,41 @@
 #include <stdint.h>
 
 
+/* Movement packets the ISR can get ahead of the task, a power of two */
+#define ESK8_PS2_MVMT_RING_LEN 8
+
+/* Longest movement packet, Synaptics absolute */
+#define ESK8_PS2_PKT_MAX 6
+
+/* Bytes slid over in stream before the task is told to restart it */
+#define ESK8_PS2_RESYNC_MAX_BYTES (3 * ESK8_PS2_PKT_MAX)
+
+/**
+ * A device takes a few hundred ms to power up,
+ * so its 0xAA 0x00 follows at least this much
+ * silence. Without it, 0xAA is a valid header.
+ **/
+#define ESK8_PS2_BAT_QUIET_US (100 * 1000)
+
+/* The host holds the clock low at least 100 us before it sends */
+#define ESK8_PS2_INHIBIT_US 110
+
+/**
+ * A device acknowledges a byte within 20 ms,
+ * the longer `rx_timeout_ms` is only for the
+ * answer bytes, a reset takes a while.
+ **/
+#define ESK8_PS2_ACK_TIMEOUT_MS 30
+
+/* Times a byte the device asked for again is sent */
+#define ESK8_PS2_RESEND_MAX 2
+
+
+/**
+ * In `ESK8_PS2_STATE_NONE` the host is not
+ * talking to a device, and anything clocked
+ * in means one just showed up.
+ **/
 typedef enum
 {
     ESK8_PS2_STATE_NONE = 0,
@@ -30,19 +65,77 @@ typedef struct
     esk8_err_t err;
 
     uint8_t idx;
-    uint8_t mvmt[3];
+    uint8_t mvmt[ESK8_PS2_PKT_MAX];
+    int64_t t_us;       /* When the ISR got its last byte */
 }
 esk8_ps2_sqnc_frame_t;
 
+/**
+ * Movement packet layout of a protocol.
+ * Byte `i` of a packet is only valid if
+ * `(byte & hdr_mask[i]) == hdr_val[i]`.
+ **/
+typedef struct
+{
+    uint8_t len;
+    uint8_t hdr_mask[ESK8_PS2_PKT_MAX];
+    uint8_t hdr_val[ESK8_PS2_PKT_MAX];
+}
+esk8_ps2_pkt_def_t;
+
+extern const esk8_ps2_pkt_def_t esk8_ps2_pkt_defs[ESK8_PS2_PROTO_MAX];
+
+/**
+ * Last finger position in absolute mode, to
+ * turn positions into relative counts.
+ **/
+typedef struct
+{
+    int touch;
+    int x;
+    int y;
+    int rem_x;
+    int rem_y;
+}
+esk8_ps2_abs_t;
+
+/**
+ * Single producer, single consumer ring of
+ * movement packets. Only the ISR moves `head`,
+ * only the task moves `tail`, so neither needs
+ * a lock. They count up forever, and are masked
+ * with the ring length on access.
+ **/
+typedef struct
+{
+    uint32_t              head;
+    uint32_t              tail;
+
+    esk8_ps2_sqnc_frame_t pkts[ESK8_PS2_MVMT_RING_LEN];
+}
+esk8_ps2_ring_t;
+
 typedef struct
 {
     esk8_ps2_frame_t      inflight;
-    esk8_ps2_sqnc_frame_t sqnc_frame;
+    esk8_ps2_sqnc_frame_t sqnc_frame;    /* Packet the ISR is assembling */
     esk8_ps2_state_t      ps2_state;
     esk8_ps2_cnfg_t       ps2_cnfg;
+    esk8_ps2_ring_t       mv_ring;
+    void*                 mv_task;       /* Woken once per packet */
+    uint32_t              resync_bytes;  /* Slid over since the last good packet */
+    esk8_ps2_stats_t      stats;
+    esk8_ps2_proto_t      proto;
+    esk8_ps2_pkt_def_t    pkt_def;       /* Copy of the table entry, the ISR can't read flash */
+    esk8_ps2_abs_t        abs;
+    uint8_t               rx_expect;     /* Response bytes left before movement starts */
+    uint8_t               bat_seen;      /* Last byte was a 0xAA after a quiet spell */
+    int64_t               last_frame_us;
+    uint32_t              n_edges;       /* Clock edges, to tell a garbled answer from none */
+    uint32_t              n_rx_edges;    /* Those of them not clocking out our own bytes */
     void*                 rx_queue;
-    void*                 mv_queue;
     void*                 tx_lock;
+    void*                 plug_sem;      /* Given by the ISR when a device shows up */
 }
 esk8_ps2_hndl_def_t;
 
@@ -69,5 +162,44 @@ esk8_ps2_get_parity(
     uint8_t byte
 );
 
+/**
+ * `tx_lock` is held for a whole transaction,
+ * the functions below expect it taken.
+ **/
+esk8_err_t
+esk8_ps2_tx_lock(
+    esk8_ps2_hndl_def_t* ps2_hndl
+);
+
+void
+esk8_ps2_tx_unlock(
+    esk8_ps2_hndl_def_t* ps2_hndl
+);
+
+esk8_err_t
+esk8_ps2_run_script(
+    esk8_ps2_hndl_def_t*   ps2_hndl,
+    const esk8_ps2_step_t* steps,
+    size_t                 n_steps
+);
+
+esk8_err_t
+esk8_ps2_negotiate_locked(
+    esk8_ps2_hndl_def_t* ps2_hndl
+);
+
+void
+esk8_ps2_set_proto(
+    esk8_ps2_hndl_def_t* ps2_hndl,
+    esk8_ps2_proto_t     proto
+);
+
+void
+esk8_ps2_decode_mvmt(
+    esk8_ps2_hndl_def_t*         ps2_hndl,
+    const esk8_ps2_sqnc_frame_t* sqnc,
+    esk8_ps2_mvmt_t*             out_mvmt
+);
+
 
 #endif /* _ESK8_PS2_PRIV_H */
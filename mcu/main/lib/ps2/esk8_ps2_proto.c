@@ -0,0 +1,267 @@
+#include <esk8_config.h>
+#include <esk8_err.h>
+#include <esk8_log.h>
+#include <esk8_ps2.h>
+#include <esk8_ps2_priv.h>
+
+#include <stdbool.h>
+#include <string.h>
+
+
+#define IMPS_DEV_ID         0x03    /* GET_DEV_ID answer once the wheel is on               */
+
+#define SYN_MAGIC           0x47    /* Middle byte of a Synaptics identify answer           */
+#define SYN_QUERY_IDENTIFY  0x00
+#define SYN_SET_MODE        0x14    /* Sample rate that writes the mode byte                */
+#define SYN_MODE_ABS        (1 << 7)
+#define SYN_MODE_RATE       (1 << 6)    /* 80 packets per second instead of 40              */
+#define SYN_Z_TOUCH         30      /* Pressure from which a finger is on the pad           */
+
+
+const esk8_ps2_pkt_def_t esk8_ps2_pkt_defs[ESK8_PS2_PROTO_MAX] = {
+    [ESK8_PS2_PROTO_NONE]      = { .len = 3, .hdr_mask = { 0x08 },             .hdr_val = { 0x08 }             },
+    [ESK8_PS2_PROTO_STD]       = { .len = 3, .hdr_mask = { 0x08 },             .hdr_val = { 0x08 }             },
+    [ESK8_PS2_PROTO_IMPS]      = { .len = 4, .hdr_mask = { 0x08 },             .hdr_val = { 0x08 }             },
+    [ESK8_PS2_PROTO_SYNAPTICS] = { .len = 6, .hdr_mask = { 0xC8, 0, 0, 0xC8 }, .hdr_val = { 0x80, 0, 0, 0xC0 } },
+};
+
+static const char* esk8_ps2_proto_names[ESK8_PS2_PROTO_MAX] = {
+    "none", "standard", "IntelliMouse", "Synaptics absolute"
+};
+
+
+void
+esk8_ps2_set_proto(
+    esk8_ps2_hndl_def_t* ps2_hndl,
+    esk8_ps2_proto_t     proto
+)
+{
+    ps2_hndl->proto   = proto;
+    ps2_hndl->pkt_def = esk8_ps2_pkt_defs[proto];
+    memset(&ps2_hndl->abs, 0, sizeof(ps2_hndl->abs));
+}
+
+
+/**
+ * Synaptics pads take their extra commands as
+ * a byte, sent 2 bits at a time as the argument
+ * of four SET_RESOLUTION commands. Fills the
+ * first 4 steps of `steps`.
+ **/
+static void
+esk8_ps2_syn_special(
+    esk8_ps2_step_t* steps,
+    uint8_t          byte
+)
+{
+    for (int i = 0; i < 4; i++)
+        steps[i] = (esk8_ps2_step_t){
+            .cmd     = ESK8_PS2_CMD_SET_RESOLUTION,
+            .has_arg = true,
+            .arg     = (byte >> (6 - 2 * i)) & 0x03,
+        };
+}
+
+static bool
+esk8_ps2_probe_synaptics(
+    esk8_ps2_hndl_def_t* ps2_hndl
+)
+{
+    uint8_t id[3];
+    esk8_ps2_step_t identify[5];
+    esk8_ps2_step_t set_mode[5];
+
+    esk8_ps2_syn_special(identify, SYN_QUERY_IDENTIFY);
+    identify[4] = (esk8_ps2_step_t){
+        .cmd = ESK8_PS2_CMD_GET_STATUS, .rsp = id, .rsp_len = sizeof(id)
+    };
+
+    if (esk8_ps2_run_script(ps2_hndl, identify, 5))
+        return false;
+
+    if (id[1] != SYN_MAGIC)
+        return false;
+
+    esk8_log_I(ESK8_TAG_PS2,
+        "Synaptics pad, firmware %d.%d\n",
+        id[2] & 0x0F, id[0]
+    );
+
+    esk8_ps2_syn_special(set_mode, SYN_MODE_ABS | SYN_MODE_RATE);
+    set_mode[4] = (esk8_ps2_step_t){
+        .cmd = ESK8_PS2_CMD_SET_SMPL_RATE, .has_arg = true, .arg = SYN_SET_MODE
+    };
+
+    return !esk8_ps2_run_script(ps2_hndl, set_mode, 5);
+}
+
+/**
+ * IntelliMouse devices turn their wheel on when
+ * they see this sequence of sample rates.
+ **/
+static bool
+esk8_ps2_probe_imps(
+    esk8_ps2_hndl_def_t* ps2_hndl
+)
+{
+    uint8_t id;
+
+    const esk8_ps2_step_t knock[] = {
+        { .cmd = ESK8_PS2_CMD_SET_SMPL_RATE, .has_arg = true, .arg = 200 },
+        { .cmd = ESK8_PS2_CMD_SET_SMPL_RATE, .has_arg = true, .arg = 100 },
+        { .cmd = ESK8_PS2_CMD_SET_SMPL_RATE, .has_arg = true, .arg = 80  },
+        { .cmd = ESK8_PS2_CMD_GET_DEV_ID,    .rsp = &id, .rsp_len = 1     },
+    };
+
+    if (esk8_ps2_run_script(ps2_hndl, knock, sizeof(knock) / sizeof(knock[0])))
+        return false;
+
+    return id == IMPS_DEV_ID;
+}
+
+esk8_err_t
+esk8_ps2_negotiate_locked(
+    esk8_ps2_hndl_def_t* ps2_hndl
+)
+{
+    esk8_ps2_proto_t proto = ESK8_PS2_PROTO_STD;
+
+    esk8_ps2_set_proto(ps2_hndl, proto);
+
+    if (esk8_ps2_probe_synaptics(ps2_hndl))
+    {
+        proto = ESK8_PS2_PROTO_SYNAPTICS;
+    }
+    else
+    {
+        /* The identify query left the resolution at its lowest */
+        const esk8_ps2_step_t set_default = { .cmd = ESK8_PS2_CMD_SET_DEFAULT };
+
+        ESK8_ERRCHECK_THROW(
+            esk8_ps2_run_script(ps2_hndl, &set_default, 1)
+        );
+
+        if (esk8_ps2_probe_imps(ps2_hndl))
+            proto = ESK8_PS2_PROTO_IMPS;
+
+        const esk8_ps2_step_t set_rate = {
+            .cmd = ESK8_PS2_CMD_SET_SMPL_RATE, .has_arg = true, .arg = ESK8_PS2_SMPL_RATE
+        };
+
+        esk8_err_t err = esk8_ps2_run_script(ps2_hndl, &set_rate, 1);
+
+        if (err)
+            esk8_log_W(ESK8_TAG_PS2,
+                "Could not set sample rate %d: %s\n",
+                ESK8_PS2_SMPL_RATE, esk8_err_to_str(err)
+            );
+    }
+
+    esk8_ps2_set_proto(ps2_hndl, proto);
+
+    esk8_log_I(ESK8_TAG_PS2,
+        "Using the %s protocol\n",
+        esk8_ps2_proto_names[proto]
+    );
+
+    return ESK8_OK;
+}
+
+esk8_err_t
+esk8_ps2_negotiate(
+    esk8_ps2_hndl_t hndl
+)
+{
+    esk8_ps2_hndl_def_t* ps2_hndl = (esk8_ps2_hndl_def_t*)hndl;
+
+    ESK8_ERRCHECK_THROW(esk8_ps2_tx_lock(ps2_hndl));
+
+    esk8_err_t err = esk8_ps2_negotiate_locked(ps2_hndl);
+
+    esk8_ps2_tx_unlock(ps2_hndl);
+    return err;
+}
+
+
+/**
+ * Turns finger positions into relative counts,
+ * carrying the remainder of the division over.
+ * Touching down only sets the starting point.
+ **/
+static void
+esk8_ps2_decode_abs(
+    esk8_ps2_hndl_def_t* ps2_hndl,
+    const uint8_t*       pkt,
+    esk8_ps2_mvmt_t*     out_mvmt
+)
+{
+    esk8_ps2_abs_t* abs = &ps2_hndl->abs;
+
+    int x = ((pkt[3] & 0x10) << 8) | ((pkt[1] & 0x0F) << 8) | pkt[4];
+    int y = ((pkt[3] & 0x20) << 7) | ((pkt[1] & 0xF0) << 4) | pkt[5];
+
+    out_mvmt->lft_btn = pkt[0] & 0x01;
+    out_mvmt->rgt_btn = (pkt[0] >> 1) & 0x01;
+    out_mvmt->z       = pkt[2];
+    out_mvmt->abs_x   = x;
+    out_mvmt->abs_y   = y;
+
+    if (out_mvmt->z < SYN_Z_TOUCH)
+    {
+        abs->touch = 0;
+        return;
+    }
+
+    if (abs->touch)
+    {
+        int dx = x - abs->x + abs->rem_x;
+        int dy = y - abs->y + abs->rem_y;
+
+        out_mvmt->x = dx / ESK8_PS2_ABS_DIV;
+        out_mvmt->y = dy / ESK8_PS2_ABS_DIV;
+        abs->rem_x  = dx % ESK8_PS2_ABS_DIV;
+        abs->rem_y  = dy % ESK8_PS2_ABS_DIV;
+    }
+    else
+    {
+        abs->rem_x = 0;
+        abs->rem_y = 0;
+    }
+
+    abs->touch = 1;
+    abs->x     = x;
+    abs->y     = y;
+}
+
+void
+esk8_ps2_decode_mvmt(
+    esk8_ps2_hndl_def_t*         ps2_hndl,
+    const esk8_ps2_sqnc_frame_t* sqnc,
+    esk8_ps2_mvmt_t*             out_mvmt
+)
+{
+    const uint8_t* pkt = sqnc->mvmt;
+
+    memset(out_mvmt, 0, sizeof(esk8_ps2_mvmt_t));
+    out_mvmt->proto = ps2_hndl->proto;
+    out_mvmt->t_us  = sqnc->t_us;
+
+    if (ps2_hndl->proto == ESK8_PS2_PROTO_SYNAPTICS)
+    {
+        esk8_ps2_decode_abs(ps2_hndl, pkt, out_mvmt);
+        return;
+    }
+
+    bool sX, sY;
+    sX = pkt[0] & (1 << 4);
+    sY = pkt[0] & (1 << 5);
+
+    out_mvmt->lft_btn = pkt[0] & 0x01;
+    out_mvmt->rgt_btn = (pkt[0] >> 1) & 0x01;
+    out_mvmt->mdl_btn = (pkt[0] >> 2) & 0x01;
+    out_mvmt->x       = sX * -256 + pkt[1];
+    out_mvmt->y       = sY * -256 + pkt[2];
+
+    if (ps2_hndl->proto == ESK8_PS2_PROTO_IMPS)
+        out_mvmt->z = (int8_t)pkt[3];
+}
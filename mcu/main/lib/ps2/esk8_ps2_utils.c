@@ -4,6 +4,7 @@
 #include <esk8_ps2_priv.h>
 
 #include <driver/gpio.h>
+#include <esp_timer.h>
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
@@ -12,8 +13,6 @@
 
 #include <memory.h>
 
-#define PCK_CMD_WAIT_ms 20 // ms to wait between cmds
-
 
 void
 esk8_ps2_set_bit(
@@ -56,6 +55,22 @@ esk8_ps2_get_parity(
 }
 
 
+/**
+ * Far too short to sleep through, a tick
+ * is 10 ms.
+ **/
+static void
+esk8_ps2_delay_us(
+    int64_t us
+)
+{
+    int64_t until_us = esp_timer_get_time() + us;
+
+    while (esp_timer_get_time() < until_us)
+        ;
+}
+
+
 void
 esk8_ps2_send_byte(
     esk8_ps2_hndl_t hndl,
@@ -67,76 +82,258 @@ esk8_ps2_send_byte(
     int c_pin = ps2_hndl->ps2_cnfg.clock_pin;
     int d_pin = ps2_hndl->ps2_cnfg.data_pin;
 
+    /* Inhibit, the device drops whatever it was sending */
+    gpio_set_level(c_pin, 0);
     gpio_set_direction(c_pin, GPIO_MODE_OUTPUT);
-    gpio_set_direction(d_pin, GPIO_MODE_OUTPUT);
 
-    gpio_set_level(c_pin, 0);
     esk8_ps2_reset_frame(&ps2_hndl->inflight); // Whatever byte was inflight is lost.
     ps2_hndl->inflight.byte = byte;
     ps2_hndl->ps2_state = ESK8_PS2_STATE_SEND;
-    vTaskDelay(1 / portTICK_PERIOD_MS);
+    esk8_ps2_delay_us(ESK8_PS2_INHIBIT_US);
 
+    /* Request to send: start bit down, then let the device clock it */
+    gpio_set_level(d_pin, 0);
+    gpio_set_direction(d_pin, GPIO_MODE_OUTPUT);
     gpio_set_direction(c_pin, GPIO_MODE_INPUT);
 }
 
 
-esk8_err_t
-esk8_ps2_send_cmd(
-    esk8_ps2_hndl_t hndl,
-    esk8_ps2_cmd_t  cmd
+/**
+ * Waits `timeout_ms` for the next byte the
+ * ISR got outside of a movement packet.
+ **/
+static esk8_err_t
+esk8_ps2_recv_byte(
+    esk8_ps2_hndl_def_t* ps2_hndl,
+    uint8_t*             out_byte,
+    uint32_t             timeout_ms
 )
 {
-    esk8_err_t err = ESK8_OK;
-    esk8_ps2_hndl_def_t* ps2_hndl = (esk8_ps2_hndl_def_t*)hndl;
+    esk8_ps2_frame_t frame;
 
+    /* Rounded up, so a short timeout is never cut to nothing */
     if  (
-            xSemaphoreTake(
-                ps2_hndl->tx_lock,
-                ps2_hndl->ps2_cnfg.rx_timeout_ms / portTICK_PERIOD_MS
+            xQueueReceive(
+                ps2_hndl->rx_queue,
+                &frame,
+                timeout_ms / portTICK_PERIOD_MS + 1
             ) != pdTRUE
         )
     {
-        return ESK8_PS2_ERR_TIMEOUT;
+        return ESK8_PS2_ERR_RESP_TIMEOUT;
+    }
+
+    if (frame.err)
+    {
+        esk8_log_E(ESK8_TAG_PS2,
+            "Got err: %s in frame.\n",
+            esk8_err_to_str(frame.err)
+        );
+        return frame.err;
     }
 
-    esk8_ps2_send_byte(hndl, (uint8_t)cmd);
+    (*out_byte) = frame.byte;
+    return ESK8_OK;
+}
 
-    uint8_t resp = 0;
-    err = esk8_ps2_await_rsp(
-        ps2_hndl,
-        &resp
-    );
 
-    if (err)
-        goto cleanup;
+/**
+ * Sends one byte, and waits for its ACK and
+ * the `rsp_len` bytes that follow it. A byte
+ * the device asks for again is sent again.
+ * The caller holds `tx_lock`.
+ **/
+static esk8_err_t
+esk8_ps2_xfer(
+    esk8_ps2_hndl_def_t* ps2_hndl,
+    uint8_t              byte,
+    uint8_t*             rsp,
+    size_t               rsp_len
+)
+{
+    esk8_err_t err = ESK8_OK;
+    uint8_t resp = ESK8_PS2_RES_RESEND;
+
+    for (int n = 0; resp == ESK8_PS2_RES_RESEND && n <= ESK8_PS2_RESEND_MAX; n++)
+    {
+        /* Left overs of an earlier, failed, command would read as our answer */
+        xQueueReset(ps2_hndl->rx_queue);
+        ps2_hndl->rx_expect = 1 + rsp_len;
+
+        uint32_t n_edges    = ps2_hndl->n_edges;
+        uint32_t n_rx_edges = ps2_hndl->n_rx_edges;
+
+        esk8_ps2_send_byte(ps2_hndl, byte);
+
+        err = esk8_ps2_recv_byte(
+            ps2_hndl,
+            &resp,
+            ESK8_PS2_ACK_TIMEOUT_MS
+        );
+
+        /**
+         * The device clocked something back that made
+         * no sense, or clocked without ever taking
+         * our byte. It may be one powering up over
+         * our command, so don't leave
+         * `esk8_ps2_await_plug` waiting for it.
+         * A device that just fails to answer only
+         * clocked our own byte out, and waits.
+         **/
+        if  (
+                err &&
+                (
+                    ps2_hndl->n_rx_edges != n_rx_edges ||
+                    (
+                        ps2_hndl->ps2_state == ESK8_PS2_STATE_SEND &&
+                        ps2_hndl->n_edges != n_edges
+                    )
+                )
+            )
+            xSemaphoreGive(ps2_hndl->plug_sem);
+
+        if (err)
+            return err;
+    }
 
     esk8_log_D(ESK8_TAG_PS2,
-        "Got response: 0x%02x for cmd: 0x%02x\n",
-        resp, cmd
+        "Got response: 0x%02x for byte: 0x%02x\n",
+        resp, byte
     );
 
     if (resp == ESK8_PS2_RES_RESEND)
-    {
-        err = ESK8_PS2_ERR_RESEND;
-        goto cleanup;
-    }
+        return ESK8_PS2_ERR_RESEND;
 
     if (resp == ESK8_PS2_RES_ERROR)
+        return ESK8_PS2_ERR_ERROR;
+
+    if (resp != ESK8_PS2_RES_ACK)
+        return ESK8_PS2_ERR_NO_ACK;
+
+    for (size_t i = 0; i < rsp_len; i++)
+        ESK8_ERRCHECK_THROW(
+            esk8_ps2_recv_byte(ps2_hndl, &rsp[i], ps2_hndl->ps2_cnfg.rx_timeout_ms)
+        );
+
+    return ESK8_OK;
+}
+
+
+esk8_err_t
+esk8_ps2_tx_lock(
+    esk8_ps2_hndl_def_t* ps2_hndl
+)
+{
+    if  (
+            xSemaphoreTake(
+                ps2_hndl->tx_lock,
+                ps2_hndl->ps2_cnfg.rx_timeout_ms / portTICK_PERIOD_MS
+            ) != pdTRUE
+        )
     {
-        err = ESK8_PS2_ERR_ERROR;
-        goto cleanup;
+        return ESK8_PS2_ERR_TIMEOUT;
     }
 
-    if (resp != ESK8_PS2_RES_ACK)
-        err = ESK8_PS2_ERR_NO_ACK;
+    return ESK8_OK;
+}
 
-cleanup:
-    esk8_ps2_reset_frame(&ps2_hndl->inflight);
+
+void
+esk8_ps2_tx_unlock(
+    esk8_ps2_hndl_def_t* ps2_hndl
+)
+{
+    /**
+     * The inflight frame is the ISR's by now, a
+     * polled packet may already be coming in
+     * right behind the ACK.
+     **/
     xSemaphoreGive(ps2_hndl->tx_lock);
+}
+
+
+esk8_err_t
+esk8_ps2_run_script(
+    esk8_ps2_hndl_def_t*   ps2_hndl,
+    const esk8_ps2_step_t* steps,
+    size_t                 n_steps
+)
+{
+    for (size_t i = 0; i < n_steps; i++)
+    {
+        const esk8_ps2_step_t* step = &steps[i];
+
+        ESK8_ERRCHECK_THROW(
+            esk8_ps2_xfer(ps2_hndl, (uint8_t)step->cmd,
+                step->has_arg ? NULL : step->rsp,
+                step->has_arg ? 0 : step->rsp_len)
+        );
+
+        if (step->has_arg)
+            ESK8_ERRCHECK_THROW(
+                esk8_ps2_xfer(ps2_hndl, step->arg, step->rsp, step->rsp_len)
+            );
+    }
+
+    return ESK8_OK;
+}
+
+
+esk8_err_t
+esk8_ps2_send_script(
+    esk8_ps2_hndl_t        hndl,
+    const esk8_ps2_step_t* steps,
+    size_t                 n_steps
+)
+{
+    esk8_ps2_hndl_def_t* ps2_hndl = (esk8_ps2_hndl_def_t*)hndl;
+
+    ESK8_ERRCHECK_THROW(esk8_ps2_tx_lock(ps2_hndl));
+
+    esk8_err_t err = esk8_ps2_run_script(ps2_hndl, steps, n_steps);
+
+    esk8_ps2_tx_unlock(ps2_hndl);
     return err;
 }
 
 
+esk8_err_t
+esk8_ps2_send_cmd(
+    esk8_ps2_hndl_t hndl,
+    esk8_ps2_cmd_t  cmd
+)
+{
+    return esk8_ps2_send_cmd_rsp(hndl, cmd, NULL, 0);
+}
+
+
+esk8_err_t
+esk8_ps2_send_cmd_arg(
+    esk8_ps2_hndl_t hndl,
+    esk8_ps2_cmd_t  cmd,
+    uint8_t         arg
+)
+{
+    esk8_ps2_step_t step = { .cmd = cmd, .has_arg = true, .arg = arg };
+
+    return esk8_ps2_send_script(hndl, &step, 1);
+}
+
+
+esk8_err_t
+esk8_ps2_send_cmd_rsp(
+    esk8_ps2_hndl_t hndl,
+    esk8_ps2_cmd_t  cmd,
+    uint8_t*        rsp,
+    size_t          rsp_len
+)
+{
+    esk8_ps2_step_t step = { .cmd = cmd, .rsp = rsp, .rsp_len = rsp_len };
+
+    return esk8_ps2_send_script(hndl, &step, 1);
+}
+
+
 esk8_err_t
 esk8_ps2_await_rsp(
     esk8_ps2_hndl_t hndl,
@@ -144,31 +341,67 @@ esk8_ps2_await_rsp(
 )
 {
     esk8_ps2_hndl_def_t* ps2_hndl = (esk8_ps2_hndl_def_t*)hndl;
-    esk8_ps2_cnfg_t* ps2_cnfg = &ps2_hndl->ps2_cnfg;
 
-    esk8_ps2_frame_t frame;
+    return esk8_ps2_recv_byte(ps2_hndl, out_byte, ps2_hndl->ps2_cnfg.rx_timeout_ms);
+}
 
-    if  (
-            xQueueReceive(
-                ps2_hndl->rx_queue,
-                &frame,
-                ps2_cnfg->rx_timeout_ms / portTICK_PERIOD_MS
-            ) != pdTRUE
-        )
-    {
-        return ESK8_PS2_ERR_RESP_TIMEOUT;
-    }
 
-    if (frame.err)
+/**
+ * Stops reporting, negotiates the protocol and
+ * clears whatever movement was pending, then
+ * starts the device again with the `start`
+ * script. It is all one transaction.
+ **/
+static esk8_err_t
+esk8_ps2_mvmt_start(
+    esk8_ps2_hndl_t        hndl,
+    const esk8_ps2_step_t* start,
+    size_t                 n_start
+)
+{
+    esk8_ps2_hndl_def_t* ps2_hndl = (esk8_ps2_hndl_def_t*)hndl;
+    const esk8_ps2_step_t disable = { .cmd = ESK8_PS2_CMD_DATA_DISABLE };
+
+    ESK8_ERRCHECK_THROW(esk8_ps2_tx_lock(ps2_hndl));
+
+    /* Only announcements from here on count */
+    xSemaphoreTake(ps2_hndl->plug_sem, 0);
+
+    esk8_err_t err = esk8_ps2_run_script(ps2_hndl, &disable, 1);
+
+    /* The device may have been swapped, or reset itself */
+    if (!err)
+        err = esk8_ps2_negotiate_locked(ps2_hndl);
+
+    if (!err)
     {
-        esk8_log_E(ESK8_TAG_PS2,
-            "Got err: %s in frame.\n",
-            esk8_err_to_str(frame.err)
-        );
-        return frame.err;
+        /**
+         * The stream is off, so the ISR is not touching
+         * its packet. Whatever is in the ring is stale.
+         **/
+        esk8_ps2_ring_t* ring = &ps2_hndl->mv_ring;
+
+        ps2_hndl->sqnc_frame.err = ESK8_OK;
+        ps2_hndl->sqnc_frame.idx = 0;
+        ps2_hndl->resync_bytes = 0;
+        ps2_hndl->mv_task = xTaskGetCurrentTaskHandle();
+
+        __atomic_store_n(&ring->tail,
+            __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+        ulTaskNotifyTake(pdTRUE, 0);
+
+        err = esk8_ps2_run_script(ps2_hndl, start, n_start);
     }
 
-    (*out_byte) = frame.byte;
+    esk8_ps2_tx_unlock(ps2_hndl);
+
+    if (err)
+        return err;
+
+    /* Reset half way through, so it is back to its defaults */
+    if (xSemaphoreTake(ps2_hndl->plug_sem, 0) == pdTRUE)
+        return ESK8_PS2_ERR_DEV_RESET;
+
     return ESK8_OK;
 }
 
@@ -178,24 +411,44 @@ esk8_ps2_mvmt_sync(
     esk8_ps2_hndl_t hndl
 )
 {
-    esk8_err_t err = ESK8_OK;
-    esk8_ps2_hndl_def_t* ps2_hndl = (esk8_ps2_hndl_def_t*)hndl;
+    /* A Synaptics pad keeps its mode through negotiation, it may still be polled */
+    static const esk8_ps2_step_t start[] = {
+        { .cmd = ESK8_PS2_CMD_SET_MODE_STREAM },
+        { .cmd = ESK8_PS2_CMD_DATA_ENABLE     },
+    };
+
+    return esk8_ps2_mvmt_start(hndl, start, sizeof(start) / sizeof(start[0]));
+}
 
-    ESK8_ERRCHECK_THROW(
-        esk8_ps2_send_cmd(hndl, ESK8_PS2_CMD_DATA_DISABLE)
-    );
 
-    xQueueReset(ps2_hndl->mv_queue);
-    ps2_hndl->sqnc_frame.idx = 0;
+esk8_err_t
+esk8_ps2_mvmt_sync_remote(
+    esk8_ps2_hndl_t hndl
+)
+{
+    static const esk8_ps2_step_t start[] = {
+        { .cmd = ESK8_PS2_CMD_SET_MODE_REMOTE },
+    };
+
+    return esk8_ps2_mvmt_start(hndl, start, sizeof(start) / sizeof(start[0]));
+}
 
-    vTaskDelay(PCK_CMD_WAIT_ms / portTICK_PERIOD_MS);
 
+esk8_err_t
+esk8_ps2_poll_mvmt(
+    esk8_ps2_hndl_t  hndl,
+    esk8_ps2_mvmt_t* out_mvmt
+)
+{
+    /**
+     * The packet follows the ACK, and goes through
+     * the ISR packet assembler like a streamed one.
+     **/
     ESK8_ERRCHECK_THROW(
-        esk8_ps2_send_cmd(hndl, ESK8_PS2_CMD_DATA_ENABLE)
+        esk8_ps2_send_cmd(hndl, ESK8_PS2_CMD_MODE_REMOTE_DATA_READ)
     );
 
-    xSemaphoreGive(ps2_hndl->tx_lock);
-    return err;
+    return esk8_ps2_await_mvmt(hndl, out_mvmt);
 }
 
 
@@ -205,47 +458,95 @@ esk8_ps2_await_mvmt(
     esk8_ps2_mvmt_t* out_mvmt
 )
 {
-    esk8_ps2_frame_t frame;
     esk8_ps2_hndl_def_t* ps2_hndl = (esk8_ps2_hndl_def_t*)hndl;
     esk8_ps2_cnfg_t* ps2_cnfg = &ps2_hndl->ps2_cnfg;
-    esk8_ps2_sqnc_frame_t* sqnc = &ps2_hndl->sqnc_frame;
+    esk8_ps2_ring_t* ring = &ps2_hndl->mv_ring;
 
-    while (sqnc->idx < 3)
-    {
-        BaseType_t recv = xQueueReceive(
-            ps2_hndl->mv_queue,
-            &frame,
-            ps2_cnfg->rx_timeout_ms / portTICK_PERIOD_MS
-        );
+    uint32_t tail = ring->tail;
 
-        if (recv != pdTRUE)
+    /**
+     * The ISR notifies once per packet. Stale
+     * notifications only cost an extra look at
+     * the ring, so just check it again.
+     **/
+    while (__atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) == tail)
+    {
+        if  (
+                !ulTaskNotifyTake(
+                    pdTRUE,
+                    ps2_cnfg->rx_timeout_ms / portTICK_PERIOD_MS
+                )
+            )
+        {
             return ESK8_PS2_ERR_TIMEOUT;
+        }
+    }
 
-        if (frame.err)
-        {
-            esk8_log_E(ESK8_TAG_PS2,
-                "Gor error in packet: %s\n",
-                esk8_err_to_str(frame.err)
-            );
+    esk8_ps2_sqnc_frame_t sqnc = ring->pkts[tail & (ESK8_PS2_MVMT_RING_LEN - 1)];
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
 
-            return frame.err;
-        }
+    if (sqnc.err)
+    {
+        esk8_log_E(ESK8_TAG_PS2,
+            "Gor error in packet: %s\n",
+            esk8_err_to_str(sqnc.err)
+        );
 
-        sqnc->mvmt[sqnc->idx] = frame.byte;
-        sqnc->idx++;
+        return sqnc.err;
     }
 
-    if (!(sqnc->mvmt[0] & (1 << 3)))
-        return ESK8_PS2_ERR_BAD_MVMT;
+    esk8_ps2_decode_mvmt(ps2_hndl, &sqnc, out_mvmt);
+    return ESK8_OK;
+}
 
-    bool sX, sY;
-    sX = sqnc->mvmt[0] & (1 << 4);
-    sY = sqnc->mvmt[0] & (1 << 5);
 
-    out_mvmt->lft_btn = sqnc->mvmt[0] & 1;
-    out_mvmt->x       = sX * -256 + sqnc->mvmt[1];
-    out_mvmt->y       = sY * -256 + sqnc->mvmt[2];
+esk8_err_t
+esk8_ps2_await_plug(
+    esk8_ps2_hndl_t hndl,
+    uint32_t        timeout_ms
+)
+{
+    esk8_ps2_hndl_def_t* ps2_hndl = (esk8_ps2_hndl_def_t*)hndl;
+
+    ESK8_ERRCHECK_THROW(esk8_ps2_tx_lock(ps2_hndl));
+
+    /* Whatever half sent byte, or stream, is gone */
+    ps2_hndl->ps2_state = ESK8_PS2_STATE_NONE;
+    esk8_ps2_reset_frame(&ps2_hndl->inflight);
+
+    esk8_ps2_tx_unlock(ps2_hndl);
+
+    if  (
+            xSemaphoreTake(
+                ps2_hndl->plug_sem,
+                timeout_ms ? timeout_ms / portTICK_PERIOD_MS : portMAX_DELAY
+            ) != pdTRUE
+        )
+    {
+        return ESK8_PS2_ERR_TIMEOUT;
+    }
+
+    /* Let it get its announcement out before talking to it */
+    uint32_t n_edges;
+    do
+    {
+        n_edges = __atomic_load_n(&ps2_hndl->n_edges, __ATOMIC_RELAXED);
+        vTaskDelay(1);
+    }
+    while (__atomic_load_n(&ps2_hndl->n_edges, __ATOMIC_RELAXED) != n_edges);
 
-    sqnc->idx = 0;
     return ESK8_OK;
 }
+
+
+void
+esk8_ps2_get_stats(
+    esk8_ps2_hndl_t   hndl,
+    esk8_ps2_stats_t* out_stats
+)
+{
+    esk8_ps2_hndl_def_t* ps2_hndl = (esk8_ps2_hndl_def_t*)hndl;
+
+    /* Single words, written by the ISR only */
+    (*out_stats) = ps2_hndl->stats;
+}
@@ -1,4 +1,6 @@
+#include <esk8_config.h>
 #include <esk8_err.h>
+#include <esk8_hist.h>
 #include <esk8_log.h>
 #include <esk8_pwm.h>
 #include <esk8_ps2.h>
@@ -6,6 +8,7 @@
 #include <esk8_remote_priv.h>
 
 #include <esp_log.h>
+#include <esp_timer.h>
 #include <nvs_flash.h>
 
 #include <esp_bt.h>
@@ -14,8 +17,12 @@
 #include <esp_gap_ble_api.h>
 
 #include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 #include <freertos/task.h>
 
+#include <stdlib.h>
+#include <string.h>
+
 
 esk8_remote_t esk8_remote = { 0 };
 
@@ -32,6 +39,119 @@ esk8_remote_gap_cb(
     esp_ble_gap_cb_param_t *param
 );
 
+/**
+ * The control loop. It runs off the esp_timer
+ * hardware timer, so the output is updated at
+ * the same rate whatever the trackpad sends,
+ * with whatever movement came in since. Keep
+ * it short, and without logs.
+ **/
+static void
+esk8_remote_ctrl_tmr_cb(
+    void* param
+)
+{
+    int64_t now_us  = esp_timer_get_time();
+    int64_t last_us = esk8_remote.tick_us;
+
+    if (last_us)
+        esk8_hist_add(
+            &esk8_remote.lat[ESK8_RMT_LAT_JITTER],
+            llabs(now_us - last_us - ESK8_RMT_CTRL_MS * 1000)
+        );
+
+    esk8_remote.tick_us = now_us;
+
+    /**
+     * Movement first: packets stamp before they add theirs,
+     * so the stamp of any movement taken here is in too. A
+     * stamp taken without movement belongs to a packet that
+     * lands on the next tick, and is dropped, rather than
+     * timing a tick that applied nothing.
+     **/
+    int incr = __atomic_exchange_n(&esk8_remote.acc_incr, 0, __ATOMIC_ACQUIRE);
+    uint32_t acc_us = __atomic_exchange_n(&esk8_remote.acc_us, 0, __ATOMIC_RELAXED);
+
+    /* Back to a full stamp, the low bits wrap every 71 minutes */
+    int64_t in_us = acc_us ? now_us - (uint32_t)((uint32_t)now_us - acc_us) : 0;
+
+    if (incr)
+        esk8_remote_incr_speed(incr, in_us);
+
+    /* Poll just in time for the next tick, now if the timer fails */
+    if (esk8_remote.poll_tmr)
+    {
+        uint32_t lead_us = esk8_remote.poll_us + ESK8_RMT_PS2_POLL_MARGIN_US;
+        uint32_t wait_us = lead_us < ESK8_RMT_CTRL_MS * 1000 ? ESK8_RMT_CTRL_MS * 1000 - lead_us : 0;
+
+        if (esp_timer_start_once(esk8_remote.poll_tmr, wait_us))
+            xSemaphoreGive(esk8_remote.poll_sem);
+    }
+}
+
+static void
+esk8_remote_poll_tmr_cb(
+    void* param
+)
+{
+    xSemaphoreGive(esk8_remote.poll_sem);
+}
+
+static esk8_err_t
+esk8_remote_ctrl_init()
+{
+    if (ESK8_RMT_PS2_POLL)
+    {
+        esk8_remote.poll_sem = xSemaphoreCreateBinary();
+        if (!esk8_remote.poll_sem)
+            return ESK8_ERR_OOM;
+
+        const esp_timer_create_args_t poll_args = {
+            .name = "rmt_poll",
+            .callback = esk8_remote_poll_tmr_cb,
+            .dispatch_method = ESP_TIMER_TASK,
+        };
+
+        if  (
+                esp_timer_create(
+                    &poll_args,
+                    (esp_timer_handle_t*)&esk8_remote.poll_tmr
+                )
+            )
+        {
+            esk8_remote.poll_tmr = NULL;
+            return ESK8_ERR_OOM;
+        }
+    }
+
+    const esp_timer_create_args_t tmr_args = {
+        .name = "rmt_ctrl",
+        .callback = esk8_remote_ctrl_tmr_cb,
+        .dispatch_method = ESP_TIMER_TASK,
+    };
+
+    if  (
+            esp_timer_create(
+                &tmr_args,
+                (esp_timer_handle_t*)&esk8_remote.ctrl_tmr
+            )
+        )
+    {
+        esk8_remote.ctrl_tmr = NULL;
+        return ESK8_ERR_OOM;
+    }
+
+    if  (
+            esp_timer_start_periodic(
+                esk8_remote.ctrl_tmr,
+                ESK8_RMT_CTRL_MS * 1000
+            )
+        )
+        return ESK8_ERR_REMT_TMR;
+
+    return ESK8_OK;
+}
+
 esk8_err_t
 esk8_remote_start()
 {
@@ -89,6 +209,14 @@ esk8_remote_start()
         return err;
     }
 
+    err = esk8_remote_ctrl_init();
+
+    if (err)
+    {
+        esk8_remote_stop();
+        return err;
+    }
+
     BaseType_t ps2_tsk = xTaskCreate(
         esk8_remote_task_ps2,
         "esk8_remote_task_ps2",
@@ -145,6 +273,21 @@ esk8_remote_stop()
     if (esk8_remote.hndl_btn)
         esk8_btn_deinit(esk8_remote.hndl_btn);
 
+    if (esk8_remote.ctrl_tmr)
+    {
+        esp_timer_stop(esk8_remote.ctrl_tmr);
+        esp_timer_delete(esk8_remote.ctrl_tmr);
+    }
+
+    if (esk8_remote.poll_tmr)
+    {
+        esp_timer_stop(esk8_remote.poll_tmr);
+        esp_timer_delete(esk8_remote.poll_tmr);
+    }
+
+    if (esk8_remote.poll_sem)
+        vSemaphoreDelete(esk8_remote.poll_sem);
+
     if (esk8_remote.hndl_ps2)
         esk8_ps2_deinit(esk8_remote.hndl_ps2);
 
@@ -156,26 +299,77 @@ esk8_remote_stop()
 
 esk8_err_t
 esk8_remote_incr_speed(
-    int incr
+    int     incr,
+    int64_t in_us
 )
 {
+    int64_t tick_us = esp_timer_get_time();
+
     esk8_remote.speed += incr;
     esk8_remote.speed = esk8_remote.speed > 255 ? 255 : esk8_remote.speed;
     esk8_remote.speed = esk8_remote.speed < 0   ? 0   : esk8_remote.speed;
 
-    esk8_log_I(ESK8_TAG_RMT,
-        "Speed incr: %d. Now: %d\n",
-        incr, esk8_remote.speed
-    );
-
     esk8_err_t err = esk8_pwm_sgnl_set(
         esk8_remote.hndl_pwm,
         esk8_remote.speed
     );
 
+    if (in_us)
+    {
+        int64_t out_us = esp_timer_get_time();
+        esk8_hist_t* lat = esk8_remote.lat;
+
+        esk8_hist_add(&lat[ESK8_RMT_LAT_ISR_TICK], tick_us - in_us);
+        esk8_hist_add(&lat[ESK8_RMT_LAT_TICK_OUT], out_us - tick_us);
+        esk8_hist_add(&lat[ESK8_RMT_LAT_TOTAL],    out_us - in_us);
+    }
+
     return err;
 }
 
+void
+esk8_remote_add_mvmt(
+    int     incr,
+    int64_t in_us
+)
+{
+    /**
+     * Only the oldest stamp since the last tick
+     * is kept, it is the one that waited longest.
+     * The low bit is forced, 0 means none.
+     **/
+    uint32_t none = 0;
+
+    if (in_us)
+        __atomic_compare_exchange_n(&esk8_remote.acc_us, &none, (uint32_t)in_us | 1,
+            false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+
+    __atomic_fetch_add(&esk8_remote.acc_incr, incr, __ATOMIC_RELEASE);
+}
+
+void
+esk8_remote_lat_get(
+    esk8_hist_t out_hists[ESK8_RMT_LAT_MAX]
+)
+{
+    memcpy(out_hists, esk8_remote.lat, sizeof(esk8_remote.lat));
+}
+
+void
+esk8_remote_lat_print()
+{
+    static const char* names[ESK8_RMT_LAT_MAX] = {
+        "isr->task", "isr->tick", "tick->pwm", "isr->pwm", "tick jitter"
+    };
+
+    /* One at a time, this runs on the small button task stack */
+    for (int i = 0; i < ESK8_RMT_LAT_MAX; i++)
+    {
+        esk8_hist_t lat = esk8_remote.lat[i];
+        esk8_hist_print(ESK8_TAG_RMT, names[i], &lat);
+    }
+}
+
 void
 esk8_remote_gap_cb(
     esp_gap_ble_cb_event_t  event,
@@ -2,6 +2,7 @@
 #define _ESK8_REMOTE_H
 
 #include <esk8_err.h>
+#include <esk8_hist.h>
 #include <esk8_ps2.h>
 #include <esk8_pwm.h>
 #include <esk8_btn.h>
@@ -9,6 +10,22 @@
 #include <stdint.h>
 
 
+/**
+ * Stages a trackpad movement goes through
+ * on its way to the output, and how steady
+ * the control loop is.
+ **/
+typedef enum
+{
+    ESK8_RMT_LAT_ISR_TASK,      /* ISR got the last byte, to the task having the packet */
+    ESK8_RMT_LAT_ISR_TICK,      /* ISR to the control tick applying it                  */
+    ESK8_RMT_LAT_TICK_OUT,      /* Control tick, to the PWM duty updated                */
+    ESK8_RMT_LAT_TOTAL,         /* ISR to PWM                                           */
+    ESK8_RMT_LAT_JITTER,        /* How far a control tick was off its period            */
+    ESK8_RMT_LAT_MAX,
+}
+esk8_remote_lat_t;
+
 esk8_err_t
 esk8_remote_start(
 );
@@ -17,9 +34,42 @@ esk8_err_t
 esk8_remote_stop(
 );
 
+/**
+ * `in_us` is the `esp_timer_get_time` at
+ * which the input came in, 0 if it isn't
+ * traced. Only the control loop calls it.
+ **/
 esk8_err_t
 esk8_remote_incr_speed(
-    int incr
+    int     incr,
+    int64_t in_us
+);
+
+/**
+ * Adds a movement to what the next control
+ * tick applies. Safe from any task.
+ **/
+void
+esk8_remote_add_mvmt(
+    int     incr,
+    int64_t in_us
+);
+
+/**
+ * Copies the latency histograms out, one per
+ * `esk8_remote_lat_t`. They are fixed size,
+ * ready to go out over BLE as they are.
+ **/
+void
+esk8_remote_lat_get(
+    esk8_hist_t out_hists[ESK8_RMT_LAT_MAX]
+);
+
+/**
+ * Logs the latency histograms to the console.
+ **/
+void
+esk8_remote_lat_print(
 );
 
 esk8_err_t
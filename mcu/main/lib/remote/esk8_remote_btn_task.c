@@ -34,5 +34,9 @@ esk8_remote_task_btn(
             "Got press: %s\n",
             press ? "ESK8_BTN_LONGPRESS":"ESK8_BTN_PRESS"
         );
+
+        /* Nothing else uses a long press yet */
+        if (press == ESK8_BTN_LONGPRESS)
+            esk8_remote_lat_print();
     }
 }
\ No newline at end of file
@@ -26,6 +26,17 @@ typedef struct
     void* task_btn;
     void* task_ble;
     void* task_ps2;
+    void* ctrl_tmr;
+    void* poll_tmr;     /* Fires ahead of every control tick, when polling the trackpad */
+    void* poll_sem;     /* Given by it */
+    uint32_t poll_us;   /* How long a poll takes, as a slowly decaying peak */
+
+    /* Movement since the last control tick */
+    int      acc_incr;
+    uint32_t acc_us;    /* Low bits of the oldest stamp in it, 0 if none */
+    int64_t  tick_us;
+
+    esk8_hist_t lat[ESK8_RMT_LAT_MAX];
 }
 esk8_remote_t;
 
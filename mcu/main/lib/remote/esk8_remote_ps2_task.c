@@ -4,7 +4,10 @@
 #include <esk8_remote.h>
 #include <esk8_remote_priv.h>
 
-#include <unistd.h>
+#include <esp_timer.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 
 
 void
@@ -13,11 +16,16 @@ esk8_remote_task_ps2(
 )
 {
     esk8_err_t err;
-    bool ps2_available = false;
+    bool polled = ESK8_RMT_PS2_POLL;
 
     while (1)
     {
-        err = esk8_ps2_mvmt_sync(esk8_remote.hndl_ps2);
+        err = polled ?
+            esk8_ps2_mvmt_sync_remote(esk8_remote.hndl_ps2) :
+            esk8_ps2_mvmt_sync(esk8_remote.hndl_ps2);
+        if (err == ESK8_PS2_ERR_DEV_RESET)
+            continue;
+
         if (err)
         {
             esk8_log_E(ESK8_TAG_RMT,
@@ -27,48 +35,77 @@ esk8_remote_task_ps2(
 
             /**
              * We might not have a ps2 device attatched.
-             * If this is the case, we hold a second before
-             * retrying.
+             * Rather than asking again and again, wait
+             * for one to announce itself.
              */
-            if  (!ps2_available)
-                sleep(1);
-            else
-                usleep(10 * 1000); // 10 ms
+            if (esk8_ps2_await_plug(esk8_remote.hndl_ps2, ESK8_RMT_PS2_PROBE_MS) == ESK8_OK)
+                esk8_log_I(ESK8_TAG_RMT, "PS2 device plugged in.\n");
 
             continue;
         }
 
-        ps2_available = true;
         esk8_log_I(ESK8_TAG_RMT,
-            "OK on ps2 data stream.\n"
+            "OK on ps2 data %s.\n",
+            polled ? "polling" : "stream"
         );
 
         while(1)
         {
             esk8_ps2_mvmt_t mvmt;
-            err = esk8_ps2_await_mvmt(
-                esk8_remote.hndl_ps2,
-                &mvmt
-            );
+
+            if (polled)
+            {
+                /* Sampled just ahead of the control tick, it goes out on it */
+                xSemaphoreTake(esk8_remote.poll_sem, portMAX_DELAY);
+
+                int64_t poll_us = esp_timer_get_time();
+                err = esk8_ps2_poll_mvmt(
+                    esk8_remote.hndl_ps2,
+                    &mvmt
+                );
+                poll_us = esp_timer_get_time() - poll_us;
+
+                /* Up at once, down slowly, so one quick poll doesn't make the next one late */
+                uint32_t peak_us = esk8_remote.poll_us;
+                if (!err)
+                    esk8_remote.poll_us = poll_us > peak_us ? poll_us : peak_us - (peak_us - poll_us) / 16;
+            }
+            else
+            {
+                err = esk8_ps2_await_mvmt(
+                    esk8_remote.hndl_ps2,
+                    &mvmt
+                );
+            }
+
+            if (err == ESK8_PS2_ERR_DEV_RESET)
+            {
+                esk8_log_I(ESK8_TAG_RMT, "PS2 device was reset, setting it up again.\n");
+                break;
+            }
 
             if (err)
             {
+                esk8_ps2_stats_t stats;
+                esk8_ps2_get_stats(esk8_remote.hndl_ps2, &stats);
+
                 esk8_log_W(ESK8_TAG_RMT,
-                    "Error awaiting ps2 mvmt packet: %s\n",
-                    esk8_err_to_str(err)
+                    "Error awaiting ps2 mvmt packet: %s, resyncs: %u, fallbacks: %u, dropped: %u\n",
+                    esk8_err_to_str(err),
+                    stats.n_resync,
+                    stats.n_fallback,
+                    stats.n_dropped
                 );
 
                 break;
             }
 
-            esk8_log_D(ESK8_TAG_RMT,
-                "PS2 says x: %03d, y: %03d, btn: %s\n",
-                mvmt.x,
-                mvmt.y,
-                mvmt.lft_btn?"Yes":"No"
+            esk8_hist_add(
+                &esk8_remote.lat[ESK8_RMT_LAT_ISR_TASK],
+                esp_timer_get_time() - mvmt.t_us
             );
 
-            esk8_remote_incr_speed(mvmt.x);
+            esk8_remote_add_mvmt(mvmt.x, mvmt.t_us);
         }
     }
 }
\ No newline at end of file
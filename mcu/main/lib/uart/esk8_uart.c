@@ -14,7 +14,7 @@ esk8_uart_regread_msg_new(
         .pld_length = 1,
         .src_address = 0x3e,
         .dst_address = dstAddr,
-        .cmd_command = 0x01,            // Read registers
+        .cmd_command = ESK8_MSG_CMD_READ,
         .cmd_argment = (uint8_t) reg,   // Reg to read
         .payload = (uint8_t*) malloc(1)
     };
@@ -62,40 +62,47 @@ esk8_uart_msg_find_header(
 {
     const static uint8_t msg_header[] = ESK8_MSG_PKT_HEADER;
 
-    if (buf_length < 2)
-        return -1;
+    const uint8_t* pos = buffer;
+    const uint8_t* end = buffer + buf_length - 1;
 
-    for(int i=0; i<buf_length-1; i++)
+    /**
+     * memchr looks at a word or more at a time,
+     * so hunt for the first header byte with it,
+     * and only then check the second one.
+     **/
+    while (pos < end)
     {
-        int memcmp_res = memcmp(
-            buffer+i,
-            msg_header,
-            2
-        );
-
-        if (memcmp_res == 0)
-            return i;
+        pos = memchr(pos, msg_header[0], end - pos);
+
+        if (!pos)
+            break;
+
+        if (pos[1] == msg_header[1])
+            return pos - buffer;
+
+        pos++;
     }
 
     return -1;
 }
 
 esk8_err_t
-esk8_uart_msg_parse(
-    uint8_t* buffer,
+esk8_uart_msg_view(
+    const uint8_t* buffer,
     size_t buf_length,
-    esk8_uart_msg_t* msgOut
+    esk8_uart_msg_t* msgOut,
+    size_t* out_end
 )
 {
     int headerIndex = esk8_uart_msg_find_header(
-        buffer,
+        (uint8_t*) buffer,
         buf_length);
 
     if (headerIndex < 0)
         return ESK8_UART_MSG_ERR_NO_HEADER;
 
-    uint8_t* msgBuffer = buffer + headerIndex;
-    uint8_t  remBufferLen = buf_length - headerIndex;
+    const uint8_t* msgBuffer = buffer + headerIndex;
+    size_t remBufferLen = buf_length - headerIndex;
 
     if (remBufferLen < ESK8_MSG_MIN_SIZE)
         return ESK8_UART_MSG_ERR_INVALID_BUFFER;
@@ -107,31 +114,110 @@ esk8_uart_msg_parse(
     esk8_uart_msg_t msgNew;
     memcpy((void*)&msgNew, msgBuffer, ESK8_MSG_HEADER_SIZE);
 
-    msgBuffer += ESK8_MSG_HEADER_SIZE;
-    remBufferLen -= ESK8_MSG_HEADER_SIZE;
-
-    if(msgNew.pld_length + 2 > remBufferLen)
+    if(msgNew.pld_length + ESK8_MSG_HEADER_SIZE + 2 > remBufferLen)
         return ESK8_UART_MSG_ERR_INVALID_PLDLEN;
 
-    msgNew.payload = (uint8_t*)malloc(msgNew.pld_length);
-    memcpy(msgNew.payload, msgBuffer, msgNew.pld_length);
+    /**
+     * The checksum covers the header fields and
+     * the payload, which are contiguous in the
+     * buffer, so it is summed right in place.
+     **/
+    uint8_t calcChkSum[2];
+    size_t  chkLen = ESK8_MSG_HEADER_SIZE + msgNew.pld_length;
+    esk8_uart_buff_chk_calc((uint8_t*) msgBuffer, chkLen, calcChkSum);
 
-    msgBuffer += msgNew.pld_length;
-    remBufferLen -= msgNew.pld_length;
-    memcpy(msgNew.chk_sum, msgBuffer, 2);
+    msgNew.payload = (uint8_t*) msgBuffer + ESK8_MSG_HEADER_SIZE;
+    memcpy(msgNew.chk_sum, msgBuffer + chkLen, 2);
 
-    esk8_err_t errCode = esk8_uart_msg_chk(msgNew);
+    if (memcmp(calcChkSum, msgNew.chk_sum, 2) != 0)
+        return ESK8_UART_MSG_ERR_INVALID_CHKSUM;
 
-    if (errCode != ESK8_OK)
-    {
-        free(msgNew.payload);
-        return errCode;
-    }
+    if (out_end)
+        (*out_end) = headerIndex + ESK8_MSG_SIZE(msgNew.pld_length);
+
+    (*msgOut) = msgNew;
+    return ESK8_OK;
+}
+
+esk8_err_t
+esk8_uart_msg_parse(
+    uint8_t* buffer,
+    size_t buf_length,
+    esk8_uart_msg_t* msgOut
+)
+{
+    esk8_uart_msg_t msgNew;
+
+    ESK8_ERRCHECK_THROW(esk8_uart_msg_view(
+        buffer,
+        buf_length,
+        &msgNew,
+        NULL));
+
+    uint8_t* payload = (uint8_t*)malloc(msgNew.pld_length);
+    if (!payload)
+        return ESK8_ERR_OOM;
+
+    memcpy(payload, msgNew.payload, msgNew.pld_length);
+    msgNew.payload = payload;
 
     (*msgOut) = msgNew;
     return ESK8_OK;
 }
 
+size_t
+esk8_uart_msg_encode(
+    esk8_uart_msg_t* msg,
+    uint8_t* buff,
+    size_t buff_len
+)
+{
+    const static uint8_t pktHeader[] = ESK8_MSG_PKT_HEADER;
+    size_t msgLen = esk8_uart_msg_get_serialized_length(*msg);
+
+    if (buff_len < msgLen)
+        return 0;
+
+    memcpy(buff, pktHeader, sizeof(pktHeader));
+    buff += sizeof(pktHeader);
+
+    uint16_t chksum = 0;
+    const uint8_t* hdr = (const uint8_t*) msg;
+
+    for (int i = 0; i < ESK8_MSG_HEADER_SIZE; i++)
+        chksum += (*buff++) = hdr[i];
+
+    for (int i = 0; i < msg->pld_length; i++)
+        chksum += (*buff++) = msg->payload[i];
+
+    chksum ^= 0xFFFF;
+    memcpy(msg->chk_sum, (void*) &chksum, 2);
+    memcpy(buff, msg->chk_sum, 2);
+
+    return msgLen;
+}
+
+size_t
+esk8_uart_regread_encode(
+    esk8_uart_addr_t dstAddr,
+    esk8_uart_reg_t reg,
+    uint8_t readLen,
+    uint8_t* buff,
+    size_t buff_len
+)
+{
+    esk8_uart_msg_t msg = {
+        .pld_length = 1,
+        .src_address = ESK8_ADDR_APP,
+        .dst_address = dstAddr,
+        .cmd_command = ESK8_MSG_CMD_READ,
+        .cmd_argment = (uint8_t) reg,   // Reg to read
+        .payload = &readLen
+    };
+
+    return esk8_uart_msg_encode(&msg, buff, buff_len);
+}
+
 size_t
 esk8_uart_msg_get_serialized_length(
     esk8_uart_msg_t msg
@@ -160,11 +246,17 @@ esk8_uart_msg_chk_calc(
     uint8_t chkSum[static 2]
 )
 {
-    size_t   buffSize = esk8_uart_msg_get_serialized_length(msg);
-    uint8_t* buffer = (uint8_t*)malloc(buffSize);
-    esk8_uart_msg_serialize(msg, buffer);
-    esk8_uart_buff_chk_calc(buffer + 2, buffSize - 4, chkSum);
-    free(buffer);
+    uint16_t chksum = 0;
+    const uint8_t* hdr = (const uint8_t*) &msg;
+
+    for (int i = 0; i < ESK8_MSG_HEADER_SIZE; i++)
+        chksum += hdr[i];
+
+    for (int i = 0; i < msg.pld_length; i++)
+        chksum += msg.payload[i];
+
+    chksum ^= 0xFFFF;
+    memcpy((void*) chkSum, (void*) &chksum, 2);
 }
 
 
@@ -190,3 +282,164 @@ esk8_uart_msg_free(
 {
     free(msg.payload);
 }
+
+
+void
+esk8_uart_dec_reset(
+    esk8_uart_dec_t* dec
+)
+{
+    dec->state      = ESK8_UART_DEC_HUNT;
+    dec->frame_len  = 0;
+    dec->frame_size = 0;
+    dec->pend_off   = 0;
+    dec->pend_len   = 0;
+}
+
+/**
+ * Drops the first byte of the frame being decoded
+ * and queues the rest to be decoded again, ahead
+ * of anything that was already pending.
+ **/
+static void
+esk8_uart_dec_resync(
+    esk8_uart_dec_t* dec
+)
+{
+    memmove(
+        dec->frame + dec->frame_len,
+        dec->frame + dec->pend_off,
+        dec->pend_len
+    );
+
+    dec->pend_len  += dec->frame_len - 1;
+    dec->pend_off   = 1;
+    dec->frame_len  = 0;
+    dec->state      = ESK8_UART_DEC_HUNT;
+}
+
+/**
+ * Runs one byte through the decoder.
+ * Returns true once the last byte of a
+ * frame is in. The checksum is not checked.
+ **/
+static bool
+esk8_uart_dec_step(
+    esk8_uart_dec_t* dec,
+    uint8_t          byte
+)
+{
+    const static uint8_t pktHeader[] = ESK8_MSG_PKT_HEADER;
+
+    switch (dec->state)
+    {
+    case ESK8_UART_DEC_HUNT:
+        if (byte != pktHeader[0])
+        {
+            dec->n_skipped++;
+            return false;
+        }
+
+        dec->frame[0]  = byte;
+        dec->frame_len = 1;
+        dec->state     = ESK8_UART_DEC_HEADER;
+        return false;
+
+    case ESK8_UART_DEC_HEADER:
+        if (byte == pktHeader[1])
+        {
+            dec->frame[dec->frame_len++] = byte;
+            dec->state = ESK8_UART_DEC_LENGTH;
+            return false;
+        }
+
+        /* The previous 0x5A was noise, but this one might not be */
+        dec->n_skipped++;
+        if (byte != pktHeader[0])
+        {
+            dec->n_skipped++;
+            dec->state = ESK8_UART_DEC_HUNT;
+        }
+        return false;
+
+    case ESK8_UART_DEC_LENGTH:
+        dec->frame[dec->frame_len++] = byte;
+        dec->frame_size = ESK8_MSG_SIZE(byte);
+        dec->state      = ESK8_UART_DEC_BODY;
+        return false;
+
+    case ESK8_UART_DEC_BODY:
+        dec->frame[dec->frame_len++] = byte;
+        return dec->frame_len == dec->frame_size;
+
+    default:
+        esk8_uart_dec_reset(dec);
+        return false;
+    }
+}
+
+esk8_err_t
+esk8_uart_dec_feed(
+    esk8_uart_dec_t* dec,
+    const uint8_t* data,
+    size_t data_len,
+    size_t* out_used,
+    esk8_uart_msg_t* outMsg
+)
+{
+    const static uint8_t pktHeader[] = ESK8_MSG_PKT_HEADER;
+    size_t used = 0;
+
+    while (dec->pend_len || used < data_len)
+    {
+        uint8_t byte;
+
+        if (dec->pend_len)
+        {
+            byte = dec->frame[dec->pend_off++];
+            dec->pend_len--;
+        }
+        else
+        {
+            /* Skip line noise in one go */
+            if (dec->state == ESK8_UART_DEC_HUNT)
+            {
+                const uint8_t* hdr = memchr(
+                    data + used, pktHeader[0], data_len - used);
+
+                size_t skip = hdr ? hdr - (data + used) : data_len - used;
+
+                dec->n_skipped += skip;
+                used += skip;
+
+                if (!hdr)
+                    break;
+            }
+
+            byte = data[used++];
+        }
+
+        if (!esk8_uart_dec_step(dec, byte))
+            continue;
+
+        dec->state = ESK8_UART_DEC_HUNT;
+
+        esk8_err_t err = esk8_uart_msg_view(
+            dec->frame,
+            dec->frame_size,
+            outMsg,
+            NULL);
+
+        if (err == ESK8_OK)
+        {
+            (*out_used) = used;
+            return ESK8_OK;
+        }
+
+        dec->n_bad_chk++;
+        esk8_uart_dec_resync(dec);
+    }
+
+    (*out_used) = used;
+    return ESK8_UART_MSG_ERR_INCOMPLETE;
+}
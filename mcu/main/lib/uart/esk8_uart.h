@@ -4,13 +4,19 @@
 #include <esk8_err.h>
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <string.h>
 #include <stdlib.h>
 
 
+#define ESK8_UART_BAUD_RATE 115200
+
+/* Time `bytes` take on the wire, 8N1 */
+#define ESK8_UART_WIRE_US(bytes) ((uint32_t)(bytes) * 10 * 1000000 / ESK8_UART_BAUD_RATE)
+
 #define ESK8_UART_CONFIG_DEFAULT_ESP32()        \
 {                                               \
-    .baud_rate = 115200,                        \
+    .baud_rate = ESK8_UART_BAUD_RATE,           \
     .data_bits = UART_DATA_8_BITS,              \
     .parity = UART_PARITY_DISABLE,              \
     .stop_bits = UART_STOP_BITS_1,              \
@@ -21,6 +27,12 @@
 #define ESK8_MSG_PKT_HEADER {0x5A, 0xA5}
 #define ESK8_MSG_HEADER_SIZE 5
 #define ESK8_MSG_MIN_SIZE 9
+#define ESK8_MSG_MAX_PLD_SIZE 0xFF
+#define ESK8_MSG_MAX_SIZE (ESK8_MSG_MIN_SIZE + ESK8_MSG_MAX_PLD_SIZE)
+#define ESK8_MSG_SIZE(pld_len) (ESK8_MSG_MIN_SIZE + (pld_len))
+
+#define ESK8_MSG_CMD_READ       0x01    /* Read registers, arg is the first one     */
+#define ESK8_MSG_CMD_READ_RSP   0x04    /* Their values, arg is the first register  */
 
 
 typedef struct esk8_uart_msg_t
@@ -55,7 +67,7 @@ typedef enum esk8_uart_reg_t
     ESK8_REG_BMS_CELL7_V     = 0x47,
     ESK8_REG_BMS_CELL8_V     = 0x48,
     ESK8_REG_BMS_CELL9_V     = 0x49,
-    ESK8_REG_BMS_MANUFACTURE_DATE    = 0x10,
+    ESK8_REG_BMS_MANUFACTURE_DATE    = 0x20,
     ESK8_REG_BMS_SERIAL_NUMBER       = 0x10,
     ESK8_REG_BMS_FW_VERSION          = 0x17,
     ESK8_REG_BMS_FACTORY_CAPACITY    = 0x18,
@@ -63,6 +75,20 @@ typedef enum esk8_uart_reg_t
     ESK8_REG_BMS_CHARGE_FULL_CYCLES  = 0x1B,
     ESK8_REG_BMS_CHARGE_COUNT        = 0x1C,
     ESK8_REG_BMS_CAPACITY_mAh        = 0x31,
+
+    /* ESC */
+    ESK8_REG_ESC_CURRENT     = 0x53,    /* Motor current, 10 mA     */
+    ESK8_REG_ESC_ERROR       = 0xB0,
+    ESK8_REG_ESC_WARNING     = 0xB1,
+    ESK8_REG_ESC_FLAGS       = 0xB2,
+    ESK8_REG_ESC_WORK_MODE   = 0xB3,
+    ESK8_REG_ESC_BATTERY     = 0xB4,    /* Percentage               */
+    ESK8_REG_ESC_SPEED       = 0xB5,    /* m/h, signed              */
+    ESK8_REG_ESC_AVG_SPEED   = 0xB6,
+    ESK8_REG_ESC_ODOMETER    = 0xB7,    /* m, 2 registers           */
+    ESK8_REG_ESC_TRIP        = 0xB9,    /* 10 m                     */
+    ESK8_REG_ESC_UPTIME      = 0xBA,    /* s                        */
+    ESK8_REG_ESC_TEMPRTR     = 0xBB,    /* 0.1 C                    */
 } esk8_uart_reg_t;
 
 
@@ -75,6 +101,38 @@ typedef enum esk8_uart_addr_t
 } esk8_uart_addr_t;
 
 
+typedef enum esk8_uart_dec_state_t
+{
+    ESK8_UART_DEC_HUNT,         /* Looking for 0x5A                         */
+    ESK8_UART_DEC_HEADER,       /* Got 0x5A, looking for 0xA5               */
+    ESK8_UART_DEC_LENGTH,       /* Got the pkt header, next is pld_length   */
+    ESK8_UART_DEC_BODY,         /* Header fields, payload and checksum      */
+} esk8_uart_dec_state_t;
+
+
+/**
+ * Incremental frame decoder.
+ * Bytes of the frame being decoded are kept
+ * in `frame`. After a checksum failure, the
+ * bytes after the bad header are kept at
+ * `frame[pend_off]` and decoded again, so a
+ * real frame hiding behind garbage is not lost.
+ **/
+typedef struct esk8_uart_dec_t
+{
+    esk8_uart_dec_state_t state;
+    uint16_t frame_len;
+    uint16_t frame_size;
+    uint16_t pend_off;
+    uint16_t pend_len;
+
+    uint32_t n_skipped;         /* Bytes dropped while hunting for a header */
+    uint32_t n_bad_chk;         /* Frames dropped on a bad checksum         */
+
+    uint8_t  frame[ESK8_MSG_MAX_SIZE];
+} esk8_uart_dec_t;
+
+
 /**
  * Finds the first msg header in `buffer`.
  * If no header is found, returns -1.
@@ -87,6 +145,97 @@ int esk8_uart_msg_find_header(
 );
 
 
+/**
+ * Finds the first valid message in
+ * `buffer`, without copying it.
+ * `outMsg->payload` points into `buffer`,
+ * so the message is only valid while
+ * `buffer` is. It must not be freed.
+ * If `out_end` is not NULL, it gets the
+ * index right after the decoded frame.
+ * No resources are allocated.
+ **/
+esk8_err_t esk8_uart_msg_view(
+
+    const uint8_t* buffer,
+    size_t buf_length,
+    esk8_uart_msg_t* outMsg,
+    size_t* out_end
+
+);
+
+
+/**
+ * Encodes `msg` into the caller owned
+ * `buff`, filling in the checksum on
+ * the way. `msg->chk_sum` is overwritten.
+ * Returns the frame length, or 0 if
+ * `buff_len` is too small.
+ * No resources are allocated.
+ **/
+size_t esk8_uart_msg_encode(
+
+    esk8_uart_msg_t* msg,
+    uint8_t* buff,
+    size_t buff_len
+
+);
+
+
+/**
+ * Encodes a register read request
+ * straight into `buff`. `buff` needs
+ * `ESK8_MSG_SIZE(1)` bytes.
+ * Returns the frame length, or 0 if
+ * `buff_len` is too small.
+ **/
+size_t esk8_uart_regread_encode(
+
+    esk8_uart_addr_t dstAddr,
+    esk8_uart_reg_t reg,
+    uint8_t readLen,
+    uint8_t* buff,
+    size_t buff_len
+
+);
+
+
+/**
+ * Clears the decoder state, including
+ * any pending bytes. Counters are kept.
+ **/
+void esk8_uart_dec_reset(
+
+    esk8_uart_dec_t* dec
+
+);
+
+
+/**
+ * Feeds `data` into the decoder, one byte
+ * at a time, and stops right after the last
+ * byte of a valid frame.
+ * `out_used` gets how many bytes of `data`
+ * were consumed.
+ * Returns `ESK8_OK` if `outMsg` holds a
+ * frame, or `ESK8_UART_MSG_ERR_INCOMPLETE`
+ * once all of `data` was used up.
+ * `outMsg->payload` points into the decoder,
+ * and is valid until the next call.
+ * After a frame, call again (even with no
+ * data left) until it returns incomplete.
+ **/
+esk8_err_t esk8_uart_dec_feed(
+
+    esk8_uart_dec_t* dec,
+    const uint8_t* data,
+    size_t data_len,
+    size_t* out_used,
+    esk8_uart_msg_t* outMsg
+
+);
+
+
 /**
  * Creates a new message from a
  * `uint8_t` buffer.
@@ -0,0 +1,530 @@
+#include <esk8_err.h>
+#include <esk8_uart.h>
+#include <esk8_uart_port.h>
+#include <esk8_uart_bus.h>
+
+#include <esp_timer.h>
+#include <driver/uart.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+
+#define NO_OWNER   (-1)
+#define NO_PIN     (-1)
+
+
+typedef struct
+{
+    esk8_uart_bus_stats_t   stats;
+    void*                   grant;      /* Given when the bus is handed over */
+
+    /* While waiting */
+    bool                    waiting;
+    uint8_t                 prio;
+    int64_t                 deadline_us;
+    uint32_t                seq;
+}
+esk8_uart_bus_client_t;
+
+typedef struct
+{
+    int                     refs;
+    esk8_uart_port_t        port;
+    int                     tx_pin;
+    int                     rx_pin;
+
+    /* Everything below is under `lock` */
+    void*                   lock;
+    int                     owner;
+    int64_t                 owned_us;   /* When `owner` got the bus */
+    bool                    listening;  /* `owner` only listens, wake it for others */
+    uint32_t                seq;
+
+    uint8_t                 client_num;
+    esk8_uart_bus_client_t  clients[ESK8_UART_BUS_MAX_CLIENTS];
+}
+esk8_uart_bus_hndl_def_t;
+
+static esk8_uart_bus_hndl_def_t* esk8_uart_buses[UART_NUM_MAX] = { 0 };
+
+
+/**
+ * Whether `client` was added, and not removed.
+ **/
+static bool
+bus_client_ok(
+    esk8_uart_bus_hndl_def_t* bus,
+    uint8_t                   client
+)
+{
+    return bus && client < bus->client_num && bus->clients[client].grant;
+}
+
+
+esk8_err_t
+esk8_uart_bus_open(
+    int                   uart_port,
+    int                   tx_pin,
+    int                   rx_pin,
+    size_t                buff_size,
+    int                   evt_queue_len,
+    esk8_uart_bus_hndl_t* out_bus
+)
+{
+    esk8_err_t err;
+
+    if (uart_port < 0 || uart_port >= UART_NUM_MAX)
+        return ESK8_ERR_INVALID_PARAM;
+
+    esk8_uart_bus_hndl_def_t* bus = esk8_uart_buses[uart_port];
+
+    if (bus)
+    {
+        bus->refs++;
+        (*out_bus) = bus;
+        return ESK8_OK;
+    }
+
+    bus = calloc(1, sizeof(esk8_uart_bus_hndl_def_t));
+    if (!bus)
+        return ESK8_ERR_OOM;
+
+    bus->refs   = 1;
+    bus->owner  = NO_OWNER;
+    bus->tx_pin = tx_pin;
+    bus->rx_pin = rx_pin;
+    bus->lock   = xSemaphoreCreateMutex();
+
+    if (!bus->lock)
+    {
+        free(bus);
+        return ESK8_ERR_OOM;
+    }
+
+    err = esk8_uart_port_init(
+        &bus->port,
+        uart_port,
+        tx_pin,
+        rx_pin,
+        buff_size,
+        evt_queue_len
+    );
+
+    if (err)
+    {
+        esk8_uart_port_deinit(&bus->port);
+        vSemaphoreDelete(bus->lock);
+        free(bus);
+        return err;
+    }
+
+    esk8_uart_buses[uart_port] = bus;
+    (*out_bus) = bus;
+    return ESK8_OK;
+}
+
+void
+esk8_uart_bus_close(
+    esk8_uart_bus_hndl_t hndl
+)
+{
+    esk8_uart_bus_hndl_def_t* bus = (esk8_uart_bus_hndl_def_t*)hndl;
+
+    if (!bus || --bus->refs > 0)
+        return;
+
+    esk8_uart_buses[bus->port.uart_port] = NULL;
+    esk8_uart_port_deinit(&bus->port);
+
+    for (int c = 0; c < bus->client_num; c++)
+    {
+        if (bus->clients[c].grant)
+            vSemaphoreDelete(bus->clients[c].grant);
+    }
+
+    vSemaphoreDelete(bus->lock);
+    free(bus);
+}
+
+esk8_err_t
+esk8_uart_bus_client_add(
+    esk8_uart_bus_hndl_t hndl,
+    const char*          name,
+    uint8_t*             out_client
+)
+{
+    esk8_uart_bus_hndl_def_t* bus = (esk8_uart_bus_hndl_def_t*)hndl;
+    esk8_err_t err = ESK8_OK;
+
+    xSemaphoreTake(bus->lock, portMAX_DELAY);
+
+    /* The slot of a removed client first */
+    uint8_t c = 0;
+    while (c < bus->client_num && bus->clients[c].grant)
+        c++;
+
+    if (c == ESK8_UART_BUS_MAX_CLIENTS)
+    {
+        err = ESK8_ERR_OOM;
+        goto done;
+    }
+
+    esk8_uart_bus_client_t* client = &bus->clients[c];
+
+    memset(client, 0, sizeof(esk8_uart_bus_client_t));
+    client->grant = xSemaphoreCreateBinary();
+
+    if (!client->grant)
+    {
+        err = ESK8_ERR_OOM;
+        goto done;
+    }
+
+    client->stats.name     = name;
+    client->stats.since_us = esp_timer_get_time();
+
+    (*out_client) = c;
+
+    if (c == bus->client_num)
+        bus->client_num++;
+
+done:
+    xSemaphoreGive(bus->lock);
+    return err;
+}
+
+esk8_err_t
+esk8_uart_bus_client_remove(
+    esk8_uart_bus_hndl_t hndl,
+    uint8_t              client
+)
+{
+    esk8_uart_bus_hndl_def_t* bus = (esk8_uart_bus_hndl_def_t*)hndl;
+    esk8_err_t err = ESK8_OK;
+
+    if (!bus)
+        return ESK8_ERR_INVALID_PARAM;
+
+    xSemaphoreTake(bus->lock, portMAX_DELAY);
+
+    if  (
+            !bus_client_ok(bus, client) ||
+            bus->owner == client ||
+            bus->clients[client].waiting
+        )
+    {
+        err = ESK8_ERR_INVALID_PARAM;
+        goto done;
+    }
+
+    vSemaphoreDelete(bus->clients[client].grant);
+    memset(&bus->clients[client], 0, sizeof(esk8_uart_bus_client_t));
+
+    while (bus->client_num && !bus->clients[bus->client_num - 1].grant)
+        bus->client_num--;
+
+done:
+    xSemaphoreGive(bus->lock);
+    return err;
+}
+
+/**
+ * Whether waiting client `a` goes before `b`.
+ **/
+static bool
+bus_before(
+    const esk8_uart_bus_client_t* a,
+    const esk8_uart_bus_client_t* b
+)
+{
+    if (a->prio != b->prio)
+        return a->prio < b->prio;
+
+    int64_t da = a->deadline_us ? a->deadline_us : INT64_MAX;
+    int64_t db = b->deadline_us ? b->deadline_us : INT64_MAX;
+
+    if (da != db)
+        return da < db;
+
+    /* Wraps after 4 billion transactions, which only skews one comparison */
+    return (int32_t)(a->seq - b->seq) < 0;
+}
+
+/**
+ * Gives the bus to `client`. Call with the lock held.
+ **/
+static void
+bus_grant(
+    esk8_uart_bus_hndl_def_t* bus,
+    int                       client,
+    int64_t                   now_us
+)
+{
+    bus->owner     = client;
+    bus->owned_us  = now_us;
+    bus->listening = false;
+}
+
+/**
+ * Waits until `client` owns the bus, or
+ * until `deadline_us` has passed.
+ **/
+static esk8_err_t
+bus_acquire(
+    esk8_uart_bus_hndl_def_t* bus,
+    uint8_t                   client_idx,
+    uint8_t                   prio,
+    int64_t                   deadline_us
+)
+{
+    esk8_uart_bus_client_t* client = &bus->clients[client_idx];
+    int64_t start_us = esp_timer_get_time();
+
+    if (deadline_us && deadline_us < start_us)
+    {
+        xSemaphoreTake(bus->lock, portMAX_DELAY);
+        client->stats.n_missed++;
+        xSemaphoreGive(bus->lock);
+
+        return ESK8_UART_ERR_DEADLINE;
+    }
+
+    xSemaphoreTake(bus->lock, portMAX_DELAY);
+
+    if (bus->owner == NO_OWNER)
+    {
+        bus_grant(bus, client_idx, start_us);
+        xSemaphoreGive(bus->lock);
+        return ESK8_OK;
+    }
+
+    client->waiting     = true;
+    client->prio        = prio;
+    client->deadline_us = deadline_us;
+    client->seq         = bus->seq++;
+
+    if (bus->listening)
+        esk8_uart_port_wake(&bus->port);
+
+    xSemaphoreGive(bus->lock);
+
+    TickType_t wait = portMAX_DELAY;
+
+    /* Rounded up, and a tick more, as the current tick is partly gone */
+    if (deadline_us)
+        wait = (deadline_us - start_us + portTICK_PERIOD_MS * 1000 - 1) / (portTICK_PERIOD_MS * 1000) + 1;
+
+    bool granted = xSemaphoreTake(client->grant, wait) == pdTRUE;
+    int64_t now_us = esp_timer_get_time();
+
+    xSemaphoreTake(bus->lock, portMAX_DELAY);
+
+    /* The bus may have been handed over right as we gave up */
+    if (!granted && bus->owner == client_idx)
+        granted = xSemaphoreTake(client->grant, 0) == pdTRUE;
+
+    uint32_t waited_us = now_us - start_us;
+    client->waiting = false;
+    client->stats.wait_us += waited_us;
+
+    if (waited_us > client->stats.wait_max_us)
+        client->stats.wait_max_us = waited_us;
+
+    if (!granted)
+        client->stats.n_missed++;
+
+    xSemaphoreGive(bus->lock);
+
+    return granted ? ESK8_OK : ESK8_UART_ERR_DEADLINE;
+}
+
+/**
+ * Hands the bus to the waiting client that
+ * goes first, or frees it.
+ **/
+static void
+bus_release(
+    esk8_uart_bus_hndl_def_t* bus,
+    uint8_t                   client_idx
+)
+{
+    int64_t now_us = esp_timer_get_time();
+    int next = NO_OWNER;
+
+    xSemaphoreTake(bus->lock, portMAX_DELAY);
+
+    esk8_uart_bus_stats_t* stats = &bus->clients[client_idx].stats;
+
+    if (bus->listening)
+    {
+        stats->listen_us += now_us - bus->owned_us;
+    }
+    else
+    {
+        stats->busy_us += now_us - bus->owned_us;
+        stats->n_trx++;
+    }
+
+    for (int c = 0; c < bus->client_num; c++)
+    {
+        esk8_uart_bus_client_t* client = &bus->clients[c];
+
+        /* Those past their deadline are giving up, do not wait on them */
+        if  (
+                !client->waiting ||
+                (client->deadline_us && client->deadline_us < now_us)
+            )
+            continue;
+
+        if (next == NO_OWNER || bus_before(client, &bus->clients[next]))
+            next = c;
+    }
+
+    bus_grant(bus, next, now_us);
+
+    if (next != NO_OWNER)
+    {
+        bus->clients[next].waiting = false;
+        xSemaphoreGive(bus->clients[next].grant);
+    }
+
+    xSemaphoreGive(bus->lock);
+}
+
+/**
+ * Points the port at the pins given,
+ * unless it already is. Call as owner.
+ **/
+static esk8_err_t
+bus_set_pins(
+    esk8_uart_bus_hndl_def_t* bus,
+    int                       tx_pin,
+    int                       rx_pin
+)
+{
+    if (bus->tx_pin == tx_pin && bus->rx_pin == rx_pin)
+        return ESK8_OK;
+
+    esk8_err_t err = esk8_uart_port_set_pins(&bus->port, tx_pin, rx_pin);
+
+    bus->tx_pin = err ? NO_PIN : tx_pin;
+    bus->rx_pin = err ? NO_PIN : rx_pin;
+
+    return err;
+}
+
+esk8_err_t
+esk8_uart_bus_regread(
+    esk8_uart_bus_hndl_t    hndl,
+    uint8_t                 client,
+    const esk8_uart_trx_t*  trx,
+    void*                   out_val,
+    uint32_t*               out_rtt_us
+)
+{
+    esk8_uart_bus_hndl_def_t* bus = (esk8_uart_bus_hndl_def_t*)hndl;
+    esk8_err_t err = ESK8_BMS_ERR_NO_RESPONSE;
+
+    if (!bus_client_ok(bus, client))
+        return ESK8_ERR_INVALID_PARAM;
+
+    if (out_rtt_us)
+        (*out_rtt_us) = 0;
+
+    for (int try = 0; try < trx->tries; try++)
+    {
+        ESK8_ERRCHECK_THROW(bus_acquire(
+            bus, client, trx->prio, trx->deadline_us
+        ));
+
+        /* Only the owner touches the port */
+        err = bus_set_pins(bus, trx->tx_pin, trx->rx_pin);
+
+        if (err == ESK8_OK)
+        {
+            err = esk8_uart_port_regread(
+                &bus->port,
+                trx->dst_addr,
+                trx->reg,
+                trx->reg_size,
+                out_val,
+                1, trx->timeout_us,
+                try ? NULL : out_rtt_us
+            );
+        }
+
+        bus_release(bus, client);
+
+        if (err == ESK8_OK)
+            break;
+    }
+
+    return err;
+}
+
+esk8_err_t
+esk8_uart_bus_listen(
+    esk8_uart_bus_hndl_t hndl,
+    uint8_t              client,
+    int                  tx_pin,
+    int                  rx_pin,
+    uint32_t             listen_us,
+    esk8_uart_frame_cb_t cb,
+    void*                ctx
+)
+{
+    esk8_uart_bus_hndl_def_t* bus = (esk8_uart_bus_hndl_def_t*)hndl;
+
+    if (!bus_client_ok(bus, client))
+        return ESK8_ERR_INVALID_PARAM;
+
+    ESK8_ERRCHECK_THROW(bus_acquire(bus, client, ESK8_UART_PRIO_IDLE, 0));
+
+    esk8_err_t err = bus_set_pins(bus, tx_pin, rx_pin);
+    bool others = false;
+
+    xSemaphoreTake(bus->lock, portMAX_DELAY);
+
+    /* Anyone who came while we set up missed the wake up */
+    for (int c = 0; c < bus->client_num; c++)
+        others |= bus->clients[c].waiting;
+
+    bus->listening = true;
+    xSemaphoreGive(bus->lock);
+
+    if (err == ESK8_OK && !others)
+        err = esk8_uart_port_listen(&bus->port, esp_timer_get_time() + listen_us, cb, ctx);
+
+    bus_release(bus, client);
+    return err;
+}
+
+esk8_err_t
+esk8_uart_bus_get_stats(
+    esk8_uart_bus_hndl_t   hndl,
+    uint8_t                client,
+    esk8_uart_bus_stats_t* out_stats
+)
+{
+    esk8_uart_bus_hndl_def_t* bus = (esk8_uart_bus_hndl_def_t*)hndl;
+
+    if (!bus_client_ok(bus, client))
+        return ESK8_ERR_INVALID_PARAM;
+
+    xSemaphoreTake(bus->lock, portMAX_DELAY);
+    (*out_stats) = bus->clients[client].stats;
+    xSemaphoreGive(bus->lock);
+
+    return ESK8_OK;
+}
+
+uint8_t
+esk8_uart_bus_client_num(
+    esk8_uart_bus_hndl_t hndl
+)
+{
+    esk8_uart_bus_hndl_def_t* bus = (esk8_uart_bus_hndl_def_t*)hndl;
+
+    return bus ? bus->client_num : 0;
+}
@@ -0,0 +1,198 @@
+#ifndef _ESK8_UART_BUS_H
+#define _ESK8_UART_BUS_H
+
+#include <esk8_err.h>
+#include <esk8_uart.h>
+#include <esk8_uart_port.h>
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define ESK8_UART_BUS_MAX_CLIENTS 8
+
+
+/**
+ * Who gets the bus first, when several
+ * clients wait for it. Lower goes first.
+ **/
+typedef enum
+{
+    ESK8_UART_PRIO_CONTROL,     /* Telemetry the ride depends on, like the ESC  */
+    ESK8_UART_PRIO_TELEMETRY,   /* Values that change every second              */
+    ESK8_UART_PRIO_BULK,        /* Slow sweeps, identities, cell voltages       */
+    ESK8_UART_PRIO_IDLE,        /* Listening to others, when nobody else waits  */
+
+    ESK8_UART_PRIO_MAX
+}
+esk8_uart_prio_t;
+
+/**
+ * One register read, as queued on a bus.
+ * Each try is a transaction of its own, so a
+ * more urgent client may get the bus between
+ * tries. `deadline_us` is the latest
+ * `esp_timer_get_time()` at which a try may
+ * still get the bus, 0 for none. Within a
+ * priority class, the earliest deadline goes
+ * first.
+ **/
+typedef struct
+{
+    uint8_t             prio;           /* esk8_uart_prio_t */
+    int64_t             deadline_us;
+    int                 tx_pin;
+    int                 rx_pin;
+    esk8_uart_addr_t    dst_addr;
+    esk8_uart_reg_t     reg;
+    size_t              reg_size;
+    int                 tries;
+    uint32_t            timeout_us;     /* Per try, see `esk8_uart_port_regread()` */
+}
+esk8_uart_trx_t;
+
+/**
+ * Bus use of one client, since it was added.
+ **/
+typedef struct
+{
+    const char*         name;
+    int64_t             since_us;       /* When the client was added            */
+    uint64_t            busy_us;        /* Time holding the bus, to transact    */
+    uint64_t            listen_us;      /* Time holding it, to listen           */
+    uint64_t            wait_us;        /* Time waiting for it                  */
+    uint32_t            wait_max_us;
+    uint32_t            n_trx;          /* Transactions that got the bus        */
+    uint32_t            n_missed;       /* Gave up waiting, past their deadline */
+}
+esk8_uart_bus_stats_t;
+
+typedef void*
+esk8_uart_bus_hndl_t;
+
+
+/**
+ * Opens the bus on `uart_port`, installing its
+ * driver on `tx_pin` and `rx_pin` if nobody opened
+ * it before. Otherwise the open bus is shared,
+ * and the other arguments are ignored.
+ * Opening and closing is not thread safe, do it
+ * all from one task, at init.
+ **/
+esk8_err_t esk8_uart_bus_open(
+
+    int uart_port,
+    int tx_pin,
+    int rx_pin,
+    size_t buff_size,
+    int evt_queue_len,
+    esk8_uart_bus_hndl_t* out_bus
+
+);
+
+
+/**
+ * Drops a reference to `bus`. The last one
+ * uninstalls the driver. Clients of the
+ * closing user must be idle.
+ **/
+void esk8_uart_bus_close(
+
+    esk8_uart_bus_hndl_t bus
+
+);
+
+
+/**
+ * Adds a client called `name` to `bus`.
+ * A client may have a single transaction in
+ * flight, so give each task its own clients.
+ * Returns `ESK8_ERR_OOM` once the bus has
+ * `ESK8_UART_BUS_MAX_CLIENTS`.
+ **/
+esk8_err_t esk8_uart_bus_client_add(
+
+    esk8_uart_bus_hndl_t bus,
+    const char* name,
+    uint8_t* out_client
+
+);
+
+
+/**
+ * Removes `client` from `bus`, its slot goes
+ * to the next client added. It must be idle,
+ * with no transaction in flight.
+ **/
+esk8_err_t esk8_uart_bus_client_remove(
+
+    esk8_uart_bus_hndl_t bus,
+    uint8_t client
+
+);
+
+
+/**
+ * Reads `trx->reg_size` bytes from `trx->reg`
+ * into `out_val`, on the pins of `trx`.
+ * Waits for the bus before each try, in
+ * priority, then deadline, order. Returns
+ * `ESK8_UART_ERR_DEADLINE` when a try could
+ * not get the bus in time. `out_rtt_us` is
+ * as in `esk8_uart_port_regread()`.
+ **/
+esk8_err_t esk8_uart_bus_regread(
+
+    esk8_uart_bus_hndl_t bus,
+    uint8_t client,
+    const esk8_uart_trx_t* trx,
+    void* out_val,
+    uint32_t* out_rtt_us
+
+);
+
+
+/**
+ * Listens on the pins given, for up to
+ * `listen_us`, handing each frame heard to
+ * `cb`. Gets the bus at `ESK8_UART_PRIO_IDLE`,
+ * and gives it up as soon as anyone else
+ * wants it, so listening never delays others
+ * by more than a frame.
+ **/
+esk8_err_t esk8_uart_bus_listen(
+
+    esk8_uart_bus_hndl_t bus,
+    uint8_t client,
+    int tx_pin,
+    int rx_pin,
+    uint32_t listen_us,
+    esk8_uart_frame_cb_t cb,
+    void* ctx
+
+);
+
+
+/**
+ * Copies the bus use of `client`.
+ **/
+esk8_err_t esk8_uart_bus_get_stats(
+
+    esk8_uart_bus_hndl_t bus,
+    uint8_t client,
+    esk8_uart_bus_stats_t* out_stats
+
+);
+
+
+/**
+ * Number of clients on `bus`, for walking
+ * their stats.
+ **/
+uint8_t esk8_uart_bus_client_num(
+
+    esk8_uart_bus_hndl_t bus
+
+);
+
+
+#endif /* _ESK8_UART_BUS_H */
@@ -0,0 +1,453 @@
+#include <esk8_err.h>
+#include <esk8_uart.h>
+#include <esk8_uart_port.h>
+
+#include <esp_err.h>
+#include <esp_timer.h>
+#include <driver/uart.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+
+#define RX_CHUNK_SIZE 64 // Bytes moved out of the driver at a time
+
+
+esk8_err_t
+esk8_uart_port_init(
+    esk8_uart_port_t* port,
+    int               uart_port,
+    int               tx_pin,
+    int               rx_pin,
+    size_t            buff_size,
+    int               evt_queue_len
+)
+{
+    esp_err_t err;
+    uart_config_t uart_cnfg = ESK8_UART_CONFIG_DEFAULT_ESP32();
+
+    port->uart_port = uart_port;
+    port->evt_queue = NULL;
+    port->evt_set   = NULL;
+    port->wake_sem  = NULL;
+    esk8_uart_dec_reset(&port->dec);
+
+    err = uart_param_config(
+        uart_port,
+        &uart_cnfg
+    );
+
+    if (err)
+        return ESK8_ERR_INVALID_PARAM;
+
+    err = uart_set_pin(
+        uart_port,
+        tx_pin,
+        rx_pin,
+        UART_PIN_NO_CHANGE,
+        UART_PIN_NO_CHANGE
+    );
+
+    if (err)
+        return ESK8_ERR_INVALID_PARAM;
+
+    /**
+     * The driver event queue tells us as soon
+     * as bytes arrive, so responses can be decoded
+     * while they come in.
+     */
+    err = uart_driver_install(
+        uart_port,
+        buff_size,
+        0, evt_queue_len,
+        (QueueHandle_t*) &port->evt_queue, 0
+    );
+
+    if (err)
+        return ESK8_ERR_INVALID_PARAM;
+
+    /**
+     * Listens wait on the driver events and on
+     * our own wake up at once, through a set
+     * with room for every event of both.
+     */
+    port->wake_sem = xSemaphoreCreateBinary();
+    port->evt_set  = xQueueCreateSet(evt_queue_len + 1);
+
+    if (!port->wake_sem || !port->evt_set)
+        return ESK8_ERR_OOM;
+
+    if  (
+            xQueueAddToSet(port->evt_queue, port->evt_set) != pdPASS ||
+            xQueueAddToSet(port->wake_sem, port->evt_set) != pdPASS
+        )
+        return ESK8_ERR_INVALID_PARAM;
+
+    return ESK8_OK;
+}
+
+/**
+ * Waits up to `wait` ticks for the next driver
+ * event, into `out_evt`, or for a wake up, which
+ * sets `out_woken`. Returns false on neither.
+ * Events are only taken off the driver queue
+ * once the set hands it out, so the two never
+ * disagree on what is left.
+ **/
+static bool
+next_event(
+    esk8_uart_port_t* port,
+    TickType_t        wait,
+    uart_event_t*     out_evt,
+    bool*             out_woken
+)
+{
+    QueueSetMemberHandle_t member = xQueueSelectFromSet(port->evt_set, wait);
+
+    (*out_woken) = false;
+
+    if (member == port->wake_sem)
+    {
+        xSemaphoreTake(port->wake_sem, 0);
+        (*out_woken) = true;
+        return true;
+    }
+
+    return member == port->evt_queue && xQueueReceive(port->evt_queue, out_evt, 0) == pdTRUE;
+}
+
+/**
+ * Drops every byte and event the driver holds,
+ * and restarts the decoder. Returns whether a
+ * wake up was among them.
+ **/
+static bool
+drop_input(
+    esk8_uart_port_t* port
+)
+{
+    uart_event_t evt;
+    bool woken = false;
+    bool evt_woken;
+
+    uart_flush_input(port->uart_port);
+
+    while (next_event(port, 0, &evt, &evt_woken))
+        woken |= evt_woken;
+
+    esk8_uart_dec_reset(&port->dec);
+    return woken;
+}
+
+esk8_err_t
+esk8_uart_port_set_pins(
+    esk8_uart_port_t* port,
+    int               tx_pin,
+    int               rx_pin
+)
+{
+    esp_err_t err = uart_set_pin(
+        port->uart_port,
+        tx_pin,
+        rx_pin,
+        UART_PIN_NO_CHANGE,
+        UART_PIN_NO_CHANGE
+    );
+
+    if (err)
+        return ESK8_ERR_INVALID_PARAM;
+
+    drop_input(port);
+    return ESK8_OK;
+}
+
+void
+esk8_uart_port_deinit(
+    esk8_uart_port_t* port
+)
+{
+    if (port->evt_queue)
+        uart_driver_delete(port->uart_port);
+
+    if (port->evt_set)
+        vQueueDelete(port->evt_set);
+
+    if (port->wake_sem)
+        vSemaphoreDelete(port->wake_sem);
+
+    port->evt_queue = NULL;
+    port->evt_set   = NULL;
+    port->wake_sem  = NULL;
+}
+
+/**
+ * Waits for the response to a register read,
+ * decoding bytes as the driver reports them.
+ * Returns as soon as the last byte of the
+ * expected frame is in, or once `deadline_us`
+ * has passed.
+ **/
+static esk8_err_t
+await_response(
+    esk8_uart_port_t*    port,
+    esk8_uart_addr_t     dst_addr,
+    esk8_uart_reg_t      reg,
+    size_t               reg_size,
+    void                 *out_val,
+    int64_t              deadline_us
+)
+{
+    esk8_err_t err = ESK8_BMS_ERR_NO_RESPONSE;
+    esk8_uart_dec_t* dec = &port->dec;
+
+    uint32_t bad_chk = dec->n_bad_chk;
+
+    while (1)
+    {
+        uart_event_t evt;
+        bool woken;
+        int64_t left_us = deadline_us - esp_timer_get_time();
+
+        if (left_us <= 0)
+            return err;
+
+        /* Round up, timeouts are often shorter than a tick */
+        TickType_t wait = (left_us + portTICK_PERIOD_MS * 1000 - 1) / (portTICK_PERIOD_MS * 1000);
+
+        if (!next_event(port, wait, &evt, &woken))
+            return err;
+
+        /* Only listens return early */
+        if (woken)
+            continue;
+
+        if  (
+                evt.type == UART_FIFO_OVF ||
+                evt.type == UART_BUFFER_FULL
+            )
+        {
+            drop_input(port);
+            err = ESK8_BMS_ERR_INVALID_LEN;
+            continue;
+        }
+
+        if (evt.type != UART_DATA)
+            continue;
+
+        while (evt.size > 0)
+        {
+            uint8_t rx_buf[RX_CHUNK_SIZE];
+            size_t  rx_off = 0;
+
+            int rx_len = uart_read_bytes(
+                port->uart_port,
+                rx_buf,
+                evt.size < sizeof(rx_buf) ? evt.size : sizeof(rx_buf),
+                0);
+
+            if (rx_len <= 0)
+                break;
+
+            evt.size -= rx_len;
+
+            while (1)
+            {
+                size_t used;
+                esk8_uart_msg_t rspMsg;
+
+                esk8_err_t dec_err = esk8_uart_dec_feed(
+                    dec,
+                    rx_buf + rx_off,
+                    rx_len - rx_off,
+                    &used,
+                    &rspMsg);
+
+                rx_off += used;
+
+                if (dec_err != ESK8_OK)
+                    break;
+
+                /* Our own request echoed back, or someone else's traffic */
+                if (rspMsg.src_address != dst_addr)
+                {
+                    if (rspMsg.src_address != ESK8_ADDR_APP)
+                        err = ESK8_BMS_ERR_WRONG_ADDRESS;
+                    continue;
+                }
+
+                if  (
+                        rspMsg.cmd_argment != reg ||
+                        rspMsg.pld_length != reg_size
+                    )
+                {
+                    err = ESK8_BMS_ERR_WRONG_RESPONSE;
+                    continue;
+                }
+
+                memcpy(out_val, rspMsg.payload, reg_size);
+                return ESK8_OK;
+            }
+        }
+
+        if (dec->n_bad_chk != bad_chk)
+            err = ESK8_UART_MSG_ERR_INVALID_CHKSUM;
+        else if (err == ESK8_BMS_ERR_NO_RESPONSE && dec->state != ESK8_UART_DEC_HUNT)
+            err = ESK8_BMS_ERR_INVALID_LEN;
+    }
+}
+
+
+esk8_err_t
+esk8_uart_port_regread(
+    esk8_uart_port_t* port,
+    esk8_uart_addr_t  dst_addr,
+    esk8_uart_reg_t   reg,
+    size_t            reg_size,
+    void              *out_val,
+    int               tries,
+    uint32_t          timeout_us,
+    uint32_t*         out_rtt_us
+)
+{
+    esk8_err_t err = ESK8_BMS_ERR_NO_RESPONSE;
+    uint8_t req_buf[ESK8_MSG_SIZE(1)];
+
+    size_t req_len = esk8_uart_regread_encode(
+        dst_addr,
+        reg,
+        reg_size,
+        req_buf,
+        sizeof(req_buf)
+    );
+
+    /* The request is a few bytes, give it a tick on top of its wire time */
+    TickType_t tx_wait = ESK8_UART_WIRE_US(req_len) / (portTICK_PERIOD_MS * 1000) + 2;
+
+    if (out_rtt_us)
+        (*out_rtt_us) = 0;
+
+    int retries = 0;
+    while(retries++ < tries)
+    {
+        // Discard anything left over from an earlier request
+        drop_input(port);
+
+        uart_write_bytes(
+            port->uart_port,
+            (const char*) req_buf,
+            req_len
+        );
+
+        uart_wait_tx_done(
+            port->uart_port,
+            tx_wait
+        );
+
+        int64_t sent_us = esp_timer_get_time();
+
+        err = await_response(
+            port,
+            dst_addr,
+            reg,
+            reg_size,
+            out_val,
+            sent_us + timeout_us
+        );
+
+        if (err == ESK8_OK)
+        {
+            if (out_rtt_us && retries == 1)
+                (*out_rtt_us) = esp_timer_get_time() - sent_us;
+
+            break;
+        }
+    }
+
+    return err;
+}
+
+esk8_err_t
+esk8_uart_port_listen(
+    esk8_uart_port_t*    port,
+    int64_t              until_us,
+    esk8_uart_frame_cb_t cb,
+    void*                ctx
+)
+{
+    esk8_uart_dec_t* dec = &port->dec;
+
+    while (1)
+    {
+        uart_event_t evt;
+        bool woken;
+        int64_t left_us = until_us - esp_timer_get_time();
+
+        if (left_us <= 0)
+            return ESK8_OK;
+
+        TickType_t wait = (left_us + portTICK_PERIOD_MS * 1000 - 1) / (portTICK_PERIOD_MS * 1000);
+
+        if (!next_event(port, wait, &evt, &woken) || woken)
+            return ESK8_OK;
+
+        if  (
+                evt.type == UART_FIFO_OVF ||
+                evt.type == UART_BUFFER_FULL
+            )
+        {
+            if (drop_input(port))
+                return ESK8_OK;
+
+            continue;
+        }
+
+        if (evt.type != UART_DATA)
+            continue;
+
+        while (evt.size > 0)
+        {
+            uint8_t rx_buf[RX_CHUNK_SIZE];
+            size_t  rx_off = 0;
+
+            int rx_len = uart_read_bytes(
+                port->uart_port,
+                rx_buf,
+                evt.size < sizeof(rx_buf) ? evt.size : sizeof(rx_buf),
+                0);
+
+            if (rx_len <= 0)
+                break;
+
+            evt.size -= rx_len;
+
+            while (1)
+            {
+                size_t used;
+                esk8_uart_msg_t msg;
+
+                esk8_err_t dec_err = esk8_uart_dec_feed(
+                    dec,
+                    rx_buf + rx_off,
+                    rx_len - rx_off,
+                    &used,
+                    &msg);
+
+                rx_off += used;
+
+                if (dec_err != ESK8_OK)
+                    break;
+
+                cb(&msg, ctx);
+            }
+        }
+    }
+}
+
+void
+esk8_uart_port_wake(
+    esk8_uart_port_t* port
+)
+{
+    xSemaphoreGive(port->wake_sem);
+}
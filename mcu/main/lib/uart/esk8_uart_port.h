@@ -0,0 +1,136 @@
+#ifndef _ESK8_UART_PORT_H
+#define _ESK8_UART_PORT_H
+
+#include <esk8_err.h>
+#include <esk8_uart.h>
+
+#include <stdint.h>
+#include <stddef.h>
+
+
+/**
+ * A hardware UART running the Ninebot protocol,
+ * with its driver event queue and decoder.
+ * One task at a time may use a port.
+ * `evt_set` holds the driver queue and the
+ * private `wake_sem`, so listens wait on both.
+ **/
+typedef struct
+{
+    int                 uart_port;
+    void*               evt_queue;
+    void*               evt_set;
+    void*               wake_sem;
+    esk8_uart_dec_t     dec;
+}
+esk8_uart_port_t;
+
+
+/**
+ * Called with each valid frame heard while
+ * listening. `msg->payload` is only valid
+ * during the call.
+ **/
+typedef void (*esk8_uart_frame_cb_t)(const esk8_uart_msg_t* msg, void* ctx);
+
+
+/**
+ * Configures `uart_port` on `tx_pin` and `rx_pin`
+ * and installs its driver, with `buff_size` bytes
+ * of rx buffer and `evt_queue_len` driver events.
+ **/
+esk8_err_t esk8_uart_port_init(
+
+    esk8_uart_port_t* port,
+    int uart_port,
+    int tx_pin,
+    int rx_pin,
+    size_t buff_size,
+    int evt_queue_len
+
+);
+
+
+/**
+ * Moves `port` to other pins. Bytes heard
+ * on the old ones are dropped.
+ **/
+esk8_err_t esk8_uart_port_set_pins(
+
+    esk8_uart_port_t* port,
+    int tx_pin,
+    int rx_pin
+
+);
+
+
+/**
+ * Uninstalls the driver of `port`.
+ **/
+void esk8_uart_port_deinit(
+
+    esk8_uart_port_t* port
+
+);
+
+
+/**
+ * Reads `reg_size` bytes from `reg` on the
+ * device at `dst_addr`, into `out_val`.
+ * Each try waits up to `timeout_us` for the
+ * reply once the request is out, decoding
+ * bytes as they come in, and there are up
+ * to `tries` of them.
+ * If `out_rtt_us` is not NULL, it gets the
+ * time from the request being out to the
+ * last reply byte. It is 0 when the reply
+ * came after a retry, since it could be an
+ * answer to an earlier try.
+ * Returns the error of the last try.
+ **/
+esk8_err_t esk8_uart_port_regread(
+
+    esk8_uart_port_t* port,
+    esk8_uart_addr_t dst_addr,
+    esk8_uart_reg_t reg,
+    size_t reg_size,
+    void* out_val,
+    int tries,
+    uint32_t timeout_us,
+    uint32_t* out_rtt_us
+
+);
+
+
+/**
+ * Listens to traffic between other devices,
+ * without sending anything, until `until_us`.
+ * Each valid frame goes to `cb`. Returns early
+ * once `esk8_uart_port_wake()` is called.
+ * The decoder is not reset, so a frame split
+ * over two listens is still heard.
+ **/
+esk8_err_t esk8_uart_port_listen(
+
+    esk8_uart_port_t* port,
+    int64_t until_us,
+    esk8_uart_frame_cb_t cb,
+    void* ctx
+
+);
+
+
+/**
+ * Makes a running `esk8_uart_port_listen()`
+ * return. May be called from any task. A
+ * wake up with nobody listening is dropped
+ * by the next read or listen.
+ **/
+void esk8_uart_port_wake(
+
+    esk8_uart_port_t* port
+
+);
+
+
+#endif /* _ESK8_UART_PORT_H */